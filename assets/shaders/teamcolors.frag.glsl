@@ -9,8 +9,9 @@
 //the unmodified texture itself
 uniform sampler2D texture;
 
-//the desired player number the final resulting colors
-uniform int player_number;
+//the desired player number the final resulting colors,
+//set per vertex as sprites of many players are drawn at once
+varying float player_number_v;
 
 //the alpha value which marks colors to be replaced
 uniform float alpha_marker;
@@ -43,6 +44,8 @@ bool is_color(vec4 c1, vec4 reference) {
 
 
 void main() {
+	int player_number = int(player_number_v + 0.5);
+
 	//get the texel from the uniform texture.
 	vec4 pixel = texture2D(texture, tex_position);
 
@@ -0,0 +1,30 @@
+//team color replacement vertex shader
+#version 120
+
+//modelview*projection matrix
+uniform mat4 mvp_matrix;
+
+//the position of this vertex
+attribute vec4 vertex_position;
+
+//the texture coordinates assigned to this vertex
+attribute vec2 tex_coordinates;
+
+//the player number of the sprite this vertex belongs to
+attribute float player_number;
+
+//interpolated texture coordinates sent to fragment shader
+varying vec2 tex_position;
+
+//player number sent to fragment shader, equal for all vertices of a sprite
+varying float player_number_v;
+
+void main(void) {
+	//transform the vertex coordinates
+	gl_Position = gl_ModelViewProjectionMatrix * vertex_position;
+
+	//pass the fix points for texture coordinates set at this vertex
+	tex_position = tex_coordinates;
+
+	player_number_v = player_number;
+}
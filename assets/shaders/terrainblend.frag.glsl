@@ -0,0 +1,36 @@
+#version 120
+
+//terrain blending shader
+//
+//draws a terrain tile and blends the masked tiles of its
+//neighbors over it, with the same result as drawing each
+//of them with the alpha masking shader.
+
+//the terrain texture (atlas page) of the base and all layers
+uniform sampler2D base_texture;
+
+//the blending masks of all layers
+uniform sampler2D mask_texture;
+
+varying vec2 base_tex_position;
+varying vec4 layer_position[4];
+varying float layers_used;
+
+void main()
+{
+	vec4 pixel = texture2D(base_texture, base_tex_position);
+
+	for (int i = 0; i < 4; i++) {
+		vec4 layer_pixel = texture2D(base_texture, layer_position[i].xy);
+		vec4 mask_pixel = texture2D(mask_texture, layer_position[i].zw);
+
+		//the alpha the alpha masking shader would produce,
+		//zero for the unused layers.
+		float used = step(float(i) + 0.5, layers_used);
+		float alpha = clamp(layer_pixel.a - (1.0 - mask_pixel.x), 0.0, 1.0) * used;
+
+		pixel.rgb = mix(pixel.rgb, layer_pixel.rgb, alpha);
+	}
+
+	gl_FragColor = pixel;
+}
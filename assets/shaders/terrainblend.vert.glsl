@@ -0,0 +1,33 @@
+//vertex shader for drawing terrain tiles blended with their neighbors
+#version 120
+
+//the position of this vertex
+attribute vec4 vertex_position;
+
+//texture coordinates of the base tile
+attribute vec2 base_tex_coordinates;
+
+//per blending layer: xy = layer texture coordinates, zw = mask coordinates.
+//the number of layers has to match renderer::max_blend_layers.
+attribute vec4 layer_coordinates0;
+attribute vec4 layer_coordinates1;
+attribute vec4 layer_coordinates2;
+attribute vec4 layer_coordinates3;
+
+//how many of the layers are used
+attribute float layer_count;
+
+varying vec2 base_tex_position;
+varying vec4 layer_position[4];
+varying float layers_used;
+
+void main(void) {
+	gl_Position = gl_ModelViewProjectionMatrix * vertex_position;
+
+	base_tex_position = base_tex_coordinates;
+	layer_position[0] = layer_coordinates0;
+	layer_position[1] = layer_coordinates1;
+	layer_position[2] = layer_coordinates2;
+	layer_position[3] = layer_coordinates3;
+	layers_used = layer_count;
+}
@@ -8,13 +8,16 @@
 #include <limits.h> /* for NAME_MAX */
 #endif
 
+#include "job/job_manager.h"
+#include "log.h"
 #include "util/error.h"
 
 namespace openage {
 
-AssetManager::AssetManager(util::Dir *root)
+AssetManager::AssetManager(util::Dir *root, job::JobManager *jobs)
 	:
-	root{root} {
+	root{root},
+	jobs{jobs} {
 
 	this->missing_tex = new Texture{root->join("missing.png"), false};
 
@@ -53,18 +56,23 @@ Texture *AssetManager::load_texture(const std::string &name) {
 
 		// return the big X texture instead
 		ret = this->missing_tex;
+	} else if (this->jobs != nullptr) {
+		ret = new Texture{filename, true, &this->atlas, this->missing_tex};
+		this->enqueue_decode(ret);
 	} else {
-		ret = new Texture{filename, true};
+		ret = new Texture{filename, true, &this->atlas};
+	}
 
 #if WITH_INOTIFY
+	if (ret != this->missing_tex) {
 		// create inotify update trigger for the requested file
 		int wd = inotify_add_watch(this->inotify_fd, filename.c_str(), IN_CLOSE_WRITE);
 		if (wd < 0) {
 			throw util::Error{"failed to add inotify watch for %s", filename.c_str()};
 		}
 		this->watch_fds[wd] = ret;
-#endif
 	}
+#endif
 
 	this->textures[filename] = ret;
 
@@ -108,7 +116,12 @@ void AssetManager::check_updates() {
 
 			if (event->mask & IN_CLOSE_WRITE) {
 				// TODO: this should invoke callback functions
-				this->watch_fds[event->wd]->reload();
+				Texture *tex = this->watch_fds[event->wd];
+				if (this->jobs != nullptr) {
+					this->enqueue_decode(tex);
+				} else {
+					tex->reload();
+				}
 			}
 
 			// move the buffer ptr to the next event.
@@ -118,4 +131,42 @@ void AssetManager::check_updates() {
 #endif
 }
 
+void AssetManager::enqueue_decode(Texture *tex) {
+	std::string filename = tex->get_filename();
+	std::function<texture_data()> decode = [filename]() {
+		return Texture::decode(filename, true);
+	};
+	this->pending.push_back({tex, this->jobs->enqueue<texture_data>(decode)});
+}
+
+size_t AssetManager::upload_decoded(size_t byte_budget) {
+	size_t uploaded_bytes = 0;
+	size_t done = 0;
+
+	// upload in request order, so the first requested textures appear first
+	for (; done < this->pending.size(); done++) {
+		pending_texture &p = this->pending[done];
+		if (not p.job.is_finished() or (done > 0 and uploaded_bytes >= byte_budget)) {
+			break;
+		}
+
+		try {
+			texture_data data = p.job.get_result();
+			uploaded_bytes += data.image_bytes();
+			p.texture->upload(std::move(data));
+		}
+		catch (util::Error &e) {
+			// the placeholder stays in place
+			log::err("failed to load texture %s: %s", p.texture->get_filename().c_str(), e.str());
+		}
+	}
+
+	this->pending.erase(this->pending.begin(), this->pending.begin() + done);
+	return this->pending.size();
+}
+
+size_t AssetManager::get_pending_count() const {
+	return this->pending.size();
+}
+
 }
@@ -7,18 +7,34 @@
 
 #include <unordered_map>
 #include <string>
+#include <vector>
 
+#include "job/job.h"
+#include "renderer/texture_atlas.h"
 #include "texture.h"
 
 namespace openage {
 
+namespace job {
+class JobManager;
+}
+
 /**
  * Container class for all available assets.
  * Responsible for loading, providing and updating requested files.
+ *
+ * When a job manager is given, image files are decoded by its workers,
+ * and the textures show the missing texture until upload_decoded()
+ * has uploaded them.
  */
 class AssetManager {
 public:
-	AssetManager(util::Dir *root);
+	/**
+	 * Default number of decoded image bytes uploaded per frame.
+	 */
+	static constexpr size_t default_upload_budget = 16 * 1024 * 1024;
+
+	AssetManager(util::Dir *root, job::JobManager *jobs = nullptr);
 	virtual ~AssetManager();
 
 	/**
@@ -42,12 +58,33 @@ public:
 	 */
 	void check_updates();
 
+	/**
+	 * Upload textures whose decoding has finished, in the order they
+	 * were requested, until byte_budget bytes of images were uploaded.
+	 * At least one texture is uploaded if any is ready.
+	 * Must be called with the gl context current.
+	 *
+	 * @returns the number of textures still waiting for upload.
+	 */
+	size_t upload_decoded(size_t byte_budget = default_upload_budget);
+
+	/**
+	 * The number of textures still waiting for upload.
+	 */
+	size_t get_pending_count() const;
+
 protected:
 	/**
 	 * Create an internal texture handle.
 	 */
 	Texture *load_texture(const std::string &name);
 
+	/**
+	 * Decode the file of the texture on the job manager,
+	 * and upload it later in upload_decoded.
+	 */
+	void enqueue_decode(Texture *tex);
+
 private:
 	/**
 	 * The root directory for the available assets.
@@ -55,10 +92,36 @@ private:
 	util::Dir *root;
 
 	/**
-	 * The replacement texture for missing textures.
+	 * Workers for decoding image files, or nullptr to decode
+	 * them when they are requested.
+	 */
+	job::JobManager *jobs;
+
+	/**
+	 * The replacement texture for missing textures,
+	 * also shown while textures are being decoded.
 	 */
 	Texture *missing_tex;
 
+	/**
+	 * A texture whose image is being decoded.
+	 */
+	struct pending_texture {
+		Texture *texture;
+		job::Job<texture_data> job;
+	};
+
+	/**
+	 * Decode jobs in the order they were started.
+	 */
+	std::vector<pending_texture> pending;
+
+	/**
+	 * The atlas where the loaded textures are packed into,
+	 * so sprites of different files can be drawn in one batch.
+	 */
+	renderer::TextureAtlas atlas;
+
 	/**
 	 * Map from texture filename to texture instance ptr.
 	 */
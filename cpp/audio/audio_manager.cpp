@@ -2,6 +2,8 @@
 
 #include "audio_manager.h"
 
+#include <algorithm>
+#include <chrono>
 #include <cstring>
 #include <SDL2/SDL.h>
 #include <sstream>
@@ -17,6 +19,8 @@ namespace audio {
 
 void global_audio_callback(void *userdata, uint8_t *stream, int len);
 
+const std::string AudioManager::null_device = "null";
+
 AudioManager::AudioManager(int freq, SDL_AudioFormat format, uint8_t channels,
 		uint16_t samples)
 		:
@@ -26,12 +30,24 @@ AudioManager::AudioManager(int freq, SDL_AudioFormat format, uint8_t channels,
 AudioManager::AudioManager(const std::string &device_name, int freq,
 		SDL_AudioFormat format, Uint8 channels, Uint16 samples)
 		:
-		device_name{device_name} {
-
-	if (SDL_Init(SDL_INIT_AUDIO) < 0) {
-		throw util::Error("SDL audio initialization: %s", SDL_GetError());
-	} else {
-		log::msg("initialized SDL audio subsystems.");
+		device_name{device_name},
+		resource_voice_limit{default_resource_voice_limit},
+		listener{0, 0, 0},
+		sample_cache{default_sample_cache_budget},
+		commands{command_queue_size},
+		// every returned reference was sent with a command, so this can
+		// hold the sounds of all queued commands and all playing sounds
+		returned_sounds{command_queue_size + 4 * max_playing_sounds},
+		mix_resource_voice_limit{default_resource_voice_limit},
+		mix_listener{0, 0, 0},
+		voice_counter{0} {
+
+	// the mixer writes native 16 bit stereo, so SDL never has to convert
+	// the format. only the sample rate may be changed to the device's own,
+	// the resources are converted to it when they are decoded.
+	if (format != AUDIO_S16SYS || channels != 2) {
+		throw util::Error{"Unsupported audio output format: format=%d, channels=%d",
+				static_cast<int>(format), static_cast<int>(channels)};
 	}
 
 	//set desired audio output format
@@ -44,43 +60,88 @@ AudioManager::AudioManager(const std::string &device_name, int freq,
 	desired_spec.callback = global_audio_callback;
 	desired_spec.userdata = this;
 
-	// convert device name to valid parameter for sdl call
-	// if the device name is empty, use a nullptr in order to indicate that the
-	// default device should be used
-	const char *c_device_name = device_name.empty() ?
-			nullptr : device_name.c_str();
-	// open audio playback device
-	device_id = SDL_OpenAudioDevice(c_device_name, 0, &desired_spec,
-			&device_spec, 0);
-	// no device could be opened
-	if (device_id == 0) {
-		throw util::Error{"Error opening audio device: %s", SDL_GetError()};
+	if (device_name == null_device) {
+		// the owner calls audio_callback with the desired format
+		device_spec = desired_spec;
+		device_id = 0;
+	} else {
+		if (SDL_Init(SDL_INIT_AUDIO) < 0) {
+			throw util::Error("SDL audio initialization: %s", SDL_GetError());
+		} else {
+			log::msg("initialized SDL audio subsystems.");
+		}
+
+		// convert device name to valid parameter for sdl call
+		// if the device name is empty, use a nullptr in order to indicate that the
+		// default device should be used
+		const char *c_device_name = device_name.empty() ?
+				nullptr : device_name.c_str();
+		// open audio playback device
+		device_id = SDL_OpenAudioDevice(c_device_name, 0, &desired_spec,
+				&device_spec, SDL_AUDIO_ALLOW_FREQUENCY_CHANGE);
+		// no device could be opened
+		if (device_id == 0) {
+			throw util::Error{"Error opening audio device: %s", SDL_GetError()};
+		}
 	}
 
 	// initialize playing sounds vectors
-	using sound_vector = std::vector<std::shared_ptr<SoundImpl>>;
+	using sound_vector = std::vector<playing_sound>;
 	playing_sounds.insert({category_t::GAME, sound_vector{}});
 	playing_sounds.insert({category_t::INTERFACE, sound_vector{}});
 	playing_sounds.insert({category_t::MUSIC, sound_vector{}});
 	playing_sounds.insert({category_t::TAUNT, sound_vector{}});
 
+	// unit sounds may be started by hundreds of units at once,
+	// while only few sounds of the other categories overlap
+	voice_limits.insert({category_t::GAME, 48});
+	voice_limits.insert({category_t::INTERFACE, 16});
+	voice_limits.insert({category_t::MUSIC, 4});
+	voice_limits.insert({category_t::TAUNT, 8});
+
+	for (auto &entry : playing_sounds) {
+		entry.second.reserve(max_playing_sounds);
+		category_volumes.insert({entry.first, 256});
+		mix_category_volumes.insert({entry.first, 256});
+		mix_voice_limits.insert({entry.first, voice_limits.find(entry.first)->second});
+	}
+
 	mix_buffer.reset(new int32_t[4 * device_spec.samples *
 			device_spec.channels]);
+	bus_buffer.reset(new int32_t[4 * device_spec.samples *
+			device_spec.channels]);
+
+	if (device_spec.freq != freq) {
+		log::msg("Audio device runs at %d Hz instead of %d Hz, converting resources", device_spec.freq, freq);
+	}
+
+	mixer = &get_mix_functions();
+	log::msg("Using %s audio mixing", mixer->name);
 
 	log::msg("Using audio device '%s' [freq=%d,format=%d,channels=%d,samples=%d]",
 			device_name.empty() ? "default" : device_name.c_str(),
 			device_spec.freq, device_spec.format, device_spec.channels,
 			device_spec.samples);
 
-	SDL_PauseAudioDevice(device_id, 0);
+	if (device_id != 0) {
+		SDL_PauseAudioDevice(device_id, 0);
+	}
 }
 
 AudioManager::~AudioManager() {
-	SDL_CloseAudioDevice(device_id);
+	if (device_id != 0) {
+		SDL_CloseAudioDevice(device_id);
+	}
 }
 
 void AudioManager::load_resources(const util::Dir &asset_dir,
-                                  const std::vector<gamedata::sound_file> &sound_files) {
+                                  const std::vector<gamedata::sound_file> &sound_files,
+                                  job::JobManager *jobs, bool lazy) {
+	auto start = std::chrono::steady_clock::now();
+
+	// creating the resources doesn't read the files yet
+	std::vector<std::shared_ptr<Resource>> created;
+	created.reserve(sound_files.size());
 	for (auto &sound_file : sound_files) {
 		auto category = from_category(sound_file.category);
 		auto id = sound_file.sound_id;
@@ -90,11 +151,37 @@ void AudioManager::load_resources(const util::Dir &asset_dir,
 		auto loader_policy = from_loader_policy(sound_file.loader_policy);
 
 		auto key = std::make_tuple(category, id);
-		auto resource = Resource::create_resource(category, id, path, format, loader_policy);
+		auto resource = Resource::create_resource(category, id, path, format, loader_policy, &stream_worker, &sample_cache, device_spec.freq);
 
 		// TODO check resource already existing
 		resources.insert({key, resource});
+		created.push_back(std::move(resource));
+	}
+
+	if (lazy) {
+		return;
 	}
+
+	// decoding one file takes long enough to give each its own batch
+	auto load = [&created](size_t i) {
+		created[i]->load();
+	};
+	if (jobs != nullptr) {
+		jobs->parallel_for(created.size(), load, 1);
+	} else {
+		for (size_t i = 0; i < created.size(); i++) {
+			load(i);
+		}
+	}
+
+	auto end = std::chrono::steady_clock::now();
+	log::msg("Loaded %zu audio resources in %.1f ms", created.size(),
+			std::chrono::duration<double, std::milli>(end - start).count());
+}
+
+void AudioManager::add_resource(std::shared_ptr<Resource> resource) {
+	auto key = std::make_tuple(resource->get_category(), resource->get_id());
+	resources[key] = std::move(resource);
 }
 
 Sound AudioManager::get_sound(category_t category, int id) {
@@ -103,78 +190,365 @@ Sound AudioManager::get_sound(category_t category, int id) {
 		throw util::Error{"sound resource does not exist: category=%d, id=%d", static_cast<int>(category), id};
 	}
 
+	// resources loaded lazily are read when they are first requested
+	resource->second->load();
+
 	auto sound_impl = std::make_shared<SoundImpl>(resource->second);
 	return Sound{this, sound_impl};
 }
 
-void remove_from_vector(std::vector<std::shared_ptr<SoundImpl>> &v, size_t i) {
+/**
+ * Removes an element by moving the last one into its place.
+ */
+template <class T>
+void remove_from_vector(std::vector<T> &v, size_t i) {
 	// current sound is the last in the list, so just remove it
 	if (i == v.size()-1) {
 		v.pop_back();
 	// current sound is in the middle of the list, so it will be
 	// exchanged with the last sound and the removed
 	} else {
-		v[i] = v.back();
+		v[i] = std::move(v.back());
 		v.pop_back();
 	}
 }
 
-void AudioManager::audio_callback(int16_t *stream, int length) {
-	std::memset(mix_buffer.get(), 0, length*4);
+void AudioManager::set_category_volume(category_t category, int32_t volume) {
+	category_volumes.find(category)->second = volume;
+	send_command({audio_command::type_t::CATEGORY_VOLUME, nullptr, category, volume, false, 0, 0, false, {0, 0, 0}});
+}
 
-	// iterate over all categories
-	for (auto &entry : playing_sounds) {
-		auto &playing_list = entry.second;
-		// iterate over all sounds in one category
-		for (size_t i = 0; i < playing_list.size(); i++) {
-			auto &sound = playing_list[i];
-			auto sound_finished = sound->mix_audio(mix_buffer.get(), length);
-			// if the sound is finished, it should be removed from the playing
-			// list
-			if (sound_finished) {
-				remove_from_vector(playing_list, i);
-				i--;
+int32_t AudioManager::get_category_volume(category_t category) const {
+	return category_volumes.find(category)->second;
+}
+
+void AudioManager::set_voice_limit(category_t category, uint32_t voices) {
+	voices = std::min<uint32_t>(voices, max_playing_sounds);
+	voice_limits.find(category)->second = voices;
+	send_command({audio_command::type_t::VOICE_LIMIT, nullptr, category, 0, false, 0, voices, false, {0, 0, 0}});
+}
+
+uint32_t AudioManager::get_voice_limit(category_t category) const {
+	return voice_limits.find(category)->second;
+}
+
+void AudioManager::set_resource_voice_limit(uint32_t voices) {
+	voices = std::min<uint32_t>(voices, max_playing_sounds);
+	resource_voice_limit = voices;
+	send_command({audio_command::type_t::RESOURCE_VOICE_LIMIT, nullptr, category_t::GAME, 0, false, 0, voices, false, {0, 0, 0}});
+}
+
+uint32_t AudioManager::get_resource_voice_limit() const {
+	return resource_voice_limit;
+}
+
+void AudioManager::set_listener(const coord::phys3 &position) {
+	// the camera stands still most of the time
+	if (position == listener) {
+		return;
+	}
+	listener = position;
+	send_command({audio_command::type_t::LISTENER, nullptr, category_t::GAME, 0, false, 0, 0, false, position});
+}
+
+coord::phys3 AudioManager::get_listener() const {
+	return listener;
+}
+
+void AudioManager::set_stream_read_ahead(uint32_t chunks) {
+	stream_worker.set_read_ahead(chunks);
+}
+
+uint64_t AudioManager::get_underrun_count() const {
+	return stream_worker.get_underrun_count();
+}
+
+SampleCache &AudioManager::get_sample_cache() {
+	return sample_cache;
+}
+
+void AudioManager::send_command(audio_command &&command) {
+	if (command.sound) {
+		command.sound->commands_sent++;
+	}
+
+	collect_returned_sounds();
+
+	// keep the order if commands are already waiting
+	if (!overflow_commands.empty() || !commands.push(std::move(command))) {
+		overflow_commands.push_back(std::move(command));
+	}
+}
+
+bool AudioManager::start_resource(const Resource *resource) {
+	return started_resources.insert(resource).second;
+}
+
+void AudioManager::update() {
+	collect_returned_sounds();
+	started_resources.clear();
+}
+
+void AudioManager::collect_returned_sounds() {
+	returned_sound entry;
+	while (returned_sounds.pop(&entry)) {
+		auto &sound = *entry.sound;
+
+		// only if no later command is on its way, the state is final
+		if (entry.commands_seen == sound.commands_sent && !entry.mixing) {
+			sound.playing = false;
+			if (sound.release_pending) {
+				sound.release_resource();
+				sound.release_pending = false;
 			}
 		}
+
+		// the last reference may be dropped here, on the game thread
+		entry.sound.reset();
 	}
 
-	// write the mix buffer to the output stream and adjust volume
-	for (int i = 0; i < length; i++) {
-		auto value = mix_buffer[i]/256;
-		if (value > 32767) {
-			value = 32767;
-		} else if (value < -32768) {
-			value = -32768;
-		}
-		stream[i] = static_cast<int16_t>(value);
+	while (!overflow_commands.empty() && commands.push(std::move(overflow_commands.front()))) {
+		overflow_commands.pop_front();
 	}
 }
 
-void AudioManager::add_sound(std::shared_ptr<SoundImpl> sound) {
-	SDL_LockAudioDevice(device_id);
+void AudioManager::process_commands() {
+	audio_command command;
+
+	// every command returns at most one sound reference
+	while (!returned_sounds.full() && commands.pop(&command)) {
+		using type_t = audio_command::type_t;
+
+		if (command.type == type_t::CATEGORY_VOLUME) {
+			mix_category_volumes.find(command.category)->second = command.volume;
+			continue;
+		} else if (command.type == type_t::VOICE_LIMIT) {
+			mix_voice_limits.find(command.category)->second = command.voices;
+			continue;
+		} else if (command.type == type_t::RESOURCE_VOICE_LIMIT) {
+			mix_resource_voice_limit = command.voices;
+			continue;
+		} else if (command.type == type_t::LISTENER) {
+			mix_listener = command.position;
+			continue;
+		}
+
+		auto sound = command.sound.get();
+		sound->commands_seen++;
+
+		auto &playing_list = playing_sounds.find(sound->get_category())->second;
+		playing_sound *current = nullptr;
+		for (auto &entry : playing_list) {
+			if (entry.sound.get() == sound) {
+				current = &entry;
+				break;
+			}
+		}
+
+		switch (command.type) {
+		case type_t::PLAY:
+			sound->offset = 0;
+			if (sound->stream) {
+				sound->stream->restart();
+			}
+			// fall through
+		case type_t::RESUME:
+			sound->mix_volume = command.volume;
+			sound->mix_looping = command.looping;
+			sound->mix_priority = command.priority;
+			sound->mix_positional = command.positional;
+			sound->mix_position = command.position;
+			// a new voice competes with its gain at the listener
+			sound->update_gain(mix_listener);
+			if (current != nullptr && !current->stopped) {
+				break;
+			}
+			// a voice taken from the list keeps the pointers valid,
+			// it is only marked as stopped
+			if (!make_voice_available(playing_list, sound)) {
+				current = nullptr;
+				break;
+			}
+			sound->voice_index = voice_counter++;
+			if (current != nullptr) {
+				current->stopped = false;
+			} else if (playing_list.size() < max_playing_sounds) {
+				playing_list.push_back({std::move(command.sound), false});
+				current = &playing_list.back();
+			} else {
+				// the list is full, but as the voice limit is at most its
+				// size, a stopped voice waits there: at least the stolen one.
+				// it is handed back now, in place of the command's sound.
+				for (auto &entry : playing_list) {
+					if (entry.stopped) {
+						auto commands_seen = entry.sound->commands_seen;
+						returned_sounds.push({std::move(entry.sound), commands_seen, false});
+						entry = {std::move(command.sound), false};
+						current = &entry;
+						break;
+					}
+				}
+			}
+			break;
+		case type_t::STOP:
+			sound->offset = 0;
+			if (sound->stream) {
+				sound->stream->restart();
+			}
+			// fall through
+		case type_t::PAUSE:
+			if (current != nullptr) {
+				current->stopped = true;
+			}
+			break;
+		case type_t::VOLUME:
+			sound->mix_volume = command.volume;
+			break;
+		case type_t::LOOPING:
+			sound->mix_looping = command.looping;
+			break;
+		case type_t::POSITION:
+			sound->mix_positional = command.positional;
+			sound->mix_position = command.position;
+			break;
+		default:
+			break;
+		}
 
-	auto category = sound->get_category();
-	auto &playing_list = playing_sounds.find(category)->second;
-	// TODO probably check if sound already exists in playing list
-	playing_list.push_back(sound);
+		// hand back the reference, unless it's kept in the playing list
+		if (command.sound) {
+			bool mixing = (current != nullptr && !current->stopped);
+			returned_sounds.push({std::move(command.sound), sound->commands_seen, mixing});
+		}
+	}
+}
 
-	SDL_UnlockAudioDevice(device_id);
+/**
+ * Returns whether voice a should be stolen before voice b. Virtual voices
+ * come first, as nobody hears them.
+ */
+static bool weaker_voice(const SoundImpl *a, const SoundImpl *b) {
+	int32_t a_volume = a->get_audible_volume();
+	int32_t b_volume = b->get_audible_volume();
+	if ((a_volume == 0) != (b_volume == 0)) {
+		return a_volume == 0;
+	}
+	if (a->mix_priority != b->mix_priority) {
+		return a->mix_priority < b->mix_priority;
+	}
+	if (a_volume != b_volume) {
+		return a_volume < b_volume;
+	}
+	return a->voice_index < b->voice_index;
 }
 
-void AudioManager::remove_sound(std::shared_ptr<SoundImpl> sound) {
-	SDL_LockAudioDevice(device_id);
+bool AudioManager::make_voice_available(std::vector<playing_sound> &playing_list, const SoundImpl *sound) {
+	uint32_t category_voices = 0;
+	uint32_t resource_voices = 0;
+	playing_sound *weakest = nullptr;
+	playing_sound *weakest_of_resource = nullptr;
 
-	auto category = sound->get_category();
-	auto &playing_list = playing_sounds.find(category)->second;
+	for (auto &entry : playing_list) {
+		if (entry.stopped) {
+			continue;
+		}
+		category_voices++;
+		if (weakest == nullptr || weaker_voice(entry.sound.get(), weakest->sound.get())) {
+			weakest = &entry;
+		}
+		if (entry.sound->resource == sound->resource) {
+			resource_voices++;
+			if (weakest_of_resource == nullptr || weaker_voice(entry.sound.get(), weakest_of_resource->sound.get())) {
+				weakest_of_resource = &entry;
+			}
+		}
+	}
 
-	for (size_t i = 0; i < playing_list.size(); i++) {
-		if (playing_list[i] == sound) {
+	// a voice of the same resource is taken first, it sounds the same
+	playing_sound *victim;
+	if (resource_voices >= mix_resource_voice_limit) {
+		victim = weakest_of_resource;
+	} else if (category_voices >= mix_voice_limits.find(sound->get_category())->second) {
+		victim = weakest;
+	} else {
+		return true;
+	}
+
+	// at equal priority, the new sound replaces the older one.
+	// a virtual voice is given up for any sound
+	if (victim == nullptr ||
+	    (victim->sound->get_audible_volume() != 0 &&
+	     victim->sound->mix_priority > sound->mix_priority)) {
+		return false;
+	}
+
+	// the stolen voice is handed back like a finished sound
+	victim->stopped = true;
+	return true;
+}
+
+void AudioManager::return_stopped_sounds() {
+	for (auto &entry : playing_sounds) {
+		auto &playing_list = entry.second;
+		for (size_t i = 0; i < playing_list.size(); i++) {
+			if (!playing_list[i].stopped) {
+				continue;
+			}
+
+			auto commands_seen = playing_list[i].sound->commands_seen;
+			returned_sound returned{std::move(playing_list[i].sound), commands_seen, false};
+			if (!returned_sounds.push(std::move(returned))) {
+				// the game thread is behind, try again next time
+				playing_list[i].sound = std::move(returned.sound);
+				return;
+			}
 			remove_from_vector(playing_list, i);
-			break;
+			i--;
 		}
 	}
+}
+
+void AudioManager::audio_callback(int16_t *stream, int length) {
+	process_commands();
+	return_stopped_sounds();
+
+	std::memset(mix_buffer.get(), 0, length*4);
 
-	SDL_UnlockAudioDevice(device_id);
+	// iterate over all categories
+	for (auto &entry : playing_sounds) {
+		auto &playing_list = entry.second;
+
+		// the category's sounds are mixed on their own bus,
+		// so its volume is applied only once per sample.
+		// the bus is only cleared and added if a sound is audible.
+		bool bus_used = false;
+
+		// iterate over all sounds in one category
+		for (auto &playing : playing_list) {
+			if (playing.stopped) {
+				continue;
+			}
+			playing.sound->update_gain(mix_listener);
+			if (!bus_used && playing.sound->get_audible_volume() != 0) {
+				std::memset(bus_buffer.get(), 0, length*4);
+				bus_used = true;
+			}
+			// if the sound is finished, it is handed back to the game thread
+			if (playing.sound->mix_audio(bus_buffer.get(), length)) {
+				playing.stopped = true;
+			}
+		}
+
+		if (bus_used) {
+			auto volume = mix_category_volumes.find(entry.first)->second;
+			mixer->add_bus(mix_buffer.get(), bus_buffer.get(), length, volume);
+		}
+	}
+
+	return_stopped_sounds();
+
+	// write the mix buffer to the output stream and adjust volume
+	mixer->saturate(stream, mix_buffer.get(), length);
 }
 
 SDL_AudioSpec AudioManager::get_device_spec() const {
@@ -3,17 +3,24 @@
 #ifndef OPENAGE_AUDIO_AUDIO_MANAGER_H_
 #define OPENAGE_AUDIO_AUDIO_MANAGER_H_
 
+#include <deque>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include <SDL2/SDL.h>
 
 #include "category.h"
 #include "hash_functions.h"
+#include "mix.h"
+#include "positional.h"
 #include "resource.h"
 #include "sound.h"
+#include "stream.h"
+#include "../datastructure/spsc_queue.h"
+#include "../job/job_manager.h"
 #include "../util/dir.h"
 
 #include "../gamedata/sound_file.gen.h"
@@ -21,8 +28,83 @@
 namespace openage {
 namespace audio {
 
+/**
+ * A change of the playing sounds, sent from the game thread to the audio
+ * callback.
+ */
+struct audio_command {
+	enum class type_t {
+		PLAY,
+		RESUME,
+		PAUSE,
+		STOP,
+		VOLUME,
+		LOOPING,
+		CATEGORY_VOLUME,
+		VOICE_LIMIT,
+		RESOURCE_VOICE_LIMIT,
+		POSITION,
+		LISTENER
+	};
+
+	type_t type;
+	/**
+	 * The affected sound, empty for category commands.
+	 */
+	std::shared_ptr<SoundImpl> sound;
+	/**
+	 * The affected category, only used by category commands and voice limits.
+	 */
+	category_t category;
+	/**
+	 * The new volume, also sent to play and resume.
+	 */
+	int32_t volume;
+	/**
+	 * Whether to loop, also sent to play and resume.
+	 */
+	bool looping;
+	/**
+	 * The sound's priority, sent to play and resume.
+	 */
+	int32_t priority;
+	/**
+	 * The new number of voices, only used by voice limits.
+	 */
+	uint32_t voices;
+	/**
+	 * Whether the sound is positional, sent to play and resume.
+	 */
+	bool positional;
+	/**
+	 * The sound's new position, also sent to play and resume, or the
+	 * listener's new position.
+	 */
+	coord::phys3 position;
+};
+
 /*
  * This class provides audio functionality.
+ *
+ * The game thread controls sounds by sending commands to the audio
+ * callback through a lock-free queue, which the callback drains before
+ * mixing. Neither thread ever waits for the other. The callback doesn't
+ * free memory either: every sound reference it receives is handed back
+ * to the game thread in update().
+ *
+ * The number of voices mixed at once is limited per category and per
+ * resource. A sound started beyond a limit steals the voice of the weakest
+ * sound, that is a virtual one (see below), then the one with the lowest
+ * priority, then the quietest, then the oldest. If all of them are audible
+ * and have a higher priority, the new sound is not played. Starting a
+ * resource that was already started since the last update() doesn't add
+ * a voice either, as it would only be louder.
+ *
+ * Positional sounds are panned and attenuated by their distance to the
+ * listener, which follows the camera. Sounds out of hearing range are
+ * virtual voices: they keep their playing position and their voice, but
+ * aren't mixed, and they are the first ones to be stolen, whatever their
+ * priority. A category without audible voices costs no mixing at all.
  */
 class AudioManager {
 private:
@@ -35,14 +117,105 @@ private:
 	SDL_AudioDeviceID device_id;
 
 	std::unique_ptr<int32_t[]> mix_buffer;
+	// the sounds of one category are mixed here, before the category's
+	// volume is applied and they are added to the mix buffer
+	std::unique_ptr<int32_t[]> bus_buffer;
+
+	// the mixing kernels for this cpu
+	const mix_functions *mixer;
+
+	// the category volumes set by the game thread
+	std::unordered_map<category_t,int32_t> category_volumes;
+	// the voice limits set by the game thread
+	std::unordered_map<category_t,uint32_t> voice_limits;
+	uint32_t resource_voice_limit;
+
+	// the listener position set by the game thread
+	coord::phys3 listener;
+
+	// the resources started since the last update, only used by the
+	// game thread
+	std::unordered_set<const Resource*> started_resources;
+
+	// the decoded data of resources, shared by all of them
+	SampleCache sample_cache;
+
+	// decodes the streams of dynamic resources, and of in memory
+	// resources whose data isn't cached
+	StreamWorker stream_worker;
 
 	std::unordered_map<std::tuple<category_t,int>,std::shared_ptr<Resource>>
 			resources;
 
-	std::unordered_map<category_t,std::vector<std::shared_ptr<SoundImpl>>>
+	/**
+	 * A sound reference handed back to the game thread by the callback.
+	 */
+	struct returned_sound {
+		std::shared_ptr<SoundImpl> sound;
+		/** SoundImpl::commands_seen when it was returned */
+		uint32_t commands_seen;
+		/** whether the callback still mixes the sound */
+		bool mixing;
+	};
+
+	/**
+	 * A sound in the playing lists of the callback.
+	 */
+	struct playing_sound {
+		std::shared_ptr<SoundImpl> sound;
+		/** the sound has stopped and waits to be handed back */
+		bool stopped;
+	};
+
+	// game thread to callback
+	datastructure::SPSCQueue<audio_command> commands;
+	// callback to game thread
+	datastructure::SPSCQueue<returned_sound> returned_sounds;
+
+	// commands that didn't fit the queue, only used by the game thread
+	std::deque<audio_command> overflow_commands;
+
+	// only used by the callback, the lists never grow beyond
+	// max_playing_sounds, so they don't allocate
+	std::unordered_map<category_t,std::vector<playing_sound>>
 			playing_sounds;
+	std::unordered_map<category_t,int32_t> mix_category_volumes;
+	std::unordered_map<category_t,uint32_t> mix_voice_limits;
+	uint32_t mix_resource_voice_limit;
+	coord::phys3 mix_listener;
+	// counts the started voices, to find the oldest one
+	uint64_t voice_counter;
 
 public:
+	/**
+	 * The maximum number of sounds playing at once in each category. More
+	 * sounds are ignored until others have stopped. Voice limits are
+	 * capped to this.
+	 */
+	static constexpr size_t max_playing_sounds = 256;
+
+	/**
+	 * The number of bytes of decoded audio that are cached by default.
+	 */
+	static constexpr size_t default_sample_cache_budget = 64 * 1024 * 1024;
+
+	/**
+	 * The number of voices a resource may play at once by default.
+	 */
+	static constexpr uint32_t default_resource_voice_limit = 4;
+
+	/**
+	 * The number of commands that can be queued for the callback. More
+	 * commands are kept on the game thread until there is space.
+	 */
+	static constexpr size_t command_queue_size = 1024;
+
+	/**
+	 * The device name that opens no SDL device. The audio callback is then
+	 * driven by the owner, e.g. by a NullAudioDevice.
+	 */
+	static const std::string null_device;
+
 	AudioManager(int freq, SDL_AudioFormat format, uint8_t channels,
 			uint16_t samples);
 
@@ -62,18 +235,107 @@ public:
 
 	/**
 	 * Loads all audio resources, that are specified in the sound_files vector.
+	 * The files are read in parallel by the job manager's workers and the
+	 * calling thread. If lazy is set, the files are only read when a sound of
+	 * them is requested by get_sound. Resources decoded beyond the sample
+	 * cache's budget are evicted again, and streamed when they are played.
 	 * @param sound_files a list of all sound resources
+	 * @param jobs the workers to load with, may be nullptr
+	 * @param lazy whether to defer reading the files until they are used
+	 */
+	void load_resources(const util::Dir &asset_dir,
+			const std::vector<gamedata::sound_file> &sound_files,
+			job::JobManager *jobs=nullptr, bool lazy=false);
+
+	/**
+	 * Adds a resource that isn't read from a sound file, e.g. generated
+	 * audio. It replaces a resource with the same category and id.
 	 */
-	void load_resources(const util::Dir &asset_dir, const std::vector<gamedata::sound_file> &sound_files);
+	void add_resource(std::shared_ptr<Resource> resource);
 
 	/**
 	 * Returns a sound object with the given category and the given id. If no
-	 * such sound exists an Error will be thrown.
+	 * such sound exists or it can't be loaded, an Error will be thrown.
 	 * @param category the sound's category
 	 * @param id the sound's id
 	 */
 	Sound get_sound(category_t category, int id);
 
+	/**
+	 * Sets the volume of all sounds of a category. Like the sound volume, it
+	 * should be in range [0,256], where 256 is the original volume.
+	 * @param category the category to change
+	 * @param volume the new volume
+	 */
+	void set_category_volume(category_t category, int32_t volume);
+
+	/**
+	 * Returns the volume of a category.
+	 */
+	int32_t get_category_volume(category_t category) const;
+
+	/**
+	 * Sets how many sounds of a category are mixed at once.
+	 * @param category the category to change
+	 * @param voices the new limit, at most max_playing_sounds
+	 */
+	void set_voice_limit(category_t category, uint32_t voices);
+
+	/**
+	 * Returns how many sounds of a category are mixed at once.
+	 */
+	uint32_t get_voice_limit(category_t category) const;
+
+	/**
+	 * Sets how many sounds of the same resource are mixed at once.
+	 * @param voices the new limit, at most max_playing_sounds
+	 */
+	void set_resource_voice_limit(uint32_t voices);
+
+	/**
+	 * Returns how many sounds of the same resource are mixed at once.
+	 */
+	uint32_t get_resource_voice_limit() const;
+
+	/**
+	 * Sets the position positional sounds are heard from. Call this with
+	 * the camera position, e.g. once per tick.
+	 */
+	void set_listener(const coord::phys3 &position);
+
+	/**
+	 * Returns the position positional sounds are heard from.
+	 */
+	coord::phys3 get_listener() const;
+
+	/**
+	 * Sets how many chunks of dynamic resources are decoded ahead of the
+	 * playing position. Applies to sounds started afterwards.
+	 */
+	void set_stream_read_ahead(uint32_t chunks);
+
+	/**
+	 * Returns how often a streamed sound was not decoded in time, and
+	 * was silent for the rest of an audio callback.
+	 */
+	uint64_t get_underrun_count() const;
+
+	/**
+	 * Returns the cache of decoded audio, e.g. to change its budget or to
+	 * report its size.
+	 */
+	SampleCache &get_sample_cache();
+
+	/**
+	 * Takes back the sounds the callback is done with, and updates their
+	 * playing state. Call this once per tick from the game thread.
+	 */
+	void update();
+
+	/**
+	 * Mixes the playing sounds into the output stream.
+	 * @param length the number of int16_t values to write
+	 */
 	void audio_callback(int16_t *stream, int length);
 
 	/**
@@ -82,11 +344,43 @@ public:
 	SDL_AudioSpec get_device_spec() const;
 
 private:
-	void add_sound(std::shared_ptr<SoundImpl> sound);
-	void remove_sound(std::shared_ptr<SoundImpl> sound);
+	/**
+	 * Queues a command for the callback, from the game thread.
+	 */
+	void send_command(audio_command &&command);
+
+	/**
+	 * Returns whether a sound of the resource may be started, that is if
+	 * it wasn't already started since the last update. From the game thread.
+	 */
+	bool start_resource(const Resource *resource);
+
+	/**
+	 * Takes back the sounds the callback is done with, and queues the
+	 * commands that didn't fit before, from the game thread.
+	 */
+	void collect_returned_sounds();
+
+	/**
+	 * Applies the queued commands, from the callback.
+	 */
+	void process_commands();
+
+	/**
+	 * Makes room for a new voice of the sound in the playing list by
+	 * stopping the weakest voice, if a voice limit is reached. Returns
+	 * false if the sound is weaker than all voices it could take, from
+	 * the callback.
+	 */
+	bool make_voice_available(std::vector<playing_sound> &playing_list, const SoundImpl *sound);
+
+	/**
+	 * Hands the stopped sounds back to the game thread, from the callback.
+	 */
+	void return_stopped_sounds();
 
-	// Sound is the AudioManager's friend, so that only sounds can access the
-	// add and remove sound method's
+	// Sound is the AudioManager's friend, so that only sounds can send
+	// commands
 	friend class Sound;
 
 // static functions
@@ -15,6 +15,10 @@ DynamicLoader::DynamicLoader(const std::string &path)
 		path{path} {
 }
 
+const std::string &DynamicLoader::get_path() const {
+	return path;
+}
+
 std::unique_ptr<DynamicLoader> DynamicLoader::create(const std::string &path,
 		format_t format) {
 	std::unique_ptr<DynamicLoader> loader;
@@ -42,54 +46,65 @@ OpusDynamicLoader::OpusDynamicLoader(const std::string &path)
 	// open opus file
 	auto op_file = open_opus_file();
 
-	// read channels from the opus file
-	channels = op_channel_count(op_file.get(), -1);
+	// read channels from the opus file, mono stays mono
+	channels = (op_channel_count(op_file.get(), -1) == 1) ? 1 : 2;
 
-	length = op_pcm_total(op_file.get(), -1) * 2;
-	log::msg("Create dynamic opus loader: len=%d, chan=%d", length, channels);
+	length = op_pcm_total(op_file.get(), -1) * channels;
+	log::dbg("Create dynamic opus loader: len=%d, chan=%d", length, channels);
 }
 
 uint32_t OpusDynamicLoader::get_length() {
 	return length;
 }
 
-pcm_chunk_t OpusDynamicLoader::load_chunk(uint32_t offset, uint32_t chunk_size) {
-	// if the requested offset is greater than the resource's length, there is
-	// no chunk left to load
-	if (offset > length) {
-		return {};
+uint32_t OpusDynamicLoader::get_channels() {
+	return channels;
+}
+
+std::unique_ptr<DynamicDecoder> OpusDynamicLoader::open_decoder() {
+	return std::unique_ptr<DynamicDecoder>{new OpusDynamicDecoder{open_opus_file(), path, channels}};
+}
+
+opus_file_t OpusDynamicLoader::open_opus_file() {
+	int op_err;
+	opus_file_t op_file{op_open_file(path.c_str(), &op_err), opus_deleter};
+	if (op_err != 0) {
+		throw util::Error{"Could not open: %s", path.c_str()};
 	}
+	return std::move(op_file);
+}
 
-	// open opus file
-	auto op_file = open_opus_file();
+OpusDynamicDecoder::OpusDynamicDecoder(opus_file_t &&op_file, const std::string &path,
+		uint32_t channels)
+		:
+		op_file{std::move(op_file)},
+		path{path},
+		channels{channels},
+		position{0} {
+}
 
-	// allocate the chunk's buffer
-	pcm_chunk_t chunk(static_cast<size_t>(chunk_size), 0);
-	// initialize chunks with zeroes
-	//std::memset(&chunk.front(), 0, chunk_size*sizeof(int16_t));
-			
-
-	// seek to the requested offset, the seek offset is given in samples
-	// while the requested offset is given in int16_t values, so the division
-	// by 2 is necessary
-	int64_t pcm_offset = static_cast<int64_t>(offset / 2);
-	int op_ret = op_pcm_seek(op_file.get(), pcm_offset);
-	if (op_ret < 0) {
-		throw util::Error{"Could not seek in %s: %d", path.c_str(), op_ret};
+uint32_t OpusDynamicDecoder::read(uint32_t offset, int16_t *buffer, uint32_t length) {
+	// only discontinuities like restarts and loops need a seek, the seek
+	// offset is given in samples while the offset is given in int16_t values
+	if (offset != position) {
+		int op_ret = op_pcm_seek(op_file.get(), static_cast<int64_t>(offset / channels));
+		if (op_ret < 0) {
+			throw util::Error{"Could not seek in %s: %d", path.c_str(), op_ret};
+		}
+		position = offset;
 	}
 
-	// read a chunk from the requested offset
-	// if the opus file is a mono source, we read chunk_size / 2 values and
-	// convert it to stereo directly
-	// if the opus file is a stereo source, we read chunk_size directly
-	int read_num_values = chunk_size / 2 * channels;
-	int read_count = 0;
-	// loop as long as there are samples left to read
-	while (read_count <= read_num_values) {
-		int samples_read = op_read(
-			op_file.get(), &chunk.front() + read_count,
-			read_num_values - read_count, nullptr
-		);
+	// op_read_stereo mixes down sources with more channels
+	uint32_t read_count = 0;
+	while (read_count < length) {
+		int samples_read;
+		if (channels == 1) {
+			samples_read = op_read(op_file.get(), buffer + read_count,
+					static_cast<int>(length - read_count), nullptr);
+		} else {
+			samples_read = op_read_stereo(op_file.get(), buffer + read_count,
+					static_cast<int>(length - read_count));
+		}
 
 		// an error occured
 		if (samples_read < 0) {
@@ -100,31 +115,12 @@ pcm_chunk_t OpusDynamicLoader::load_chunk(uint32_t offset, uint32_t chunk_size)
 			break;
 		}
 
-		// increase read_count by the number of int16_t values that have been
-		// read
+		// the number of samples per channel is returned
 		read_count += samples_read * channels;
 	}
 
-	// convert to stereo
-	if (channels == 1) {
-		for(int i = read_count-1; i >= 0; i--) {
-			auto value = chunk[i];
-			chunk[i*2+1] = value;
-			chunk[i*2] = value;
-		}
-	}
-
-	log::msg("DYNLOAD: file=%d all=%d", read_count, read_count * 2 / channels);
-	return std::move(chunk);
-}
-
-opus_file_t OpusDynamicLoader::open_opus_file() {
-	int op_err;
-	opus_file_t op_file{op_open_file(path.c_str(), &op_err), opus_deleter};
-	if (op_err != 0) {
-		throw util::Error{"Could not open: %s", path.c_str()};
-	}
-	return std::move(op_file);
+	position += read_count;
+	return read_count;
 }
 
 }
@@ -14,6 +14,26 @@
 namespace openage {
 namespace audio {
 
+/**
+ * A DynamicDecoder is an open decoder of one resource. It reads the resource
+ * sequentially, so consecutive reads don't have to open or seek again.
+ */
+class DynamicDecoder {
+public:
+	virtual ~DynamicDecoder() = default;
+
+	/**
+	 * Reads pcm data from the given offset into the buffer, with the channels
+	 * of the loader that opened the decoder. Seeks only if the offset is not
+	 * where the previous read ended.
+	 * @param offset the offset from the resource's beginning
+	 * @param buffer receives the int16_t values
+	 * @param length the number of int16_t values to read
+	 * @returns the number of values read, less than length only at the end
+	 */
+	virtual uint32_t read(uint32_t offset, int16_t *buffer, uint32_t length) = 0;
+};
+
 /**
  * A DynamicLoader loads pcm chunks without loading the whole resource. A chunk
  * is a int16_t buffer with a fixed size that contains 16 bit signed integer
@@ -34,18 +54,25 @@ public:
 	DynamicLoader(const std::string &path);
 	virtual ~DynamicLoader() = default;
 
+	/**
+	 * Returns the resource's location in the filesystem.
+	 */
+	const std::string &get_path() const;
+
 	/**
 	 * Returns the resource's length in int16_t values.
 	 */
 	virtual uint32_t get_length() = 0;
 	/**
-	 * Loads a chunk of stereo pcm data from the resource. The chunk of data
-	 * begins at the given offset from the beginning of the resource and the
-	 * maximum length is supplied.
-	 * @param offset the offset from the resource's beginning
-	 * @param chunk_size the number of int16_t values that fit in one chunk
+	 * Returns the number of interleaved channels of the decoded data, which
+	 * is 1 for mono and 2 for all other resources.
+	 */
+	virtual uint32_t get_channels() = 0;
+	/**
+	 * Opens a decoder for reading the resource sequentially, e.g. while it is
+	 * streamed.
 	 */
-	virtual pcm_chunk_t load_chunk(uint32_t offset, uint32_t chunk_size) = 0;
+	virtual std::unique_ptr<DynamicDecoder> open_decoder() = 0;
 
 	/**
 	 * Creates a DynamicLoader instance that supports the given format.
@@ -67,9 +94,10 @@ private:
 	 */
 	uint32_t length;
 	/**
-	 * The resource's pcm channels.
+	 * The decoded data's channels, files with more than two channels
+	 * are mixed down to stereo.
 	 */
-	int channels;
+	uint32_t channels;
 
 public:
 	/**
@@ -80,7 +108,8 @@ public:
 	virtual ~OpusDynamicLoader() = default;
 
 	virtual uint32_t get_length();
-	virtual pcm_chunk_t load_chunk(uint32_t offset, uint32_t chunk_size);
+	virtual uint32_t get_channels();
+	virtual std::unique_ptr<DynamicDecoder> open_decoder();
 
 private:
 	/**
@@ -90,6 +119,36 @@ private:
 	opus_file_t open_opus_file();
 };
 
+/**
+ * A OpusDynamicDecoder keeps an opus file open and remembers its position.
+ */
+class OpusDynamicDecoder : public DynamicDecoder {
+private:
+	/**
+	 * The open opus file.
+	 */
+	opus_file_t op_file;
+	/**
+	 * The file's location, for error messages.
+	 */
+	std::string path;
+	/**
+	 * The channels to read, mono files are read as they are.
+	 */
+	uint32_t channels;
+	/**
+	 * The position where the next read starts without seeking, in int16_t
+	 * values.
+	 */
+	uint32_t position;
+
+public:
+	OpusDynamicDecoder(opus_file_t &&op_file, const std::string &path, uint32_t channels);
+	virtual ~OpusDynamicDecoder() = default;
+
+	virtual uint32_t read(uint32_t offset, int16_t *buffer, uint32_t length);
+};
+
 }
 }
 
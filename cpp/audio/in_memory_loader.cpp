@@ -33,7 +33,8 @@ std::unique_ptr<InMemoryLoader> InMemoryLoader::create(const std::string &path,
 
 OpusInMemoryLoader::OpusInMemoryLoader(const std::string &path)
 		:
-		InMemoryLoader{path} {
+		InMemoryLoader{path},
+		channels{2} {
 }
 
 // custom deleter for OggOpusFile unique pointers
@@ -57,37 +58,39 @@ pcm_data_t OpusInMemoryLoader::get_resource() {
 	auto pcm_length = op_pcm_total(op_file.get(), -1);
 	log::dbg("Opus channels=%d, pcm_length=%u", op_channels, static_cast<uint32_t>(pcm_length));
 
-	// calculate pcm buffer size depending on the number of channels
-	// if the opus file only had one channel, the pcm buffer size must be
-	// doubled
-	uint32_t length = static_cast<uint32_t>(pcm_length) * 2;
+	// mono data stays mono, it is expanded to stereo while mixing
+	channels = (op_channels == 1) ? 1 : 2;
+	uint32_t length = static_cast<uint32_t>(pcm_length) * channels;
 	pcm_data_t buffer(static_cast<size_t>(length), 0);
 
 	// read data from opus file
-	int position = 0;
-	while (true) {
-		int samples_read = op_read(op_file.get(), &buffer.front()+position,
-				length-position, nullptr);
+	uint32_t position = 0;
+	while (position < length) {
+		int samples_read;
+		if (channels == 1) {
+			samples_read = op_read(op_file.get(), &buffer.front()+position,
+					length-position, nullptr);
+		} else {
+			// mixes down files with more than two channels
+			samples_read = op_read_stereo(op_file.get(), &buffer.front()+position,
+					length-position);
+		}
+
 		if (samples_read < 0) {
 			throw util::Error{"Failed to read from opus file: errorcode=%d", samples_read};
 		} else if(samples_read == 0) {
 			break;
 		}
 
-		position += samples_read * op_channels;
-	}
-
-	// convert from mono to stereo
-	if (op_channels == 1) {
-		for(int i = pcm_length-1; i >= 0; i--) {
-			auto value = buffer[i];
-			buffer[i*2+1] = value;
-			buffer[i*2] = value;
-		}
+		position += samples_read * channels;
 	}
 
 	return std::move(buffer);
 }
 
+uint32_t OpusInMemoryLoader::get_channels() {
+	return channels;
+}
+
 }
 }
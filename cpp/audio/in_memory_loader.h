@@ -36,6 +36,13 @@ public:
 	 */
 	virtual pcm_data_t get_resource() = 0;
 
+	/**
+	 * Returns the number of interleaved channels of the pcm data buffer,
+	 * which is 1 for mono and 2 for all other resources. Only valid after
+	 * get_resource.
+	 */
+	virtual uint32_t get_channels() = 0;
+
 	/**
 	 * Create a InMemoryLoader instance that supports the given format.
 	 * @param path the resource's location in the filesystem
@@ -49,11 +56,19 @@ public:
  * A OpusInMemoryLoader load's opus encoded data.
  */
 class OpusInMemoryLoader : public InMemoryLoader {
+private:
+	/**
+	 * The decoded data's channels, files with more than two channels
+	 * are mixed down to stereo.
+	 */
+	uint32_t channels;
+
 public:
 	OpusInMemoryLoader(const std::string &path);
 	virtual ~OpusInMemoryLoader() = default;
 
 	virtual pcm_data_t get_resource();
+	virtual uint32_t get_channels();
 };
 	
 }
@@ -0,0 +1,395 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#include "mix.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__GNUC__) and (defined(__x86_64__) or defined(__i386__))
+#include <immintrin.h>
+#define OPENAGE_AUDIO_MIX_AVX2 1
+#endif
+
+#if defined(__ARM_NEON) or defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define OPENAGE_AUDIO_MIX_NEON 1
+#endif
+
+namespace openage {
+namespace audio {
+
+// The vectorized kernels process whole vectors and leave
+// the remaining samples to the scalar kernels.
+
+namespace {
+
+void accumulate_scalar(int32_t *stream, const int16_t *samples, size_t count, int32_t volume) {
+	for (size_t i = 0; i < count; i++) {
+		stream[i] += volume * samples[i];
+	}
+}
+
+void accumulate_stereo_scalar(int32_t *stream, const int16_t *samples, size_t count, int32_t left, int32_t right) {
+	for (size_t i = 0; i < count; i++) {
+		stream[2 * i] += left * samples[2 * i];
+		stream[2 * i + 1] += right * samples[2 * i + 1];
+	}
+}
+
+void accumulate_mono_scalar(int32_t *stream, const int16_t *samples, size_t count, int32_t left, int32_t right) {
+	for (size_t i = 0; i < count; i++) {
+		stream[2 * i] += left * samples[i];
+		stream[2 * i + 1] += right * samples[i];
+	}
+}
+
+void add_bus_scalar(int32_t *stream, const int32_t *bus, size_t count, int32_t gain) {
+	if (gain == 256) {
+		for (size_t i = 0; i < count; i++) {
+			stream[i] += bus[i];
+		}
+	} else {
+		// dropping the fractional bits first keeps the product in range
+		for (size_t i = 0; i < count; i++) {
+			stream[i] += (bus[i] >> 8) * gain;
+		}
+	}
+}
+
+void saturate_scalar(int16_t *out, const int32_t *stream, size_t count) {
+	for (size_t i = 0; i < count; i++) {
+		int32_t value = stream[i] >> 8;
+		if (value > 32767) {
+			value = 32767;
+		} else if (value < -32768) {
+			value = -32768;
+		}
+		out[i] = static_cast<int16_t>(value);
+	}
+}
+
+#if defined(__SSE2__)
+
+/**
+ * Multiplication keeping the low 32 bits, which SSE2 lacks.
+ */
+inline __m128i mullo_epi32_sse2(__m128i a, __m128i b) {
+	__m128i even = _mm_mul_epu32(a, b);
+	__m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+	return _mm_unpacklo_epi32(
+		_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+		_mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0))
+	);
+}
+
+/**
+ * Adds 8 samples multiplied by the 16 bit volumes v to stream.
+ */
+inline void accumulate8_sse2(int32_t *stream, __m128i s, __m128i v) {
+	__m128i lo = _mm_mullo_epi16(s, v);
+	__m128i hi = _mm_mulhi_epi16(s, v);
+
+	__m128i *out = reinterpret_cast<__m128i *>(stream);
+	_mm_storeu_si128(out, _mm_add_epi32(_mm_loadu_si128(out), _mm_unpacklo_epi16(lo, hi)));
+	_mm_storeu_si128(out + 1, _mm_add_epi32(_mm_loadu_si128(out + 1), _mm_unpackhi_epi16(lo, hi)));
+}
+
+void accumulate_sse2(int32_t *stream, const int16_t *samples, size_t count, int32_t volume) {
+	size_t i = 0;
+
+	// the 16 bit multiplications need the volume to fit in 16 bits
+	if (volume >= -32768 and volume <= 32767) {
+		__m128i v = _mm_set1_epi16(static_cast<int16_t>(volume));
+		for (; i + 8 <= count; i += 8) {
+			__m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(samples + i));
+			accumulate8_sse2(stream + i, s, v);
+		}
+	}
+
+	accumulate_scalar(stream + i, samples + i, count - i, volume);
+}
+
+/**
+ * Returns whether both volumes fit the 16 bit multiplications.
+ */
+inline bool fits_int16(int32_t left, int32_t right) {
+	return left >= -32768 and left <= 32767 and right >= -32768 and right <= 32767;
+}
+
+/**
+ * Returns the volumes of the stereo channels, for 4 frames.
+ */
+inline __m128i stereo_volume_sse2(int32_t left, int32_t right) {
+	int16_t l = static_cast<int16_t>(left);
+	int16_t r = static_cast<int16_t>(right);
+	return _mm_setr_epi16(l, r, l, r, l, r, l, r);
+}
+
+void accumulate_stereo_sse2(int32_t *stream, const int16_t *samples, size_t count, int32_t left, int32_t right) {
+	size_t i = 0;
+
+	if (fits_int16(left, right)) {
+		__m128i v = stereo_volume_sse2(left, right);
+		for (; i + 4 <= count; i += 4) {
+			__m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(samples + 2 * i));
+			accumulate8_sse2(stream + 2 * i, s, v);
+		}
+	}
+
+	accumulate_stereo_scalar(stream + 2 * i, samples + 2 * i, count - i, left, right);
+}
+
+void accumulate_mono_sse2(int32_t *stream, const int16_t *samples, size_t count, int32_t left, int32_t right) {
+	size_t i = 0;
+
+	if (fits_int16(left, right)) {
+		__m128i v = stereo_volume_sse2(left, right);
+		for (; i + 8 <= count; i += 8) {
+			// each sample for both channels
+			__m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(samples + i));
+			accumulate8_sse2(stream + 2 * i, _mm_unpacklo_epi16(s, s), v);
+			accumulate8_sse2(stream + 2 * i + 8, _mm_unpackhi_epi16(s, s), v);
+		}
+	}
+
+	accumulate_mono_scalar(stream + 2 * i, samples + i, count - i, left, right);
+}
+
+void add_bus_sse2(int32_t *stream, const int32_t *bus, size_t count, int32_t gain) {
+	size_t i = 0;
+	if (gain == 256) {
+		for (; i + 4 <= count; i += 4) {
+			__m128i *out = reinterpret_cast<__m128i *>(stream + i);
+			__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bus + i));
+			_mm_storeu_si128(out, _mm_add_epi32(_mm_loadu_si128(out), b));
+		}
+	} else {
+		__m128i g = _mm_set1_epi32(gain);
+		for (; i + 4 <= count; i += 4) {
+			__m128i *out = reinterpret_cast<__m128i *>(stream + i);
+			__m128i b = _mm_srai_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(bus + i)), 8);
+			_mm_storeu_si128(out, _mm_add_epi32(_mm_loadu_si128(out), mullo_epi32_sse2(b, g)));
+		}
+	}
+
+	add_bus_scalar(stream + i, bus + i, count - i, gain);
+}
+
+void saturate_sse2(int16_t *out, const int32_t *stream, size_t count) {
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		const __m128i *in = reinterpret_cast<const __m128i *>(stream + i);
+		__m128i a = _mm_srai_epi32(_mm_loadu_si128(in), 8);
+		__m128i b = _mm_srai_epi32(_mm_loadu_si128(in + 1), 8);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_packs_epi32(a, b));
+	}
+
+	saturate_scalar(out + i, stream + i, count - i);
+}
+
+#endif
+
+#if defined(OPENAGE_AUDIO_MIX_AVX2)
+
+// compiled for avx2 even if the rest of the program isn't,
+// only called after checking the cpu supports it.
+
+__attribute__((target("avx2")))
+void accumulate_avx2(int32_t *stream, const int16_t *samples, size_t count, int32_t volume) {
+	size_t i = 0;
+	__m256i v = _mm256_set1_epi32(volume);
+	for (; i + 8 <= count; i += 8) {
+		__m256i s = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(samples + i)));
+		__m256i *out = reinterpret_cast<__m256i *>(stream + i);
+		_mm256_storeu_si256(out, _mm256_add_epi32(_mm256_loadu_si256(out), _mm256_mullo_epi32(s, v)));
+	}
+
+	accumulate_scalar(stream + i, samples + i, count - i, volume);
+}
+
+__attribute__((target("avx2")))
+void accumulate_stereo_avx2(int32_t *stream, const int16_t *samples, size_t count, int32_t left, int32_t right) {
+	size_t i = 0;
+	__m256i v = _mm256_setr_epi32(left, right, left, right, left, right, left, right);
+	for (; i + 4 <= count; i += 4) {
+		__m256i s = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(samples + 2 * i)));
+		__m256i *out = reinterpret_cast<__m256i *>(stream + 2 * i);
+		_mm256_storeu_si256(out, _mm256_add_epi32(_mm256_loadu_si256(out), _mm256_mullo_epi32(s, v)));
+	}
+
+	accumulate_stereo_scalar(stream + 2 * i, samples + 2 * i, count - i, left, right);
+}
+
+__attribute__((target("avx2")))
+void accumulate_mono_avx2(int32_t *stream, const int16_t *samples, size_t count, int32_t left, int32_t right) {
+	size_t i = 0;
+	__m256i v = _mm256_setr_epi32(left, right, left, right, left, right, left, right);
+	// each sample for both channels
+	__m256i first = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+	__m256i second = _mm256_setr_epi32(4, 4, 5, 5, 6, 6, 7, 7);
+	for (; i + 8 <= count; i += 8) {
+		__m256i s = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(samples + i)));
+		__m256i *out = reinterpret_cast<__m256i *>(stream + 2 * i);
+		__m256i a = _mm256_mullo_epi32(_mm256_permutevar8x32_epi32(s, first), v);
+		__m256i b = _mm256_mullo_epi32(_mm256_permutevar8x32_epi32(s, second), v);
+		_mm256_storeu_si256(out, _mm256_add_epi32(_mm256_loadu_si256(out), a));
+		_mm256_storeu_si256(out + 1, _mm256_add_epi32(_mm256_loadu_si256(out + 1), b));
+	}
+
+	accumulate_mono_scalar(stream + 2 * i, samples + i, count - i, left, right);
+}
+
+__attribute__((target("avx2")))
+void add_bus_avx2(int32_t *stream, const int32_t *bus, size_t count, int32_t gain) {
+	size_t i = 0;
+	if (gain == 256) {
+		for (; i + 8 <= count; i += 8) {
+			__m256i *out = reinterpret_cast<__m256i *>(stream + i);
+			__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(bus + i));
+			_mm256_storeu_si256(out, _mm256_add_epi32(_mm256_loadu_si256(out), b));
+		}
+	} else {
+		__m256i g = _mm256_set1_epi32(gain);
+		for (; i + 8 <= count; i += 8) {
+			__m256i *out = reinterpret_cast<__m256i *>(stream + i);
+			__m256i b = _mm256_srai_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(bus + i)), 8);
+			_mm256_storeu_si256(out, _mm256_add_epi32(_mm256_loadu_si256(out), _mm256_mullo_epi32(b, g)));
+		}
+	}
+
+	add_bus_scalar(stream + i, bus + i, count - i, gain);
+}
+
+__attribute__((target("avx2")))
+void saturate_avx2(int16_t *out, const int32_t *stream, size_t count) {
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		const __m256i *in = reinterpret_cast<const __m256i *>(stream + i);
+		__m256i a = _mm256_srai_epi32(_mm256_loadu_si256(in), 8);
+		__m256i b = _mm256_srai_epi32(_mm256_loadu_si256(in + 1), 8);
+
+		// packing works within the 128 bit lanes, this restores the order
+		__m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), _MM_SHUFFLE(3, 1, 2, 0));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), packed);
+	}
+
+	saturate_scalar(out + i, stream + i, count - i);
+}
+
+#endif
+
+#if defined(OPENAGE_AUDIO_MIX_NEON)
+
+void accumulate_neon(int32_t *stream, const int16_t *samples, size_t count, int32_t volume) {
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		int16x8_t s = vld1q_s16(samples + i);
+		int32x4_t a = vmlaq_n_s32(vld1q_s32(stream + i), vmovl_s16(vget_low_s16(s)), volume);
+		int32x4_t b = vmlaq_n_s32(vld1q_s32(stream + i + 4), vmovl_s16(vget_high_s16(s)), volume);
+		vst1q_s32(stream + i, a);
+		vst1q_s32(stream + i + 4, b);
+	}
+
+	accumulate_scalar(stream + i, samples + i, count - i, volume);
+}
+
+/**
+ * Returns the volumes of the stereo channels, for 2 frames.
+ */
+inline int32x4_t stereo_volume_neon(int32_t left, int32_t right) {
+	int32x2_t frame = vset_lane_s32(right, vdup_n_s32(left), 1);
+	return vcombine_s32(frame, frame);
+}
+
+void accumulate_stereo_neon(int32_t *stream, const int16_t *samples, size_t count, int32_t left, int32_t right) {
+	size_t i = 0;
+	int32x4_t v = stereo_volume_neon(left, right);
+	for (; i + 4 <= count; i += 4) {
+		int16x8_t s = vld1q_s16(samples + 2 * i);
+		int32x4_t a = vmlaq_s32(vld1q_s32(stream + 2 * i), vmovl_s16(vget_low_s16(s)), v);
+		int32x4_t b = vmlaq_s32(vld1q_s32(stream + 2 * i + 4), vmovl_s16(vget_high_s16(s)), v);
+		vst1q_s32(stream + 2 * i, a);
+		vst1q_s32(stream + 2 * i + 4, b);
+	}
+
+	accumulate_stereo_scalar(stream + 2 * i, samples + 2 * i, count - i, left, right);
+}
+
+void accumulate_mono_neon(int32_t *stream, const int16_t *samples, size_t count, int32_t left, int32_t right) {
+	size_t i = 0;
+	int32x4_t v = stereo_volume_neon(left, right);
+	for (; i + 8 <= count; i += 8) {
+		// each sample for both channels
+		int16x8_t s = vld1q_s16(samples + i);
+		int16x8x2_t frames = vzipq_s16(s, s);
+		for (int half = 0; half < 2; half++) {
+			int32_t *out = stream + 2 * i + 8 * half;
+			int32x4_t a = vmlaq_s32(vld1q_s32(out), vmovl_s16(vget_low_s16(frames.val[half])), v);
+			int32x4_t b = vmlaq_s32(vld1q_s32(out + 4), vmovl_s16(vget_high_s16(frames.val[half])), v);
+			vst1q_s32(out, a);
+			vst1q_s32(out + 4, b);
+		}
+	}
+
+	accumulate_mono_scalar(stream + 2 * i, samples + i, count - i, left, right);
+}
+
+void add_bus_neon(int32_t *stream, const int32_t *bus, size_t count, int32_t gain) {
+	size_t i = 0;
+	if (gain == 256) {
+		for (; i + 4 <= count; i += 4) {
+			vst1q_s32(stream + i, vaddq_s32(vld1q_s32(stream + i), vld1q_s32(bus + i)));
+		}
+	} else {
+		for (; i + 4 <= count; i += 4) {
+			int32x4_t b = vshrq_n_s32(vld1q_s32(bus + i), 8);
+			vst1q_s32(stream + i, vmlaq_n_s32(vld1q_s32(stream + i), b, gain));
+		}
+	}
+
+	add_bus_scalar(stream + i, bus + i, count - i, gain);
+}
+
+void saturate_neon(int16_t *out, const int32_t *stream, size_t count) {
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		int16x4_t a = vqshrn_n_s32(vld1q_s32(stream + i), 8);
+		int16x4_t b = vqshrn_n_s32(vld1q_s32(stream + i + 4), 8);
+		vst1q_s16(out + i, vcombine_s16(a, b));
+	}
+
+	saturate_scalar(out + i, stream + i, count - i);
+}
+
+#endif
+
+mix_functions select_mix_functions() {
+#if defined(OPENAGE_AUDIO_MIX_AVX2)
+	if (__builtin_cpu_supports("avx2")) {
+		return {"avx2", accumulate_avx2, accumulate_stereo_avx2, accumulate_mono_avx2, add_bus_avx2, saturate_avx2};
+	}
+#endif
+#if defined(__SSE2__)
+	return {"sse2", accumulate_sse2, accumulate_stereo_sse2, accumulate_mono_sse2, add_bus_sse2, saturate_sse2};
+#elif defined(OPENAGE_AUDIO_MIX_NEON)
+	return {"neon", accumulate_neon, accumulate_stereo_neon, accumulate_mono_neon, add_bus_neon, saturate_neon};
+#else
+	return get_scalar_mix_functions();
+#endif
+}
+
+} // anonymous namespace
+
+const mix_functions &get_mix_functions() {
+	static const mix_functions functions = select_mix_functions();
+	return functions;
+}
+
+const mix_functions &get_scalar_mix_functions() {
+	static const mix_functions functions{"scalar", accumulate_scalar, accumulate_stereo_scalar, accumulate_mono_scalar, add_bus_scalar, saturate_scalar};
+	return functions;
+}
+
+}
+}
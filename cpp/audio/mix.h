@@ -0,0 +1,70 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#ifndef OPENAGE_AUDIO_MIX_H_
+#define OPENAGE_AUDIO_MIX_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace openage {
+namespace audio {
+
+/**
+ * The kernels used by the audio callback to mix pcm samples. Mix buffers
+ * hold 32 bit samples, scaled by 256 compared to the 16 bit output.
+ *
+ * There are vectorized versions for SSE2, AVX2 and NEON, the best one that
+ * the cpu supports is selected at runtime.
+ */
+struct mix_functions {
+	/**
+	 * The instruction set of these kernels.
+	 */
+	const char *name;
+
+	/**
+	 * Adds volume * samples[i] to stream[i].
+	 */
+	void (*accumulate)(int32_t *stream, const int16_t *samples, size_t count, int32_t volume);
+
+	/**
+	 * Adds the stereo frame i of samples to the frame i of stream, with
+	 * separate volumes for the left and the right channel. Panned stereo
+	 * resources are mixed with this, count is the number of frames.
+	 */
+	void (*accumulate_stereo)(int32_t *stream, const int16_t *samples, size_t count, int32_t left, int32_t right);
+
+	/**
+	 * Adds left * samples[i] to stream[2*i] and right * samples[i] to
+	 * stream[2*i+1], the channels of the stereo frame i. Mono resources are
+	 * expanded to stereo with this.
+	 */
+	void (*accumulate_mono)(int32_t *stream, const int16_t *samples, size_t count, int32_t left, int32_t right);
+
+	/**
+	 * Adds a category's mix buffer to the final mix buffer, scaled by the
+	 * category's gain. Like volumes, a gain of 256 is the original volume,
+	 * and adds the bus unchanged.
+	 */
+	void (*add_bus)(int32_t *stream, const int32_t *bus, size_t count, int32_t gain);
+
+	/**
+	 * Scales the mix buffer to 16 bit samples, clamping those that overflow.
+	 */
+	void (*saturate)(int16_t *out, const int32_t *stream, size_t count);
+};
+
+/**
+ * Returns the fastest kernels available on this cpu.
+ */
+const mix_functions &get_mix_functions();
+
+/**
+ * Returns the plain c++ kernels, which all others have to match.
+ */
+const mix_functions &get_scalar_mix_functions();
+
+}
+}
+
+#endif
@@ -0,0 +1,124 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#include "null_device.h"
+
+#include <chrono>
+#include <limits>
+
+#include "audio_manager.h"
+#include "../util/error.h"
+
+namespace openage {
+namespace audio {
+
+NullAudioDevice::NullAudioDevice(AudioManager *manager)
+		:
+		manager{manager},
+		late_count{0},
+		render_count{0},
+		render_limit{std::numeric_limits<uint64_t>::max()},
+		running{false} {
+	SDL_AudioSpec spec = manager->get_device_spec();
+	buffer_length = static_cast<size_t>(spec.samples) * spec.channels;
+	buffer_usec = 1e6 * spec.samples / spec.freq;
+	buffer.reset(new int16_t[buffer_length]);
+}
+
+NullAudioDevice::~NullAudioDevice() {
+	stop();
+}
+
+void NullAudioDevice::set_output(output_t output) {
+	this->output = output;
+}
+
+const int16_t *NullAudioDevice::render() {
+	auto start = std::chrono::steady_clock::now();
+	manager->audio_callback(buffer.get(), static_cast<int>(buffer_length));
+	auto end = std::chrono::steady_clock::now();
+
+	callback_times.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+
+	if (output) {
+		output(buffer.get(), buffer_length);
+	}
+	render_count++;
+	return buffer.get();
+}
+
+void NullAudioDevice::start(bool realtime) {
+	if (running.load()) {
+		throw util::Error{"the null audio device is already running"};
+	}
+	running.store(true);
+	thread = std::thread{&NullAudioDevice::run, this, realtime};
+}
+
+void NullAudioDevice::stop() {
+	running.store(false);
+	if (thread.joinable()) {
+		thread.join();
+	}
+}
+
+size_t NullAudioDevice::get_buffer_length() const {
+	return buffer_length;
+}
+
+double NullAudioDevice::get_buffer_usec() const {
+	return buffer_usec;
+}
+
+uint64_t NullAudioDevice::get_render_count() const {
+	return render_count.load();
+}
+
+void NullAudioDevice::set_render_limit(uint64_t count) {
+	render_limit.store(count);
+}
+
+const std::vector<double> &NullAudioDevice::get_callback_times() const {
+	return callback_times;
+}
+
+uint64_t NullAudioDevice::get_late_count() const {
+	return late_count;
+}
+
+void NullAudioDevice::reset_statistics() {
+	callback_times.clear();
+	late_count = 0;
+}
+
+void NullAudioDevice::run(bool realtime) {
+	using clock = std::chrono::steady_clock;
+	auto period = std::chrono::duration_cast<clock::duration>(
+		std::chrono::duration<double, std::micro>(buffer_usec)
+	);
+
+	// a sound card asks for the next buffer while the current one plays,
+	// so each buffer is due one period after it was requested
+	auto due = clock::now() + period;
+	while (running.load()) {
+		if (render_count.load() >= render_limit.load()) {
+			std::this_thread::yield();
+			continue;
+		}
+		render();
+
+		if (realtime) {
+			auto now = clock::now();
+			if (now > due) {
+				late_count++;
+				// a late device continues from now, like after a dropout
+				due = now;
+			} else {
+				std::this_thread::sleep_until(due);
+			}
+			due += period;
+		}
+	}
+}
+
+}
+}
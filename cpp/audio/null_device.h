@@ -0,0 +1,132 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#ifndef OPENAGE_AUDIO_NULL_DEVICE_H_
+#define OPENAGE_AUDIO_NULL_DEVICE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace openage {
+namespace audio {
+
+class AudioManager;
+
+/**
+ * A NullAudioDevice drives the audio callback of an AudioManager that was
+ * opened with AudioManager::null_device, without any audio hardware. The
+ * mixed buffers can be passed to an output function, e.g. a WavWriter.
+ *
+ * It either renders single buffers on the calling thread, which is
+ * deterministic, or pulls buffers on its own thread like a sound card:
+ * as fast as possible, or at the pace of the device's sample rate.
+ */
+class NullAudioDevice {
+public:
+	/**
+	 * The function receiving the mixed buffers and their length in
+	 * int16_t values.
+	 */
+	using output_t = std::function<void(const int16_t*,size_t)>;
+
+	NullAudioDevice(AudioManager *manager);
+
+	/**
+	 * Stops the device thread.
+	 */
+	~NullAudioDevice();
+
+	NullAudioDevice(const NullAudioDevice&) = delete;
+	NullAudioDevice &operator=(const NullAudioDevice&) = delete;
+
+	/**
+	 * Sets the function that receives the mixed buffers. Must not be changed
+	 * while the device thread is running.
+	 */
+	void set_output(output_t output);
+
+	/**
+	 * Renders one buffer on the calling thread, and passes it to the output.
+	 * Must not be called while the device thread is running.
+	 * @returns the mixed buffer, valid until the next buffer is rendered
+	 */
+	const int16_t *render();
+
+	/**
+	 * Starts pulling buffers on the device thread.
+	 * @param realtime whether to wait for the time a buffer takes to play
+	 *                 before the next one, instead of rendering at once
+	 */
+	void start(bool realtime);
+
+	/**
+	 * Stops pulling buffers, and waits for the device thread.
+	 */
+	void stop();
+
+	/**
+	 * Returns the number of int16_t values in one buffer.
+	 */
+	size_t get_buffer_length() const;
+
+	/**
+	 * Returns the time one buffer takes to play, in microseconds.
+	 */
+	double get_buffer_usec() const;
+
+	/**
+	 * Returns the number of buffers rendered so far, also while the device
+	 * thread is running.
+	 */
+	uint64_t get_render_count() const;
+
+	/**
+	 * Lets the device thread render no more than count buffers in total,
+	 * it waits for a higher limit then, e.g. until the game thread has
+	 * played the next tick. Unlimited by default.
+	 */
+	void set_render_limit(uint64_t count);
+
+	/**
+	 * Returns how long the callback took for each rendered buffer, in
+	 * microseconds. Only valid while the device thread isn't running.
+	 */
+	const std::vector<double> &get_callback_times() const;
+
+	/**
+	 * Returns how often a realtime buffer was rendered after it should have
+	 * been played, which is an audible dropout on a real device.
+	 */
+	uint64_t get_late_count() const;
+
+	/**
+	 * Clears the callback times and the late count.
+	 */
+	void reset_statistics();
+
+private:
+	void run(bool realtime);
+
+	AudioManager *manager;
+	output_t output;
+
+	size_t buffer_length;
+	double buffer_usec;
+	std::unique_ptr<int16_t[]> buffer;
+
+	std::vector<double> callback_times;
+	uint64_t late_count;
+	std::atomic<uint64_t> render_count;
+	std::atomic<uint64_t> render_limit;
+
+	std::thread thread;
+	std::atomic<bool> running;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,43 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#include "positional.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace openage {
+namespace audio {
+
+stereo_gain positional_gain(const coord::phys3 &position, const coord::phys3 &listener) {
+	coord::phys3_delta delta = position - listener;
+
+	// the projection of phys3_delta::to_camgame, in tile widths
+	// instead of pixels: a tile is twice as wide as it is high.
+	const double tile = static_cast<double>(coord::settings::phys_per_tile);
+	double x = (delta.ne + delta.se) / (2 * tile);
+	double y = (delta.ne - delta.se + delta.up) / (4 * tile);
+
+	double distance = std::sqrt(x * x + y * y);
+	if (distance >= audible_distance) {
+		return {0, 0};
+	}
+
+	double attenuation = 1;
+	if (distance > full_volume_distance) {
+		attenuation = (audible_distance - distance) / (audible_distance - full_volume_distance);
+	}
+
+	// the channel on the sound's side keeps its volume,
+	// the other one fades out
+	double pan = std::max(-1.0, std::min(1.0, x / pan_distance));
+	double left = attenuation * std::min(1.0, 1 - pan);
+	double right = attenuation * std::min(1.0, 1 + pan);
+
+	return {
+		static_cast<int32_t>(std::lround(256 * left)),
+		static_cast<int32_t>(std::lround(256 * right))
+	};
+}
+
+}
+}
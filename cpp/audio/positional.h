@@ -0,0 +1,57 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#ifndef OPENAGE_AUDIO_POSITIONAL_H_
+#define OPENAGE_AUDIO_POSITIONAL_H_
+
+#include <cstdint>
+
+#include "../coord/phys3.h"
+
+namespace openage {
+namespace audio {
+
+/**
+ * Distances of positional sounds to the listener, in tile widths on the
+ * screen. The screen of a 1920 pixels wide window is 20 tile widths wide.
+ */
+
+/**
+ * Sounds closer to the listener are played at their full volume.
+ */
+constexpr double full_volume_distance = 6;
+
+/**
+ * Sounds farther from the listener are inaudible. They are virtual voices,
+ * which keep their playing position but aren't mixed.
+ */
+constexpr double audible_distance = 20;
+
+/**
+ * Sounds this far to one side are only played on that side.
+ */
+constexpr double pan_distance = 8;
+
+/**
+ * The gains of the left and the right channel of a sound. Like volumes,
+ * 256 is the original volume.
+ */
+struct stereo_gain {
+	int32_t left;
+	int32_t right;
+};
+
+/**
+ * Returns the gains of a sound at a position, heard by the listener at
+ * the camera position. The distance to the listener is measured where the
+ * positions are drawn on the screen: the volume falls off linearly between
+ * full_volume_distance and audible_distance, and the horizontal offset
+ * pans the sound. Both gains are 0 for inaudible sounds.
+ * @param position the sound's position
+ * @param listener the position at the screen's center
+ */
+stereo_gain positional_gain(const coord::phys3 &position, const coord::phys3 &listener);
+
+}
+}
+
+#endif
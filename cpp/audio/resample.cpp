@@ -0,0 +1,175 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#include "resample.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace openage {
+namespace audio {
+
+namespace {
+
+/**
+ * The number of frames a ResamplingDecoder reads from its decoder at once.
+ */
+constexpr uint32_t window_size = 4096;
+
+/**
+ * Interpolates between two frames.
+ * @param frac the position between a and b, in units of 1/to_freq
+ */
+inline int16_t interpolate(int16_t a, int16_t b, uint64_t frac, int to_freq) {
+	return static_cast<int16_t>(a + (static_cast<int64_t>(b - a) * static_cast<int64_t>(frac)) / to_freq);
+}
+
+} // anonymous namespace
+
+uint64_t resampled_frames(uint64_t frames, int from_freq, int to_freq) {
+	if (frames == 0) {
+		return 0;
+	}
+	// all output frames up to and including the last input frame
+	return (frames - 1) * to_freq / from_freq + 1;
+}
+
+pcm_data_t resample(const pcm_data_t &data, int channels, int from_freq, int to_freq) {
+	if (from_freq == to_freq) {
+		return data;
+	}
+
+	uint64_t in_frames = data.size() / channels;
+	uint64_t out_frames = resampled_frames(in_frames, from_freq, to_freq);
+	pcm_data_t result(static_cast<size_t>(out_frames * channels));
+
+	for (uint64_t k = 0; k < out_frames; k++) {
+		uint64_t position = k * from_freq;
+		uint64_t frame = position / to_freq;
+		uint64_t frac = position % to_freq;
+		const int16_t *a = &data[frame * channels];
+		// the last output frame lies exactly on the last input frame
+		const int16_t *b = (frac == 0) ? a : a + channels;
+		for (int c = 0; c < channels; c++) {
+			result[k * channels + c] = interpolate(a[c], b[c], frac, to_freq);
+		}
+	}
+
+	return result;
+}
+
+ResamplingLoader::ResamplingLoader(std::unique_ptr<DynamicLoader> &&loader,
+		int from_freq, int to_freq)
+		:
+		DynamicLoader{loader->get_path()},
+		loader{std::move(loader)},
+		from_freq{from_freq},
+		to_freq{to_freq} {
+}
+
+uint32_t ResamplingLoader::get_length() {
+	uint32_t channels = loader->get_channels();
+	uint64_t frames = loader->get_length() / channels;
+	return static_cast<uint32_t>(resampled_frames(frames, from_freq, to_freq) * channels);
+}
+
+uint32_t ResamplingLoader::get_channels() {
+	return loader->get_channels();
+}
+
+std::unique_ptr<DynamicDecoder> ResamplingLoader::open_decoder() {
+	return std::unique_ptr<DynamicDecoder>{new ResamplingDecoder{
+		loader->open_decoder(), loader->get_channels(), from_freq, to_freq
+	}};
+}
+
+ResamplingDecoder::ResamplingDecoder(std::unique_ptr<DynamicDecoder> &&decoder,
+		uint32_t channels, int from_freq, int to_freq)
+		:
+		decoder{std::move(decoder)},
+		channels{channels},
+		from_freq{from_freq},
+		to_freq{to_freq},
+		window{new int16_t[window_size * channels]},
+		window_start{0},
+		window_frames{0},
+		input_ended{false},
+		output_frame{0} {
+}
+
+uint32_t ResamplingDecoder::read(uint32_t offset, int16_t *buffer, uint32_t length) {
+	// a seek starts with an empty window at the new position
+	uint64_t frame = offset / channels;
+	if (frame != output_frame) {
+		output_frame = frame;
+		window_start = frame * from_freq / to_freq;
+		window_frames = 0;
+		input_ended = false;
+	}
+
+	uint32_t frames = length / channels;
+	uint32_t written = 0;
+	for (; written < frames; written++) {
+		uint64_t position = output_frame * from_freq;
+		uint64_t input_frame = position / to_freq;
+		uint64_t frac = position % to_freq;
+
+		bool next_available;
+		if (!fill_window(input_frame, &next_available)) {
+			break;
+		}
+		// beyond the last input frame, unless exactly on it
+		if (frac != 0 && !next_available) {
+			break;
+		}
+
+		const int16_t *a = &window[(input_frame - window_start) * channels];
+		const int16_t *b = (frac == 0) ? a : a + channels;
+		for (uint32_t c = 0; c < channels; c++) {
+			buffer[written * channels + c] = interpolate(a[c], b[c], frac, to_freq);
+		}
+		output_frame++;
+	}
+
+	return written * channels;
+}
+
+bool ResamplingDecoder::fill_window(uint64_t frame, bool *next_available) {
+	while (true) {
+		uint64_t window_end = window_start + window_frames;
+		if (frame + 1 < window_end) {
+			*next_available = true;
+			return true;
+		}
+		if (input_ended) {
+			*next_available = false;
+			return frame < window_end;
+		}
+
+		// keep the frames from the requested one on, and read behind them
+		if (frame > window_start) {
+			uint32_t dropped = static_cast<uint32_t>(std::min<uint64_t>(frame - window_start, window_frames));
+			std::memmove(&window[0], &window[dropped * channels],
+					(window_frames - dropped) * channels * sizeof(int16_t));
+			window_start += dropped;
+			window_frames -= dropped;
+			// the requested frame may lie beyond the window
+			if (window_frames == 0) {
+				window_start = frame;
+			}
+		}
+
+		uint32_t wanted = (window_size - window_frames) * channels;
+		uint32_t read = decoder->read(
+			static_cast<uint32_t>((window_start + window_frames) * channels),
+			&window[window_frames * channels],
+			wanted
+		);
+		window_frames += read / channels;
+		if (read < wanted) {
+			input_ended = true;
+		}
+	}
+}
+
+}
+}
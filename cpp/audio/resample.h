@@ -0,0 +1,98 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#ifndef OPENAGE_AUDIO_RESAMPLE_H_
+#define OPENAGE_AUDIO_RESAMPLE_H_
+
+#include <cstdint>
+#include <memory>
+
+#include "dynamic_loader.h"
+#include "types.h"
+
+namespace openage {
+namespace audio {
+
+/**
+ * The sample rate all supported formats are decoded with.
+ */
+constexpr int decoder_freq = 48000;
+
+// Sample rates are converted once, when a resource is decoded, so the audio
+// callback mixes at the device's rate without converting. The conversion
+// interpolates linearly between two frames, output frame k is taken at
+// input frame k * from_freq / to_freq.
+
+/**
+ * Returns the number of frames a resource of the given number of frames has
+ * after converting it from from_freq to to_freq.
+ */
+uint64_t resampled_frames(uint64_t frames, int from_freq, int to_freq);
+
+/**
+ * Converts interleaved pcm data from from_freq to to_freq.
+ * @param channels the number of interleaved channels
+ */
+pcm_data_t resample(const pcm_data_t &data, int channels, int from_freq, int to_freq);
+
+/**
+ * A ResamplingLoader presents the resource of another DynamicLoader at a
+ * different sample rate. Its decoders convert the data while it is streamed.
+ */
+class ResamplingLoader : public DynamicLoader {
+public:
+	ResamplingLoader(std::unique_ptr<DynamicLoader> &&loader, int from_freq, int to_freq);
+	virtual ~ResamplingLoader() = default;
+
+	virtual uint32_t get_length();
+	virtual uint32_t get_channels();
+	virtual std::unique_ptr<DynamicDecoder> open_decoder();
+
+private:
+	std::unique_ptr<DynamicLoader> loader;
+	int from_freq;
+	int to_freq;
+};
+
+/**
+ * A ResamplingDecoder converts the data of another decoder while it is read.
+ * It keeps a window of input frames between reads, so sequential reads of
+ * the converted data read the input sequentially too.
+ */
+class ResamplingDecoder : public DynamicDecoder {
+public:
+	ResamplingDecoder(std::unique_ptr<DynamicDecoder> &&decoder, uint32_t channels,
+			int from_freq, int to_freq);
+	virtual ~ResamplingDecoder() = default;
+
+	virtual uint32_t read(uint32_t offset, int16_t *buffer, uint32_t length);
+
+private:
+	/**
+	 * Makes sure the window contains the given input frame and the next
+	 * one. Returns false if the first one is beyond the input's end, and
+	 * sets next_available to whether the second one exists.
+	 */
+	bool fill_window(uint64_t frame, bool *next_available);
+
+	std::unique_ptr<DynamicDecoder> decoder;
+	uint32_t channels;
+	int from_freq;
+	int to_freq;
+
+	/** the input frames read from the decoder */
+	std::unique_ptr<int16_t[]> window;
+	/** the input frame at the start of the window */
+	uint64_t window_start;
+	/** the number of frames in the window */
+	uint32_t window_frames;
+	/** whether the decoder reached the end of the input */
+	bool input_ended;
+
+	/** the next output frame, where the next read continues */
+	uint64_t output_frame;
+};
+
+}
+}
+
+#endif
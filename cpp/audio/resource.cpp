@@ -3,7 +3,7 @@
 #include "resource.h"
 
 #include "in_memory_loader.h"
-#include "../engine.h"
+#include "resample.h"
 #include "../util/error.h"
 #include "../log.h"
 
@@ -13,7 +13,10 @@ namespace audio {
 Resource::Resource(category_t category, int id)
 		:
 		category{category},
-		id{id} {
+		id{id},
+		use_count{0},
+		loaded{false},
+		channels{2} {
 }
 
 category_t Resource::get_category() const {
@@ -24,21 +27,60 @@ int Resource::get_id() const {
 	return id;
 }
 
+uint32_t Resource::get_channels() const {
+	return channels;
+}
+
+void Resource::load() {
+	if (!loaded) {
+		do_load();
+		loaded = true;
+	}
+}
+
+bool Resource::is_loaded() const {
+	return loaded;
+}
+
+void Resource::do_load() {
+}
+
 void Resource::use() {
 }
 
 void Resource::stop_using() {
 }
 
+std::tuple<const int16_t*,uint32_t> Resource::get_data(uint32_t position,
+		uint32_t data_length) {
+	// if the resource isn't decoded or its end has been reached
+	uint32_t length = samples ? static_cast<uint32_t>(samples->size()) : 0;
+	if (position >= length) {
+		return std::make_tuple(nullptr, 0);
+	}
+
+	const int16_t *buf_pos = &(*samples)[position];
+	if (data_length > length - position) {
+		return std::make_tuple(buf_pos, length - position);
+	} else {
+		return std::make_tuple(buf_pos, data_length);
+	}
+}
+
+std::shared_ptr<Stream> Resource::open_stream() {
+	return {};
+}
+
 std::shared_ptr<Resource> Resource::create_resource(category_t category,
 		int id, const std::string &path, format_t format,
-		loader_policy_t loader_policy) {
+		loader_policy_t loader_policy, StreamWorker *streams,
+		SampleCache *cache, int freq) {
 
 	switch (loader_policy) {
 	case loader_policy_t::IN_MEMORY:
-		return std::make_shared<InMemoryResource>(category, id, path, format);
+		return std::make_shared<InMemoryResource>(category, id, path, streams, cache, freq, format);
 	case loader_policy_t::DYNAMIC:
-		return std::make_shared<DynamicResource>(category, id, path, format);
+		return std::make_shared<DynamicResource>(category, id, path, streams, cache, freq, format);
 	default:
 		throw util::Error{"Unsupported loader policy"};
 	}
@@ -47,136 +89,110 @@ std::shared_ptr<Resource> Resource::create_resource(category_t category,
 // in memory resource
 
 InMemoryResource::InMemoryResource(category_t category, int id,
-		const std::string &path, format_t format)
+		const std::string &path, StreamWorker *streams, SampleCache *cache,
+		int freq, format_t format)
 		:
-		Resource{category, id}  {
-	auto loader = InMemoryLoader::create(path, format);
-	buffer = loader->get_resource();
+		Resource{category, id},
+		path{path},
+		format{format},
+		streams{streams},
+		cache{cache},
+		freq{freq} {
 }
 
-std::tuple<const int16_t*,uint32_t> InMemoryResource::get_data(
-		uint32_t position, uint32_t data_length) {
-	// if the resource's end has been reached
-	uint32_t length = static_cast<uint32_t>(buffer.size());
-	if (position >= length) {
-		return std::make_tuple(nullptr, 0);
+void InMemoryResource::do_load() {
+	auto opened = DynamicLoader::create(path, format);
+	if (freq != decoder_freq) {
+		loader = std::make_shared<ResamplingLoader>(std::move(opened), decoder_freq, freq);
+	} else {
+		loader = std::move(opened);
 	}
+	channels = loader->get_channels();
 
-	const int16_t *buf_pos = &buffer[position];
-	if (data_length > length - position) {
-		return std::make_tuple(buf_pos, length - position);
-	} else {
-		return std::make_tuple(buf_pos, data_length);
+	// decode ahead, the data is pinned only while it is used.
+	// data too large for the cache is always streamed.
+	if (cache->fits(loader->get_length() * sizeof(int16_t))) {
+		cache->insert(path, decode());
 	}
 }
 
-// dynamic resource
+shared_pcm_data_t InMemoryResource::decode() {
+	auto in_memory = InMemoryLoader::create(path, format);
+	pcm_data_t data = in_memory->get_resource();
 
-DynamicResource::DynamicResource(category_t category, int id,
-		const std::string &path, format_t format)
-		:
-		Resource{category, id},
-		use_count{0} {
-	loader = DynamicLoader::create(path, format);
-	length = loader->get_length();
-	num_chunks = length / CHUNK_SIZE;
-	if (length % CHUNK_SIZE != 0) {
-		num_chunks++;
+	if (freq != decoder_freq) {
+		data = resample(data, channels, decoder_freq, freq);
 	}
-
-	log::msg("DYNRES: len=%d, chunks=%d", length, num_chunks);
+	return std::make_shared<pcm_data_t>(std::move(data));
 }
 
-void DynamicResource::use() {
-	log::msg("DYNRES: now in use");
-	// if use count was zero
-	if ((use_count++) == 0) {
-		// initialize chunks
-		chunks.reserve(num_chunks);
-		for (int i = 0; i < num_chunks; i++) {
-			chunks.push_back(std::vector<int16_t>{});
-		}
+void InMemoryResource::use() {
+	// if the data was evicted, the sounds stream it
+	if (use_count++ == 0) {
+		samples = cache->find(path);
 	}
 }
 
-void DynamicResource::stop_using() {
-	log::msg("DYNRES: no longer in use");
-	// if use count is now zero
-	if ((--use_count) == 0) {
-		// delete all chunks
-		chunks.clear();
-		chunks.shrink_to_fit();
-		this->running_jobs.clear();
+void InMemoryResource::stop_using() {
+	if (use_count > 0 && --use_count == 0) {
+		samples.reset();
 	}
 }
 
-std::tuple<const int16_t*,uint32_t> DynamicResource::get_data(
-		uint32_t position, uint32_t data_length) {
-	// TODO refactor implementation into single methods, probably change
-	// preloading behavior = rewrite DynamicResource
-	log::msg("DYNRES: request pos=%u, num=%u", position, data_length);
-	// calculate chunk index and offset
-	int chunk_index = position / CHUNK_SIZE;
-	auto chunk_offset = position % CHUNK_SIZE;
-	// the chunk is beyond the end of the resource, so the resource has finished
-	if (chunk_index >= num_chunks) {
-		return std::make_tuple(nullptr, 0);
-	}
-	log::msg(" --> chunk_index=%d, chunk_offset=%d", chunk_index, chunk_offset);
-
-	// if chunk was not found, load it
-	if (chunks[chunk_index].empty()) {
-		auto job_it = this->running_jobs.find(chunk_index);
-		if (job_it == std::end(this->running_jobs)) {
-			load_chunk(chunk_index);
-			return std::make_tuple(nullptr,1);
-		} else {
-			if (job_it->second.is_finished()) {
-				auto result = job_it->second.get_result();
-				chunks[chunk_index].swap(result);
-				this->running_jobs.erase(job_it);
-			} else {
-				return std::make_tuple(nullptr,1);
-			}
-		}
+std::shared_ptr<Stream> InMemoryResource::open_stream() {
+	if (samples) {
+		return {};
 	}
+	return streams->open(loader, cache);
+}
 
-	// preload next chunk
-	if (chunk_index < num_chunks-1 && chunks[chunk_index+1].empty()) {
-		auto nindex = chunk_index+1;
-		auto job_it = this->running_jobs.find(nindex);
-		if (job_it == std::end(this->running_jobs)) {
-			load_chunk(nindex);
-		} else {
-			if (job_it->second.is_finished()) {
-				auto result = job_it->second.get_result();
-				chunks[nindex].swap(result);
-				this->running_jobs.erase(job_it);
-			}
-		}
-	}
+// dynamic resource
 
-	// get chunk and calculate buffer
-	auto buf = &chunks[chunk_index].front() + chunk_offset;
-	if (CHUNK_SIZE - chunk_offset >= data_length) {
-		log::msg(" --> RET %d", data_length);
-		return std::make_tuple(buf, data_length);
+DynamicResource::DynamicResource(category_t category, int id,
+		const std::string &path, StreamWorker *streams, SampleCache *cache,
+		int freq, format_t format)
+		:
+		Resource{category, id},
+		path{path},
+		format{format},
+		streams{streams},
+		cache{cache},
+		freq{freq} {
+}
+
+void DynamicResource::do_load() {
+	// opening the file reads its length and channels
+	auto opened = DynamicLoader::create(path, format);
+	channels = opened->get_channels();
+
+	if (freq != decoder_freq) {
+		loader = std::make_shared<ResamplingLoader>(std::move(opened), decoder_freq, freq);
 	} else {
-		log::msg(" --> RET %d", CHUNK_SIZE - chunk_offset);
-		return std::make_tuple(buf, CHUNK_SIZE - chunk_offset);
+		loader = std::move(opened);
 	}
 }
 
-void DynamicResource::load_chunk(int chunk_index) {
-	auto load_function = [this,chunk_index]() -> std::vector<int16_t> {
-		auto chunk = this->loader->load_chunk(chunk_index*CHUNK_SIZE, CHUNK_SIZE);
-		return std::move(chunk);
-	};
+void DynamicResource::use() {
+	use_count++;
+	// a stream may have cached the data since the resource was used first,
+	// while samples is empty no sound reads it
+	if (!samples) {
+		samples = cache->find(path);
+	}
+}
 
-	Engine &e = Engine::get();
+void DynamicResource::stop_using() {
+	if (use_count > 0 && --use_count == 0) {
+		samples.reset();
+	}
+}
 
-	auto job = e.get_job_manager()->enqueue<std::vector<int16_t>>(load_function);
-	this->running_jobs.insert({chunk_index, job});
+std::shared_ptr<Stream> DynamicResource::open_stream() {
+	// the cached data is played directly
+	if (samples) {
+		return {};
+	}
+	return streams->open(loader, cache);
 }
 
 }
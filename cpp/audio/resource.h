@@ -3,20 +3,16 @@
 #ifndef OPENAGE_AUDIO_RESOURCE_H_
 #define OPENAGE_AUDIO_RESOURCE_H_
 
-#include <atomic>
 #include <memory>
 #include <string>
 #include <tuple>
-#include <unordered_map>
-#include <vector>
-
-#include <SDL2/SDL.h>
 
 #include "category.h"
 #include "dynamic_loader.h"
 #include "format.h"
-#include "../job/job_manager.h"
 #include "loader_policy.h"
+#include "sample_cache.h"
+#include "stream.h"
 #include "types.h"
 
 namespace openage {
@@ -40,6 +36,28 @@ private:
 	 */
 	int id;
 
+protected:
+	/**
+	 * The decoded pcm data while the resource is used, taken from the
+	 * sample cache. The audio thread only reads it with get_data.
+	 */
+	shared_pcm_data_t samples;
+
+	/**
+	 * The number of sounds using the resource.
+	 */
+	uint32_t use_count;
+
+	/**
+	 * Whether load() was called.
+	 */
+	bool loaded;
+
+	/**
+	 * The number of interleaved channels of the data, 1 or 2.
+	 */
+	uint32_t channels;
+
 public:
 	Resource(category_t category, int id);
 	virtual ~Resource() = default;
@@ -53,6 +71,26 @@ public:
 	virtual category_t get_category() const;
 	virtual int get_id() const;
 
+	/**
+	 * Returns the number of interleaved channels of the data returned by
+	 * get_data and by the streams, 1 for mono or 2 for stereo. Only valid
+	 * after load().
+	 */
+	virtual uint32_t get_channels() const;
+
+	/**
+	 * Reads the resource from the filesystem, unless that was done already.
+	 * Resources of different files can be loaded in parallel, one resource
+	 * must only be loaded by one thread. Throws an Error if the file can't
+	 * be read.
+	 */
+	void load();
+
+	/**
+	 * Returns whether the resource was loaded.
+	 */
+	bool is_loaded() const;
+
 	/**
 	 * Tells the resource, that it will be used by a sound object, so it can
 	 * preload some pcm samples.
@@ -66,62 +104,112 @@ public:
 	virtual void stop_using();
 
 	/**
-	 * TODO fix docReturns a pointer to the sample buffer at the given position and the
+	 * Returns a pointer to the sample buffer at the given position and the
 	 * number of samples that are actually available. If the end of the resource
 	 * is reached, 0 will be returned. If the resource is not ready yet, a
 	 * nullptr with a length, different to zero, will be returned.
+	 * Resources without decoded samples always return 0.
 	 * @param position the current position in the resource
 	 * @param num_samples the number of samples that should be returned
 	 */
 	virtual std::tuple<const int16_t*,uint32_t> get_data(uint32_t position,
-			uint32_t data_length) = 0;
+			uint32_t data_length);
+
+	/**
+	 * Returns a new stream of this resource's data for one sound, or an empty
+	 * pointer if the resource's data is read with get_data.
+	 */
+	virtual std::shared_ptr<Stream> open_stream();
 
+protected:
+	/**
+	 * Reads the resource, called once by load().
+	 */
+	virtual void do_load();
+
+public:
+	/**
+	 * Creates a resource with the given loader policy. The resource isn't
+	 * read before load() is called.
+	 * @param streams the worker that fills the streams of dynamic resources
+	 * @param cache keeps the decoded samples of all resources
+	 * @param freq the sample rate the resource is converted to
+	 */
 	static std::shared_ptr<Resource> create_resource(
 		category_t category,
 		int id, const std::string &path, format_t format,
-		loader_policy_t loader_policy
+		loader_policy_t loader_policy, StreamWorker *streams,
+		SampleCache *cache, int freq
 	);
 };
 
 /**
- * A InMemoryResource loads the whole pcm data into memory and keeps it there.
+ * A InMemoryResource decodes the whole pcm data into the sample cache when it
+ * is loaded. The data is converted to the output's sample rate once it is
+ * decoded. If the data was evicted, or is too large for the cache, sounds
+ * stream it like a DynamicResource instead of decoding it on the game thread;
+ * they are silent until the first chunk is decoded, and the stream caches
+ * the data again.
  */
 class InMemoryResource : public Resource {
 private:
-	/** The resource's internal buffer. */
-	pcm_data_t buffer;
+	std::string path;
+	format_t format;
+
+	/**
+	 * Streams the data while it isn't cached.
+	 */
+	std::shared_ptr<DynamicLoader> loader;
+
+	StreamWorker *streams;
+	SampleCache *cache;
+	int freq;
+
+	/**
+	 * Decodes the whole resource.
+	 */
+	shared_pcm_data_t decode();
 
 public:
 	InMemoryResource(
 		category_t category, int id,
 		const std::string &path,
+		StreamWorker *streams, SampleCache *cache, int freq,
 		format_t format=format_t::OPUS
 	);
 	virtual ~InMemoryResource() = default;
 
-	virtual std::tuple<const int16_t*,uint32_t> get_data(
-		uint32_t position,
-		uint32_t data_length
-	);
-};
+	virtual void use();
+	virtual void stop_using();
+
+	virtual std::shared_ptr<Stream> open_stream();
 
-constexpr uint32_t CHUNK_SIZE = 96000;
+protected:
+	virtual void do_load();
+};
 
+/**
+ * A DynamicResource decodes its pcm data while it is played. Every sound
+ * gets its own stream of the data, see Stream. Streams of short resources
+ * also put the decoded data into the sample cache, later sounds play it from
+ * there as long as it is cached. The streaming worker converts the data to
+ * the output's sample rate.
+ */
 class DynamicResource : public Resource {
 private:
-	std::atomic_int use_count;
+	std::string path;
+	format_t format;
 
-	std::vector<pcm_chunk_t> chunks;
-	int num_chunks;
-	uint32_t length;
+	std::shared_ptr<DynamicLoader> loader;
 
-	std::unordered_map<int,job::Job<pcm_chunk_t>> running_jobs;
-
-	std::unique_ptr<DynamicLoader> loader;
+	StreamWorker *streams;
+	SampleCache *cache;
+	int freq;
 
 public:
 	DynamicResource(
 		category_t category, int id, const std::string &path,
+		StreamWorker *streams, SampleCache *cache, int freq,
 		format_t format=format_t::OPUS
 	);
 	virtual ~DynamicResource() = default;
@@ -129,13 +217,10 @@ public:
 	virtual void use();
 	virtual void stop_using();
 
-	virtual std::tuple<const int16_t*,uint32_t> get_data(
-		uint32_t position,
-		uint32_t data_length
-	);
+	virtual std::shared_ptr<Stream> open_stream();
 
-private:
-	void load_chunk(int chunk_index);
+protected:
+	virtual void do_load();
 };
 
 }
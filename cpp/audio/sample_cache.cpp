@@ -0,0 +1,106 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#include "sample_cache.h"
+
+#include "../log.h"
+
+namespace openage {
+namespace audio {
+
+SampleCache::SampleCache(size_t budget)
+		:
+		budget{budget},
+		size{0},
+		hits{0},
+		misses{0} {
+}
+
+shared_pcm_data_t SampleCache::find(const std::string &path) {
+	std::unique_lock<std::mutex> lock{mtx};
+
+	auto it = index.find(path);
+	if (it == std::end(index)) {
+		misses++;
+		return {};
+	}
+
+	hits++;
+	entries.splice(std::begin(entries), entries, it->second);
+	return it->second->data;
+}
+
+shared_pcm_data_t SampleCache::insert(const std::string &path, shared_pcm_data_t data) {
+	size_t bytes = data->size() * sizeof(int16_t);
+
+	std::unique_lock<std::mutex> lock{mtx};
+
+	auto it = index.find(path);
+	if (it != std::end(index)) {
+		entries.splice(std::begin(entries), entries, it->second);
+		return it->second->data;
+	}
+
+	if (bytes > budget / 4) {
+		return data;
+	}
+
+	entries.push_front({path, data, bytes});
+	index.insert({path, std::begin(entries)});
+	size += bytes;
+
+	evict();
+	return data;
+}
+
+bool SampleCache::fits(size_t bytes) const {
+	return bytes <= max_entry_size();
+}
+
+size_t SampleCache::max_entry_size() const {
+	std::unique_lock<std::mutex> lock{mtx};
+	return budget / 4;
+}
+
+void SampleCache::set_budget(size_t budget) {
+	std::unique_lock<std::mutex> lock{mtx};
+	this->budget = budget;
+	evict();
+}
+
+size_t SampleCache::get_budget() const {
+	std::unique_lock<std::mutex> lock{mtx};
+	return budget;
+}
+
+size_t SampleCache::get_size() const {
+	std::unique_lock<std::mutex> lock{mtx};
+	return size;
+}
+
+uint64_t SampleCache::get_hit_count() const {
+	std::unique_lock<std::mutex> lock{mtx};
+	return hits;
+}
+
+uint64_t SampleCache::get_miss_count() const {
+	std::unique_lock<std::mutex> lock{mtx};
+	return misses;
+}
+
+void SampleCache::evict() {
+	auto it = std::end(entries);
+	while (size > budget && it != std::begin(entries)) {
+		--it;
+
+		// the cache holds the only reference, nobody plays the data
+		if (it->data.use_count() == 1) {
+			log::dbg("evicting decoded audio: %s", it->path.c_str());
+			size -= it->bytes;
+			index.erase(it->path);
+			it = entries.erase(it);
+		}
+	}
+}
+
+}
+}
@@ -0,0 +1,114 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#ifndef OPENAGE_AUDIO_SAMPLE_CACHE_H_
+#define OPENAGE_AUDIO_SAMPLE_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "types.h"
+
+namespace openage {
+namespace audio {
+
+/**
+ * The decoded pcm data of a whole resource, shared by the cache and the
+ * resources playing it.
+ */
+using shared_pcm_data_t = std::shared_ptr<const pcm_data_t>;
+
+/**
+ * A SampleCache keeps the decoded pcm data of resources, identified by their
+ * path, within a byte budget. If the budget is exceeded, the least recently
+ * used data is evicted.
+ *
+ * Data is pinned while a reference to it exists outside of the cache, e.g.
+ * while a resource is played. Pinned data is never evicted, so the cache can
+ * exceed its budget if all data is in use.
+ *
+ * The cache is used by the game thread, the streaming worker and the loading
+ * jobs, never by the audio callback.
+ */
+class SampleCache {
+public:
+	/**
+	 * @param budget the number of bytes the cached data may use
+	 */
+	SampleCache(size_t budget);
+
+	SampleCache(const SampleCache&) = delete;
+	SampleCache &operator=(const SampleCache&) = delete;
+
+	/**
+	 * Returns the decoded data of the resource at path, or an empty pointer
+	 * if it isn't cached. Marks the data as recently used.
+	 */
+	shared_pcm_data_t find(const std::string &path);
+
+	/**
+	 * Adds the decoded data of the resource at path, and evicts the least
+	 * recently used data that isn't pinned until the budget is met. Data
+	 * that is larger than max_entry_size() isn't added.
+	 * @returns the cached data, which may have been added before by someone else
+	 */
+	shared_pcm_data_t insert(const std::string &path, shared_pcm_data_t data);
+
+	/**
+	 * Returns whether data of the given size is worth caching, which is
+	 * the case for up to a quarter of the budget.
+	 */
+	bool fits(size_t bytes) const;
+	size_t max_entry_size() const;
+
+	/**
+	 * Changes the budget, and evicts data until it is met.
+	 */
+	void set_budget(size_t budget);
+	size_t get_budget() const;
+
+	/**
+	 * Returns the number of bytes of all cached data.
+	 */
+	size_t get_size() const;
+
+	/**
+	 * Returns how often find() found data, and how often it didn't.
+	 */
+	uint64_t get_hit_count() const;
+	uint64_t get_miss_count() const;
+
+private:
+	/**
+	 * Evicts unpinned data, least recently used first, until the budget is
+	 * met. The mutex must be locked.
+	 */
+	void evict();
+
+	struct entry {
+		std::string path;
+		shared_pcm_data_t data;
+		size_t bytes;
+	};
+
+	mutable std::mutex mtx;
+
+	/** the entries, the most recently used first */
+	std::list<entry> entries;
+	std::unordered_map<std::string,std::list<entry>::iterator> index;
+
+	size_t budget;
+	size_t size;
+
+	uint64_t hits;
+	uint64_t misses;
+};
+
+}
+}
+
+#endif
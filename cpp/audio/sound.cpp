@@ -2,9 +2,11 @@
 
 #include "sound.h"
 
+#include <algorithm>
 #include <tuple>
 
 #include "audio_manager.h"
+#include "mix.h"
 #include "../log.h"
 
 namespace openage {
@@ -26,6 +28,9 @@ int Sound::get_id() const {
 
 void Sound::set_volume(int32_t volume) {
 	sound_impl->volume = volume;
+	if (sound_impl->playing) {
+		audio_manager->send_command({audio_command::type_t::VOLUME, sound_impl, category_t::GAME, volume, false, 0, 0, false, {0, 0, 0}});
+	}
 }
 
 int32_t Sound::get_volume() const {
@@ -34,51 +39,81 @@ int32_t Sound::get_volume() const {
 
 void Sound::set_looping(bool looping) {
 	sound_impl->looping = looping;
+	if (sound_impl->playing) {
+		audio_manager->send_command({audio_command::type_t::LOOPING, sound_impl, category_t::GAME, 0, looping, 0, 0, false, {0, 0, 0}});
+	}
 }
 
 bool Sound::is_looping() const {
 	return sound_impl->looping;
 }
 
-void Sound::play() {
-	if (!sound_impl->in_use) {
-		sound_impl->resource->use();
-		sound_impl->in_use = true;
+void Sound::set_priority(int32_t priority) {
+	sound_impl->priority = priority;
+}
+
+int32_t Sound::get_priority() const {
+	return sound_impl->priority;
+}
+
+void Sound::set_position(const coord::phys3 &position) {
+	sound_impl->positional = true;
+	sound_impl->position = position;
+	if (sound_impl->playing) {
+		audio_manager->send_command({audio_command::type_t::POSITION, sound_impl, category_t::GAME, 0, false, 0, 0, true, position});
 	}
-	sound_impl->offset = 0;
-	if (!sound_impl->playing) {
-		audio_manager->add_sound(sound_impl);
-		sound_impl->playing = true;
+}
+
+bool Sound::is_positional() const {
+	return sound_impl->positional;
+}
+
+coord::phys3 Sound::get_position() const {
+	return sound_impl->position;
+}
+
+void Sound::play() {
+	// another sound of the resource was started in this tick already,
+	// a second voice would only make it louder
+	if (!audio_manager->start_resource(sound_impl->resource.get())) {
+		return;
 	}
+
+	sound_impl->use_resource();
+	sound_impl->release_pending = false;
+	// restarts the sound if it is already playing
+	audio_manager->send_command({audio_command::type_t::PLAY, sound_impl, category_t::GAME,
+			sound_impl->volume, sound_impl->looping, sound_impl->priority, 0,
+			sound_impl->positional, sound_impl->position});
+	sound_impl->playing = true;
 }
 
 void Sound::pause() {
 	if (sound_impl->playing) {
-		audio_manager->remove_sound(sound_impl);
+		audio_manager->send_command({audio_command::type_t::PAUSE, sound_impl, category_t::GAME, 0, false, 0, 0, false, {0, 0, 0}});
 		sound_impl->playing = false;
 	}
 }
 
 void Sound::resume() {
-	if (!sound_impl->in_use) {
-		sound_impl->resource->use();
-		sound_impl->in_use = true;
-	}
+	sound_impl->use_resource();
+	sound_impl->release_pending = false;
 	if (!sound_impl->playing) {
-		audio_manager->add_sound(sound_impl);
+		audio_manager->send_command({audio_command::type_t::RESUME, sound_impl, category_t::GAME,
+				sound_impl->volume, sound_impl->looping, sound_impl->priority, 0,
+				sound_impl->positional, sound_impl->position});
 		sound_impl->playing = true;
 	}
 }
 
 void Sound::stop() {
-	sound_impl->offset = 0;
-	if (sound_impl->playing) {
-		audio_manager->remove_sound(sound_impl);
-		sound_impl->playing = false;
-	}
+	// also sent when paused, to reset the offset
+	audio_manager->send_command({audio_command::type_t::STOP, sound_impl, category_t::GAME, 0, false, 0, 0, false, {0, 0, 0}});
+	sound_impl->playing = false;
+	// the resource may still be mixed until the audio thread
+	// has seen the command, AudioManager::update releases it.
 	if (sound_impl->in_use) {
-		sound_impl->resource->stop_using();
-		sound_impl->in_use = false;
+		sound_impl->release_pending = true;
 	}
 }
 
@@ -92,16 +127,27 @@ SoundImpl::SoundImpl(std::shared_ptr<Resource> resource, int32_t volume)
 		:
 		resource{resource},
 		in_use{false},
+		release_pending{false},
 		volume{volume},
-		offset{0},
+		priority{0},
 		playing{false},
-		looping{false} {
+		looping{false},
+		positional{false},
+		position{0, 0, 0},
+		commands_sent{0},
+		mix_volume{volume},
+		mix_looping{false},
+		mix_priority{0},
+		mix_positional{false},
+		mix_position{0, 0, 0},
+		mix_gain{256, 256},
+		voice_index{0},
+		offset{0},
+		commands_seen{0} {
 }
 
 SoundImpl::~SoundImpl() {
-	if (in_use) {
-		resource->stop_using();
-	}
+	release_resource();
 }
 
 category_t SoundImpl::get_category() const {
@@ -112,31 +158,84 @@ int SoundImpl::get_id() const {
 	return resource->get_id();
 }
 
-bool SoundImpl::mix_audio(int32_t *stream, int length) {
-	uint32_t stream_index = 0;
+void SoundImpl::use_resource() {
+	if (!in_use) {
+		resource->use();
+		stream = resource->open_stream();
+		in_use = true;
+	}
+}
+
+void SoundImpl::release_resource() {
+	if (in_use) {
+		stream.reset();
+		resource->stop_using();
+		in_use = false;
+	}
+}
+
+void SoundImpl::update_gain(const coord::phys3 &listener) {
+	if (mix_positional) {
+		mix_gain = positional_gain(mix_position, listener);
+	} else {
+		mix_gain = {256, 256};
+	}
+}
+
+int32_t SoundImpl::get_audible_volume() const {
+	return mix_volume * std::max(mix_gain.left, mix_gain.right) / 256;
+}
+
+bool SoundImpl::mix_audio(int32_t *buffer, int length) {
+	const mix_functions &mixer = get_mix_functions();
+
+	int32_t left = mix_volume * mix_gain.left / 256;
+	int32_t right = mix_volume * mix_gain.right / 256;
+	// a virtual voice only advances, without touching the buffer
+	bool audible = (left != 0 || right != 0);
+
+	// the buffer is stereo, each value of mono data fills a whole frame
+	uint32_t channels = stream ? stream->get_channels() : resource->get_channels();
+	if (channels == 1) {
+		length /= 2;
+	}
+
+	uint32_t buffer_index = 0;
 	while (length > 0) {
 		const int16_t *data;
 		uint32_t data_length;
-		std::tie(data, data_length) = resource->get_data(offset, length);
+		if (stream) {
+			std::tie(data, data_length) = stream->get_data(length, mix_looping);
+		} else {
+			std::tie(data, data_length) = resource->get_data(offset, length);
+		}
 
 		if (data_length == 0) {
-			if (looping) {
+			if (mix_looping && !stream) {
 				offset = 0;
 			} else {
-				playing = false;
 				return true;
 			}
 		} else if (data == nullptr) {
 			return false;
 		}
 
-		for (uint32_t i = 0; i < data_length; i++) {
-			stream[i+stream_index] += volume * data[i];
+		if (audible) {
+			if (channels == 1) {
+				mixer.accumulate_mono(buffer + buffer_index, data, data_length, left, right);
+			} else if (left == right) {
+				mixer.accumulate(buffer + buffer_index, data, data_length, left);
+			} else {
+				mixer.accumulate_stereo(buffer + buffer_index, data, data_length / 2, left, right);
+			}
 		}
 
+		if (stream) {
+			stream->consume(data_length);
+		}
 		offset += data_length;
 		length -= data_length;
-		stream_index += data_length;
+		buffer_index += (channels == 1) ? 2 * data_length : data_length;
 	}
 
 	return false;
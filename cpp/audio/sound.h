@@ -6,7 +6,10 @@
 #include <memory>
 
 #include "category.h"
+#include "positional.h"
 #include "resource.h"
+#include "stream.h"
+#include "../coord/phys3.h"
 
 namespace openage {
 namespace audio {
@@ -27,19 +30,35 @@ public:
 	 * The shared audio resource, which provides the pcm data to play.
 	 */
 	std::shared_ptr<Resource> resource;
+
+	// The following members are only used by the game thread. It sends
+	// changes to the audio thread with commands, see AudioManager.
+
 	/**
 	 * Whether this sound currently actively uses it's shared audio resource.
 	 */
 	bool in_use;
+	/**
+	 * The sound's own stream of the resource's data, if the resource is
+	 * streamed. It is set while the sound is in use, the audio thread only
+	 * reads from it.
+	 */
+	std::shared_ptr<Stream> stream;
+	/**
+	 * Whether the resource should be released, once the audio thread has
+	 * stopped using the sound.
+	 */
+	bool release_pending;
 
 	/**
 	 * The sounds volume.
 	 */
 	int32_t volume;
 	/**
-	 * The sounds playing offset.
+	 * The sounds priority, sounds with a higher priority take the voices
+	 * of lower ones.
 	 */
-	uint32_t offset;
+	int32_t priority;
 
 	/**
 	 * Whether this sound is currently playing.
@@ -49,6 +68,51 @@ public:
 	 * Whether this sound is currently looping.
 	 */
 	bool looping;
+	/**
+	 * Whether this sound is played at a position.
+	 */
+	bool positional;
+	/**
+	 * The sound's position, if it is positional.
+	 */
+	coord::phys3 position;
+
+	/**
+	 * The number of commands sent to the audio thread about this sound.
+	 */
+	uint32_t commands_sent;
+
+	// The following members are only used by the audio thread.
+
+	/**
+	 * The volume and looping state the sound is mixed with.
+	 */
+	int32_t mix_volume;
+	bool mix_looping;
+	int32_t mix_priority;
+	bool mix_positional;
+	coord::phys3 mix_position;
+
+	/**
+	 * The gains of the channels at the sound's position, updated for
+	 * each audio callback.
+	 */
+	stereo_gain mix_gain;
+
+	/**
+	 * When the sound's voice was started, larger is newer.
+	 */
+	uint64_t voice_index;
+
+	/**
+	 * The sounds playing offset.
+	 */
+	uint32_t offset;
+
+	/**
+	 * The number of commands the audio thread has processed about this sound.
+	 */
+	uint32_t commands_seen;
 
 	SoundImpl(std::shared_ptr<Resource> resource, int32_t volume=128);
 	~SoundImpl();
@@ -62,13 +126,35 @@ public:
 	 */
 	int get_id() const;
 
+	/**
+	 * Starts using the resource, if it isn't already in use.
+	 */
+	void use_resource();
+	/**
+	 * Stops using the resource. The audio thread must be done with the sound.
+	 */
+	void release_resource();
+
+	/**
+	 * Updates the channel gains for a listener position. Only called by
+	 * the audio thread.
+	 */
+	void update_gain(const coord::phys3 &listener);
+
+	/**
+	 * Returns the volume of the louder channel, which is 0 for virtual
+	 * voices. Only called by the audio thread.
+	 */
+	int32_t get_audible_volume() const;
+
 	/*
-	 * Mix this sound with the given pcm stream and return whether it has
-	 * finished or not.
-	 * @param stream the stream to mix with
+	 * Mix this sound into the given mix buffer and return whether it has
+	 * finished or not. Inaudible sounds only advance their playing offset.
+	 * Only called by the audio thread.
+	 * @param buffer the mix buffer to mix with
 	 * @param length the number of values that should mixed
 	 */
-	bool mix_audio(int32_t *stream, int length);
+	bool mix_audio(int32_t *buffer, int length);
 
 };
 
@@ -77,6 +163,10 @@ public:
  * control the sound, e.g. play, stop, etc. It is a lightweight object that
  * stores a shared_ptr to its internal SoundImpl and a pointer to its
  * AudioManager.
+ *
+ * Sounds must only be used from the game thread. Changes reach the audio
+ * thread with its next callback, so is_playing() becomes false only after
+ * the AudioManager has been updated.
  */
 class Sound {
 private:
@@ -124,7 +214,37 @@ public:
 	bool is_looping() const;
 
 	/**
-	 * Resets the sound to it's beginning and starts playing it.
+	 * Sets this sound's priority. If a voice limit is reached, a new sound
+	 * takes the voice of an inaudible sound, or of a sound with a lower or
+	 * equal priority, otherwise it isn't played. The default priority is 0.
+	 * @param priority the new priority
+	 */
+	void set_priority(int32_t priority);
+	/**
+	 * Returns this sound's priority.
+	 */
+	int32_t get_priority() const;
+
+	/**
+	 * Plays this sound at a position, which pans and attenuates it relative
+	 * to the AudioManager's listener. Sounds aren't positional until their
+	 * position is set.
+	 * @param position the new position
+	 */
+	void set_position(const coord::phys3 &position);
+	/**
+	 * Returns whether this sound is played at a position.
+	 */
+	bool is_positional() const;
+	/**
+	 * Returns this sound's position, if it is positional.
+	 */
+	coord::phys3 get_position() const;
+
+	/**
+	 * Resets the sound to it's beginning and starts playing it. If another
+	 * sound of the same resource was started since the last
+	 * AudioManager::update(), the sound isn't started.
 	 */
 	void play();
 	/**
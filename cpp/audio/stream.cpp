@@ -0,0 +1,260 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#include "stream.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include "../log.h"
+#include "../util/error.h"
+
+namespace openage {
+namespace audio {
+
+Stream::Stream(std::shared_ptr<DynamicLoader> loader, uint32_t chunk_count,
+		std::atomic<uint64_t> *underruns, SampleCache *cache)
+		:
+		loader{loader},
+		length{loader->get_length()},
+		channels{loader->get_channels()},
+		chunk_count{std::max<uint32_t>(chunk_count, 2)},
+		written{0},
+		consumed{0},
+		generation{0},
+		failed{false},
+		read_generation{0},
+		chunk_offset{0},
+		at_start{true},
+		underruns{underruns},
+		fill_generation{0},
+		fill_position{0},
+		cache{cache} {
+	if (cache != nullptr && !cache->fits(static_cast<size_t>(length) * sizeof(int16_t))) {
+		this->cache = nullptr;
+	}
+	samples.reset(new int16_t[static_cast<size_t>(this->chunk_count) * stream_chunk_size]);
+	chunks.reset(new chunk_info[this->chunk_count]);
+}
+
+std::tuple<const int16_t*,uint32_t> Stream::get_data(uint32_t data_length, bool looping) {
+	if (failed.load(std::memory_order_relaxed) || length == 0) {
+		return std::make_tuple(nullptr, 0);
+	}
+
+	while (true) {
+		uint32_t index = consumed.load(std::memory_order_relaxed);
+		if (index == written.load(std::memory_order_acquire)) {
+			// silence before the first chunk is expected
+			if (!at_start) {
+				underruns->fetch_add(1, std::memory_order_relaxed);
+			}
+			return std::make_tuple(nullptr, data_length);
+		}
+
+		const chunk_info &chunk = chunks[index % chunk_count];
+
+		// drop chunks decoded before a restart, and finished chunks
+		if (chunk.generation != read_generation || chunk_offset >= chunk.length) {
+			bool ends = (chunk.generation == read_generation && chunk.ends);
+			chunk_offset = 0;
+			consumed.store(index + 1, std::memory_order_release);
+
+			if (ends && !looping) {
+				return std::make_tuple(nullptr, 0);
+			}
+			continue;
+		}
+
+		at_start = false;
+		const int16_t *data = &samples[static_cast<size_t>(index % chunk_count) * stream_chunk_size + chunk_offset];
+		return std::make_tuple(data, std::min(data_length, chunk.length - chunk_offset));
+	}
+}
+
+uint32_t Stream::get_channels() const {
+	return channels;
+}
+
+void Stream::consume(uint32_t data_length) {
+	chunk_offset += data_length;
+}
+
+void Stream::restart() {
+	// nothing was played yet, so the decoded chunks are still valid
+	if (at_start && chunk_offset == 0) {
+		return;
+	}
+
+	read_generation++;
+	generation.store(read_generation, std::memory_order_release);
+	chunk_offset = 0;
+	at_start = true;
+}
+
+void Stream::fill() {
+	if (failed.load(std::memory_order_relaxed)) {
+		return;
+	}
+
+	while (true) {
+		uint32_t current_generation = generation.load(std::memory_order_acquire);
+		if (current_generation != fill_generation) {
+			fill_generation = current_generation;
+			fill_position = 0;
+		}
+
+		uint32_t index = written.load(std::memory_order_relaxed);
+		if (index - consumed.load(std::memory_order_acquire) >= chunk_count) {
+			return;
+		}
+
+		uint32_t chunk_length = std::min(stream_chunk_size, length - fill_position);
+		size_t slot = index % chunk_count;
+		bool short_read = false;
+
+		// the decoder stays open, so sequential chunks are decoded without
+		// reopening or seeking, and directly into the ring
+		try {
+			if (!decoder) {
+				decoder = loader->open_decoder();
+			}
+			uint32_t read = decoder->read(fill_position, &samples[slot * stream_chunk_size], chunk_length);
+			if (read < chunk_length) {
+				// the decoded resource is shorter than announced
+				chunk_length = read;
+				short_read = true;
+			}
+		} catch (util::Error &e) {
+			log::err("stream decoding failed: %s", e.str());
+			failed.store(true, std::memory_order_relaxed);
+			return;
+		}
+
+		chunks[slot].generation = fill_generation;
+		chunks[slot].length = chunk_length;
+		chunks[slot].ends = short_read || (fill_position + chunk_length >= length);
+
+		if (cache != nullptr) {
+			collect(slot, chunk_length, chunks[slot].ends);
+		}
+
+		written.store(index + 1, std::memory_order_release);
+
+		fill_position += chunk_length;
+		if (chunks[slot].ends) {
+			fill_position = 0;
+		}
+	}
+}
+
+void Stream::collect(size_t slot, uint32_t chunk_length, bool ends) {
+	// only data decoded in one go from the beginning is complete,
+	// after a restart the collection starts again
+	if (fill_position != collected.size()) {
+		collected.clear();
+		if (fill_position != 0) {
+			return;
+		}
+	}
+	if (collected.capacity() == 0) {
+		collected.reserve(length);
+	}
+
+	const int16_t *chunk = &samples[slot * stream_chunk_size];
+	collected.insert(std::end(collected), chunk, chunk + chunk_length);
+
+	if (ends) {
+		cache->insert(loader->get_path(), std::make_shared<pcm_data_t>(std::move(collected)));
+		collected = pcm_data_t{};
+		cache = nullptr;
+	}
+}
+
+// streaming worker
+
+StreamWorker::StreamWorker(uint32_t read_ahead, unsigned poll_msec)
+		:
+		read_ahead{read_ahead},
+		poll_msec{poll_msec},
+		underruns{0},
+		quit{false},
+		added{false} {
+}
+
+StreamWorker::~StreamWorker() {
+	if (thread.joinable()) {
+		{
+			std::unique_lock<std::mutex> lock{mtx};
+			quit = true;
+		}
+		wakeup.notify_all();
+		thread.join();
+	}
+}
+
+std::shared_ptr<Stream> StreamWorker::open(std::shared_ptr<DynamicLoader> loader,
+		SampleCache *cache) {
+	auto stream = std::make_shared<Stream>(loader, read_ahead, &underruns, cache);
+
+	{
+		std::unique_lock<std::mutex> lock{mtx};
+		streams.push_back(stream);
+		added = true;
+	}
+
+	if (!thread.joinable()) {
+		thread = std::thread{&StreamWorker::run, this};
+	}
+	wakeup.notify_all();
+
+	return stream;
+}
+
+void StreamWorker::set_read_ahead(uint32_t chunks) {
+	read_ahead = chunks;
+}
+
+uint32_t StreamWorker::get_read_ahead() const {
+	return read_ahead;
+}
+
+uint64_t StreamWorker::get_underrun_count() const {
+	return underruns.load(std::memory_order_relaxed);
+}
+
+void StreamWorker::run() {
+	std::vector<std::shared_ptr<Stream>> active;
+
+	std::unique_lock<std::mutex> lock{mtx};
+	while (!quit) {
+		// take the streams that are still in use
+		active.clear();
+		for (size_t i = 0; i < streams.size(); i++) {
+			auto stream = streams[i].lock();
+			if (stream) {
+				active.push_back(std::move(stream));
+			} else {
+				streams[i] = std::move(streams.back());
+				streams.pop_back();
+				i--;
+			}
+		}
+		added = false;
+
+		lock.unlock();
+		for (auto &stream : active) {
+			stream->fill();
+		}
+		// streams may be destroyed here, outside of the lock
+		active.clear();
+		lock.lock();
+
+		wakeup.wait_for(lock, std::chrono::milliseconds(poll_msec), [this] {
+			return quit || added;
+		});
+	}
+}
+
+}
+}
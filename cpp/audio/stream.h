@@ -0,0 +1,197 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#ifndef OPENAGE_AUDIO_STREAM_H_
+#define OPENAGE_AUDIO_STREAM_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "dynamic_loader.h"
+#include "sample_cache.h"
+
+namespace openage {
+namespace audio {
+
+/**
+ * The number of int16_t values in one chunk of a stream.
+ */
+constexpr uint32_t stream_chunk_size = 16384;
+
+/**
+ * The pcm data of one playing sound of a DynamicResource. A streaming worker
+ * decodes it ahead of the playhead into a fixed ring of pre-allocated chunks,
+ * and the audio callback reads the ring.
+ *
+ * The two threads only communicate through atomic counters, the callback
+ * never waits, allocates or frees memory. If a chunk isn't decoded in time,
+ * the callback plays silence and counts an underrun.
+ *
+ * The worker keeps one decoder open per stream, which only seeks after a
+ * restart and at the end of the resource. There the worker continues from
+ * its beginning, so looping needs no seek by the callback.
+ *
+ * If the resource fits the sample cache, the worker also collects the
+ * decoded data, and caches it once the whole resource was decoded.
+ */
+class Stream {
+public:
+	/**
+	 * Creates a stream of the loader's resource.
+	 * @param loader decodes the chunks
+	 * @param chunk_count the number of chunks decoded ahead
+	 * @param underruns counter to increment on underruns
+	 * @param cache receives the whole decoded data, may be nullptr
+	 */
+	Stream(std::shared_ptr<DynamicLoader> loader, uint32_t chunk_count,
+			std::atomic<uint64_t> *underruns, SampleCache *cache=nullptr);
+
+	Stream(const Stream&) = delete;
+	Stream &operator=(const Stream&) = delete;
+
+	// called by the audio thread
+
+	/**
+	 * Returns a pointer to the next decoded samples and their number, at most
+	 * data_length. Like Resource::get_data, the end of the stream is a
+	 * length of 0, and missing data a nullptr with a length different to zero.
+	 * @param data_length the number of samples that should be returned
+	 * @param looping whether to continue at the beginning after the end
+	 */
+	std::tuple<const int16_t*,uint32_t> get_data(uint32_t data_length, bool looping);
+
+	/**
+	 * Returns the number of interleaved channels of the data, 1 or 2.
+	 */
+	uint32_t get_channels() const;
+
+	/**
+	 * Marks samples returned by get_data as played.
+	 */
+	void consume(uint32_t data_length);
+
+	/**
+	 * Starts the stream from its beginning. The decoded chunks are dropped,
+	 * until the worker has caught up, the stream is silent.
+	 */
+	void restart();
+
+	// called by the streaming worker
+
+	/**
+	 * Decodes chunks until the ring is full.
+	 */
+	void fill();
+
+private:
+	/**
+	 * Appends a decoded chunk to the collected data, and caches the data
+	 * at the end of the resource.
+	 */
+	void collect(size_t slot, uint32_t chunk_length, bool ends);
+
+	struct chunk_info {
+		uint32_t generation;
+		uint32_t length;
+		/** whether the chunk contains the end of the resource */
+		bool ends;
+	};
+
+	std::shared_ptr<DynamicLoader> loader;
+	uint32_t length;
+	uint32_t channels;
+	uint32_t chunk_count;
+
+	std::unique_ptr<int16_t[]> samples;
+	std::unique_ptr<chunk_info[]> chunks;
+
+	/** the number of chunks written by the worker */
+	std::atomic<uint32_t> written;
+	/** the number of chunks played by the callback */
+	std::atomic<uint32_t> consumed;
+	/** incremented by the callback for each restart */
+	std::atomic<uint32_t> generation;
+	/** set by the worker, if the resource can't be decoded */
+	std::atomic<bool> failed;
+
+	// only used by the callback
+	uint32_t read_generation;
+	uint32_t chunk_offset;
+	bool at_start;
+	std::atomic<uint64_t> *underruns;
+
+	// only used by the worker
+	/** opened with the first fill, kept open while the stream exists */
+	std::unique_ptr<DynamicDecoder> decoder;
+	uint32_t fill_generation;
+	uint32_t fill_position;
+
+	/** the cache to put the collected data in, nullptr once done */
+	SampleCache *cache;
+	/** the data decoded from the beginning of the resource so far */
+	pcm_data_t collected;
+};
+
+/**
+ * A thread that keeps the chunk rings of all streams filled.
+ */
+class StreamWorker {
+public:
+	/**
+	 * @param read_ahead the number of chunks new streams decode ahead
+	 * @param poll_msec how often the streams are refilled
+	 */
+	StreamWorker(uint32_t read_ahead=8, unsigned poll_msec=10);
+
+	/**
+	 * Stops the worker thread.
+	 */
+	~StreamWorker();
+
+	StreamWorker(const StreamWorker&) = delete;
+	StreamWorker &operator=(const StreamWorker&) = delete;
+
+	/**
+	 * Creates a stream filled by this worker. The worker thread is started
+	 * with the first stream. The stream is dropped by the worker once all
+	 * other references to it are gone.
+	 * @param cache receives the whole decoded data, may be nullptr
+	 */
+	std::shared_ptr<Stream> open(std::shared_ptr<DynamicLoader> loader,
+			SampleCache *cache=nullptr);
+
+	/**
+	 * Sets the number of chunks new streams decode ahead of the playhead.
+	 */
+	void set_read_ahead(uint32_t chunks);
+	uint32_t get_read_ahead() const;
+
+	/**
+	 * Returns how often a stream had no decoded data when it was played.
+	 */
+	uint64_t get_underrun_count() const;
+
+private:
+	void run();
+
+	uint32_t read_ahead;
+	unsigned poll_msec;
+
+	std::atomic<uint64_t> underruns;
+
+	std::thread thread;
+	std::mutex mtx;
+	std::condition_variable wakeup;
+	bool quit;
+	bool added;
+	std::vector<std::weak_ptr<Stream>> streams;
+};
+
+}
+}
+
+#endif
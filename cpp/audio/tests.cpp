@@ -0,0 +1,890 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../log.h"
+#include "audio_manager.h"
+#include "mix.h"
+#include "null_device.h"
+#include "positional.h"
+#include "resample.h"
+#include "sample_cache.h"
+#include "stream.h"
+#include "wav_writer.h"
+
+namespace openage {
+namespace audio {
+namespace tests {
+
+namespace {
+
+/**
+ * fill with deterministic samples from a linear congruential generator,
+ * including the extreme values.
+ */
+void fill_samples(std::vector<int16_t> *samples, uint32_t state) {
+	for (size_t i = 0; i < samples->size(); i++) {
+		state = state * 1103515245 + 12345;
+		(*samples)[i] = static_cast<int16_t>(state >> 16);
+	}
+	if (samples->size() >= 2) {
+		(*samples)[0] = 32767;
+		(*samples)[1] = -32768;
+	}
+}
+
+/**
+ * a resource whose sample at position i is i % 30000,
+ * counting the opened decoders and their seeks.
+ */
+class CountingLoader : public DynamicLoader {
+public:
+	CountingLoader(uint32_t length)
+		:
+		DynamicLoader{"counting"},
+		decoders{0},
+		seeks{0},
+		length{length} {
+	}
+
+	virtual uint32_t get_length() {
+		return this->length;
+	}
+
+	virtual uint32_t get_channels() {
+		return 2;
+	}
+
+	virtual std::unique_ptr<DynamicDecoder> open_decoder() {
+		this->decoders += 1;
+		return std::unique_ptr<DynamicDecoder>{new CountingDecoder{this}};
+	}
+
+	std::atomic<int> decoders;
+	std::atomic<int> seeks;
+
+private:
+	class CountingDecoder : public DynamicDecoder {
+	public:
+		CountingDecoder(CountingLoader *loader)
+			:
+			loader{loader},
+			position{0} {
+		}
+
+		virtual uint32_t read(uint32_t offset, int16_t *buffer, uint32_t length) {
+			if (offset != this->position) {
+				this->loader->seeks += 1;
+			}
+			uint32_t i = 0;
+			for (; i < length and offset + i < this->loader->length; i++) {
+				buffer[i] = static_cast<int16_t>((offset + i) % 30000);
+			}
+			this->position = offset + i;
+			return i;
+		}
+
+	private:
+		CountingLoader *loader;
+		uint32_t position;
+	};
+
+	uint32_t length;
+};
+
+/**
+ * read from the stream like the audio callback, and compare with the
+ * expected samples starting at position.
+ * @returns the number of samples read, or -1 if a sample was wrong.
+ */
+int read_stream(Stream *stream, uint32_t *position, uint32_t count, uint32_t length, bool looping) {
+	int read = 0;
+	while (count > 0) {
+		const int16_t *data;
+		uint32_t data_length;
+		std::tie(data, data_length) = stream->get_data(count, looping);
+		if (data == nullptr) {
+			return read;
+		}
+		for (uint32_t i = 0; i < data_length; i++) {
+			if (data[i] != static_cast<int16_t>(*position % 30000)) {
+				return -1;
+			}
+			*position = (*position + 1) % length;
+		}
+		stream->consume(data_length);
+		read += data_length;
+		count -= data_length;
+	}
+	return read;
+}
+
+/**
+ * a resource with generated samples.
+ */
+class SyntheticResource : public Resource {
+public:
+	SyntheticResource(category_t category, int id, pcm_data_t &&data)
+		:
+		Resource{category, id} {
+		this->samples = std::make_shared<pcm_data_t>(std::move(data));
+	}
+};
+
+/**
+ * creates a resource of the given length, with a constant value.
+ */
+std::shared_ptr<Resource> constant_resource(int id, size_t length, int16_t value) {
+	return std::make_shared<SyntheticResource>(category_t::GAME, id, pcm_data_t(length, value));
+}
+
+} // anonymous namespace
+
+/**
+ * compares the selected mixing kernels with the scalar ones,
+ * with lengths and offsets that don't fit whole vectors.
+ */
+void mix_kernels() {
+	int stage = 0;
+
+	const mix_functions &simd = get_mix_functions();
+	const mix_functions &scalar = get_scalar_mix_functions();
+
+	const size_t count = 1037;
+	const int32_t volumes[] = {0, 1, 77, 256, 300, -5, 70000};
+	const int32_t gains[] = {0, 100, 256, 512};
+
+	std::vector<int16_t> samples(count + 1);
+	std::vector<int32_t> expected(count + 1), result(count + 1);
+	std::vector<int32_t> bus(count + 1);
+	std::vector<int32_t> stereo_expected(2 * count + 2), stereo_result(2 * count + 2);
+	std::vector<int16_t> out_expected(count + 1), out_result(count + 1);
+
+	log::msg("testing %s mixing kernels", simd.name);
+
+	fill_samples(&samples, 1);
+	for (int32_t volume : volumes) {
+		for (size_t start = 0; start < 2; start++) {
+			std::fill(expected.begin(), expected.end(), 1000);
+			std::fill(result.begin(), result.end(), 1000);
+			scalar.accumulate(&expected[start], &samples[start], count - start, volume);
+			simd.accumulate(&result[start], &samples[start], count - start, volume);
+			if (expected != result) { goto out; }
+
+			// mono samples fill both channels of a stereo frame
+			std::fill(stereo_expected.begin(), stereo_expected.end(), 1000);
+			std::fill(stereo_result.begin(), stereo_result.end(), 1000);
+			scalar.accumulate_mono(&stereo_expected[2 * start], &samples[start], count - start, volume, volume);
+			simd.accumulate_mono(&stereo_result[2 * start], &samples[start], count - start, volume, volume);
+			if (stereo_expected != stereo_result) { goto out; }
+
+			// and each channel with its own volume
+			std::fill(stereo_expected.begin(), stereo_expected.end(), 1000);
+			std::fill(stereo_result.begin(), stereo_result.end(), 1000);
+			scalar.accumulate_mono(&stereo_expected[2 * start], &samples[start], count - start, volume / 2, -volume);
+			simd.accumulate_mono(&stereo_result[2 * start], &samples[start], count - start, volume / 2, -volume);
+			if (stereo_expected != stereo_result) { goto out; }
+			if (stereo_result[2 * count] != stereo_result[2 * count + 1]) { goto out; }
+
+			// panned stereo frames
+			if (start == 0) {
+				std::fill(expected.begin(), expected.end(), 1000);
+				std::fill(result.begin(), result.end(), 1000);
+				scalar.accumulate_stereo(expected.data(), samples.data(), count / 2, volume, volume / 3);
+				simd.accumulate_stereo(result.data(), samples.data(), count / 2, volume, volume / 3);
+				if (expected != result) { goto out; }
+			}
+		}
+	}
+	stage += 1;
+
+	// a bus of several loud sounds, which overflows 16 bits
+	std::fill(bus.begin(), bus.end(), 0);
+	for (uint32_t voice = 0; voice < 8; voice++) {
+		fill_samples(&samples, voice + 2);
+		scalar.accumulate(bus.data(), samples.data(), count, 256);
+	}
+	for (int32_t gain : gains) {
+		for (size_t start = 0; start < 2; start++) {
+			std::fill(expected.begin(), expected.end(), -3);
+			std::fill(result.begin(), result.end(), -3);
+			scalar.add_bus(&expected[start], &bus[start], count - start, gain);
+			simd.add_bus(&result[start], &bus[start], count - start, gain);
+			if (expected != result) { goto out; }
+		}
+	}
+	stage += 1;
+
+	// a gain of 256 leaves the bus unchanged
+	std::fill(result.begin(), result.end(), 0);
+	simd.add_bus(result.data(), bus.data(), count, 256);
+	if (result != bus) { goto out; }
+	stage += 1;
+
+	for (size_t start = 0; start < 2; start++) {
+		scalar.saturate(&out_expected[start], &bus[start], count - start);
+		simd.saturate(&out_result[start], &bus[start], count - start);
+		if (out_expected != out_result) { goto out; }
+	}
+	stage += 1;
+
+	{
+		const int32_t values[] = {32767 * 256 + 255, 40000 * 256, -40000 * 256, -1, 255, 256, -256, -257};
+		const int16_t clamped[] = {32767, 32767, -32768, -1, 0, 1, -1, -2};
+		int16_t out[8];
+		simd.saturate(out, values, 8);
+		for (size_t i = 0; i < 8; i++) {
+			if (out[i] != clamped[i]) { goto out; }
+		}
+	}
+
+	return;
+
+out:
+	log::err("mix kernel test failed at stage %d", stage);
+	throw "mix kernel test failed";
+}
+
+/**
+ * reads streams filled directly and by the streaming worker.
+ */
+void stream() {
+	int stage = 0;
+
+	const uint32_t length = stream_chunk_size * 5 + 1000;
+	auto loader = std::make_shared<CountingLoader>(length);
+	std::atomic<uint64_t> underruns{0};
+	uint32_t position = 0;
+
+	Stream direct{loader, 3, &underruns};
+
+	// nothing decoded yet, silence but no underrun
+	if (read_stream(&direct, &position, 100, length, false) != 0) { goto out; }
+	if (underruns.load() != 0) { goto out; }
+	stage += 1;
+
+	// the ring holds 3 chunks, reading more is an underrun
+	direct.fill();
+	if (read_stream(&direct, &position, stream_chunk_size * 4, length, false) != int(stream_chunk_size * 3)) { goto out; }
+	if (underruns.load() != 1) { goto out; }
+	stage += 1;
+
+	// one decoder reads the chunks sequentially, without seeking
+	if (loader->decoders.load() != 1 or loader->seeks.load() != 0) { goto out; }
+	stage += 1;
+
+	// continue to the end, which ends the stream without an underrun
+	direct.fill();
+	if (read_stream(&direct, &position, length, length, false) != int(stream_chunk_size * 2 + 1000)) { goto out; }
+	if (position != 0 or underruns.load() != 1) { goto out; }
+	stage += 1;
+
+
+	// restarting drops the chunks decoded after the end,
+	// and starts silently without an underrun
+	direct.restart();
+	if (read_stream(&direct, &position, 100, length, false) != 0) { goto out; }
+	direct.fill();
+	if (read_stream(&direct, &position, 100, length, false) != 100) { goto out; }
+	if (underruns.load() != 1) { goto out; }
+	stage += 1;
+
+	// continuing at the beginning is the only seek
+	if (loader->decoders.load() != 1 or loader->seeks.load() != 1) { goto out; }
+	stage += 1;
+
+	{
+		// the worker keeps up with a looping stream read in callback sized
+		// steps, the stream continues at its beginning after the end
+		StreamWorker worker{4, 1};
+		auto looping = worker.open(loader);
+		uint32_t loop_position = 0;
+		uint32_t total = 0;
+		int waits = 0;
+		while (total < length * 2 and waits < 10000) {
+			int read = read_stream(looping.get(), &loop_position, 2048, length, true);
+			if (read < 0) { goto out; }
+			if (read < 2048) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				waits += 1;
+			}
+			total += read;
+		}
+		if (total < length * 2) { goto out; }
+	}
+
+	return;
+
+out:
+	log::err("stream test failed at stage %d", stage);
+	throw "stream test failed";
+}
+
+/**
+ * converts sample rates of whole resources and while streaming.
+ */
+void resample() {
+	int stage = 0;
+
+	const int rates[][2] = {{48000, 44100}, {48000, 22050}, {48000, 96000}, {44100, 48000}};
+	const uint32_t length = 20000 * 2 + 2;
+	pcm_data_t source(length);
+	for (uint32_t i = 0; i < length; i++) {
+		source[i] = static_cast<int16_t>(i % 30000);
+	}
+
+	{
+		// mono data of a ramp stays on the ramp
+		pcm_data_t ramp(1001);
+		for (size_t i = 0; i < ramp.size(); i++) {
+			ramp[i] = static_cast<int16_t>(i * 30);
+		}
+		pcm_data_t half = audio::resample(ramp, 1, 48000, 24000);
+		if (half.size() != 501) { goto out; }
+		for (size_t i = 0; i < half.size(); i++) {
+			if (half[i] != static_cast<int16_t>(i * 60)) { goto out; }
+		}
+		pcm_data_t doubled = audio::resample(ramp, 1, 24000, 48000);
+		if (doubled.size() != 2001) { goto out; }
+		for (size_t i = 0; i < doubled.size(); i++) {
+			if (doubled[i] != static_cast<int16_t>(i * 15)) { goto out; }
+		}
+	}
+	stage += 1;
+
+	for (auto &rate : rates) {
+		pcm_data_t expected = audio::resample(source, 2, rate[0], rate[1]);
+		ResamplingLoader resampled{std::unique_ptr<DynamicLoader>{new CountingLoader{length}}, rate[0], rate[1]};
+		if (resampled.get_length() != expected.size()) { goto out; }
+
+		// sequential reads of odd sizes match the whole conversion
+		auto decoder = resampled.open_decoder();
+		pcm_data_t streamed(expected.size() + 1000);
+		uint32_t position = 0;
+		uint32_t step = 998;
+		while (true) {
+			uint32_t read = decoder->read(position, &streamed[position], step);
+			position += read;
+			if (read < step) {
+				break;
+			}
+			step = (step == 998) ? 4002 : 998;
+		}
+		if (position != expected.size()) { goto out; }
+		if (not std::equal(expected.begin(), expected.end(), streamed.begin())) { goto out; }
+
+		// reading after a seek continues at the right frame
+		uint32_t offset = (expected.size() / 3) & ~1u;
+		if (decoder->read(offset, &streamed[0], 100) != 100) { goto out; }
+		if (not std::equal(&streamed[0], &streamed[100], &expected[offset])) { goto out; }
+		stage += 1;
+	}
+
+	return;
+
+out:
+	log::err("resample test failed at stage %d", stage);
+	throw "resample test failed";
+}
+
+/**
+ * evicts the least recently used unpinned data from the sample cache,
+ * and caches streamed resources.
+ */
+void sample_cache() {
+	int stage = 0;
+
+	// 1000 bytes per entry, 4 fit
+	SampleCache cache{4000};
+	auto make_data = [](size_t bytes) {
+		return std::make_shared<pcm_data_t>(bytes / sizeof(int16_t), 1);
+	};
+	shared_pcm_data_t pinned;
+	const uint32_t length = stream_chunk_size * 2 + 100;
+	auto loader = std::make_shared<CountingLoader>(length);
+	std::atomic<uint64_t> underruns{0};
+	uint32_t position = 0;
+
+	cache.insert("a", make_data(1000));
+	cache.insert("b", make_data(1000));
+	pinned = cache.insert("c", make_data(1000));
+	cache.insert("d", make_data(1000));
+	if (cache.get_size() != 4000) { goto out; }
+	stage += 1;
+
+	// a is used again, so b is the least recently used
+	if (not cache.find("a")) { goto out; }
+	cache.insert("e", make_data(1000));
+	if (cache.find("b") or not cache.find("a") or cache.get_size() != 4000) { goto out; }
+	stage += 1;
+
+	// c is the least recently used now, but it is pinned
+	cache.find("d");
+	cache.find("a");
+	cache.find("e");
+	cache.insert("f", make_data(1000));
+	if (not cache.find("c") or cache.find("d")) { goto out; }
+	stage += 1;
+
+	// shrinking the budget keeps only the pinned data
+	cache.set_budget(1000);
+	if (cache.get_size() != 1000 or not cache.find("c")) { goto out; }
+	pinned.reset();
+	stage += 1;
+
+	// data larger than a quarter of the budget isn't cached
+	cache.set_budget(4000);
+	cache.insert("g", make_data(2000));
+	if (cache.find("g")) { goto out; }
+	if (cache.get_hit_count() == 0 or cache.get_miss_count() == 0) { goto out; }
+	stage += 1;
+
+	{
+		// a short streamed resource is cached once it was decoded completely
+		SampleCache stream_cache{length * sizeof(int16_t) * 4};
+		// the ring holds 2 of the 3 chunks
+		Stream stream{loader, 2, &underruns, &stream_cache};
+		stream.fill();
+		if (stream_cache.find("counting")) { goto out; }
+		if (read_stream(&stream, &position, stream_chunk_size * 2, length, false) != int(stream_chunk_size * 2)) { goto out; }
+		stream.fill();
+
+		auto cached = stream_cache.find("counting");
+		if (not cached or cached->size() != length) { goto out; }
+		for (uint32_t i = 0; i < length; i++) {
+			if ((*cached)[i] != static_cast<int16_t>(i % 30000)) { goto out; }
+		}
+	}
+
+	return;
+
+out:
+	log::err("sample cache test failed at stage %d", stage);
+	throw "sample cache test failed";
+}
+
+/**
+ * limits and steals voices of an audio manager without an audio device.
+ */
+void voice_limits() {
+	int stage = 0;
+
+	AudioManager manager{AudioManager::null_device, 48000, AUDIO_S16SYS, 2, 256};
+	NullAudioDevice device{&manager};
+	const int16_t *out;
+	std::vector<Sound> crowd;
+	size_t crowd_playing = 0;
+
+	for (int id = 0; id < 8; id++) {
+		manager.add_resource(constant_resource(id, 48000 * 2, 100));
+	}
+	manager.set_voice_limit(category_t::GAME, 4);
+	manager.set_resource_voice_limit(2);
+
+	Sound first = manager.get_sound(category_t::GAME, 0);
+	Sound duplicate = manager.get_sound(category_t::GAME, 0);
+	Sound second = manager.get_sound(category_t::GAME, 0);
+	Sound third = manager.get_sound(category_t::GAME, 0);
+	Sound others[] = {
+		manager.get_sound(category_t::GAME, 1),
+		manager.get_sound(category_t::GAME, 2),
+		manager.get_sound(category_t::GAME, 3),
+	};
+	Sound unimportant = manager.get_sound(category_t::GAME, 4);
+
+	// the same resource is started only once per tick
+	first.play();
+	duplicate.play();
+	if (not first.is_playing() or duplicate.is_playing()) { goto out; }
+	stage += 1;
+
+	manager.update();
+	second.play();
+	device.render();
+	manager.update();
+	if (not first.is_playing() or not second.is_playing()) { goto out; }
+	stage += 1;
+
+	// the resource's third voice takes the oldest one
+	third.play();
+	device.render();
+	manager.update();
+	if (first.is_playing() or not second.is_playing() or not third.is_playing()) { goto out; }
+	stage += 1;
+
+	// the category's fifth voice takes the oldest one again
+	for (auto &sound : others) {
+		sound.play();
+	}
+	device.render();
+	manager.update();
+	if (second.is_playing() or not third.is_playing()) { goto out; }
+	for (auto &sound : others) {
+		if (not sound.is_playing()) { goto out; }
+	}
+	stage += 1;
+
+	// a sound with a lower priority than all voices isn't played
+	unimportant.set_priority(-1);
+	unimportant.play();
+	out = device.render();
+	manager.update();
+	if (unimportant.is_playing()) { goto out; }
+	stage += 1;
+
+	// four voices of 100 at half volume
+	for (size_t i = 0; i < device.get_buffer_length(); i++) {
+		if (out[i] != 200) { goto out; }
+	}
+	stage += 1;
+
+	// more sounds than fit the playing list in one callback,
+	// the stolen voices wait there to be handed back
+	manager.set_voice_limit(category_t::GAME, 48);
+	for (int id = 8; id < 268; id++) {
+		manager.add_resource(constant_resource(id, 48000 * 2, 100));
+		crowd.push_back(manager.get_sound(category_t::GAME, id));
+		crowd.back().play();
+	}
+	device.render();
+	manager.update();
+	for (auto &sound : crowd) {
+		if (sound.is_playing()) {
+			crowd_playing += 1;
+		}
+	}
+	if (crowd_playing != 48 or not crowd.back().is_playing()) { goto out; }
+	for (auto &sound : others) {
+		if (sound.is_playing()) { goto out; }
+	}
+
+	return;
+
+out:
+	log::err("voice limit test failed at stage %d", stage);
+	throw "voice limit test failed";
+}
+
+/**
+ * pans, attenuates and virtualizes positional sounds around the listener.
+ */
+void positional() {
+	int stage = 0;
+
+	AudioManager manager{AudioManager::null_device, 48000, AUDIO_S16SYS, 2, 256};
+	NullAudioDevice device{&manager};
+	const size_t length = device.get_buffer_length();
+	const int16_t *out;
+
+	// positions on the screen's horizontal axis, in tile widths
+	auto at = [](coord::phys_t x) {
+		return coord::phys3{x * coord::settings::phys_per_tile, x * coord::settings::phys_per_tile, 0};
+	};
+	const coord::phys3 listener = at(10);
+
+	manager.add_resource(constant_resource(0, length * 3, 100));
+	manager.add_resource(constant_resource(1, length * 100, 100));
+	manager.add_resource(constant_resource(2, length * 100, 100));
+	manager.set_listener(listener);
+
+	Sound close = manager.get_sound(category_t::GAME, 1);
+	Sound far = manager.get_sound(category_t::GAME, 0);
+	Sound stealing = manager.get_sound(category_t::GAME, 2);
+	stereo_gain gain;
+
+	gain = positional_gain(listener, listener);
+	if (gain.left != 256 or gain.right != 256) { goto out; }
+	gain = positional_gain(at(14), listener);
+	if (gain.left != 128 or gain.right != 256) { goto out; }
+	gain = positional_gain(at(-3), listener);
+	if (gain.left != 128 or gain.right != 0) { goto out; }
+	gain = positional_gain(at(35), listener);
+	if (gain.left != 0 or gain.right != 0) { goto out; }
+	stage += 1;
+
+	// half volume, half a pan to the right
+	close.set_position(at(14));
+	close.play();
+	out = device.render();
+	manager.update();
+	for (size_t i = 0; i < length; i += 2) {
+		if (out[i] != 25 or out[i + 1] != 50) { goto out; }
+	}
+	stage += 1;
+
+	// the listener follows the sound
+	manager.set_listener(at(14));
+	out = device.render();
+	manager.update();
+	for (size_t i = 0; i < length; i++) {
+		if (out[i] != 50) { goto out; }
+	}
+	stage += 1;
+
+	// an inaudible sound isn't mixed, but still ends in time
+	far.set_position(at(100));
+	far.play();
+	for (int i = 0; i < 4; i++) {
+		out = device.render();
+		manager.update();
+		for (size_t j = 0; j < length; j++) {
+			if (out[j] != 50) { goto out; }
+		}
+		if (i == 2 and not far.is_playing()) { goto out; }
+	}
+	if (far.is_playing()) { goto out; }
+	stage += 1;
+
+	// a virtual voice is stolen before an older audible one,
+	// even with a higher priority
+	manager.set_voice_limit(category_t::GAME, 2);
+	far.set_looping(true);
+	far.set_priority(1);
+	far.play();
+	device.render();
+	manager.update();
+	stealing.play();
+	device.render();
+	manager.update();
+	if (far.is_playing() or not close.is_playing() or not stealing.is_playing()) { goto out; }
+
+	return;
+
+out:
+	log::err("positional audio test failed at stage %d", stage);
+	throw "positional audio test failed";
+}
+
+/**
+ * mixes many voices in four categories per simulated audio callback,
+ * with the scalar and with the selected kernels.
+ *
+ * arguments: [voices] [callbacks] [samples per callback]
+ */
+void mix_benchmark(int argc, char **argv) {
+	int voices    = (argc > 1) ? atoi(argv[1]) : 64;
+	int callbacks = (argc > 2) ? atoi(argv[2]) : 2000;
+	int length    = (argc > 3) ? atoi(argv[3]) : 4096 * 2;
+
+	if (voices <= 0 or callbacks <= 0 or length <= 0) {
+		return;
+	}
+
+	const size_t clip_length = 48000 * 2;
+	const int32_t category_gains[] = {256, 200, 128, 256};
+
+	std::vector<std::vector<int16_t>> clips(voices, std::vector<int16_t>(clip_length));
+	for (int v = 0; v < voices; v++) {
+		fill_samples(&clips[v], v + 1);
+	}
+
+	std::vector<int32_t> mix(length), bus(length);
+	std::vector<int16_t> out(length);
+
+	printf("%d voices, %d samples per callback, %.1f ms of audio at 48 kHz stereo\n",
+	       voices, length, length / 96.0);
+
+	const mix_functions *kernels[] = {&get_scalar_mix_functions(), &get_mix_functions()};
+	double means[2];
+
+	for (int k = 0; k < 2; k++) {
+		const mix_functions &mixer = *kernels[k];
+		std::vector<size_t> offsets(voices, 0);
+		std::vector<double> times;
+		times.reserve(callbacks);
+		int64_t checksum = 0;
+
+		for (int c = 0; c < callbacks; c++) {
+			auto start = std::chrono::steady_clock::now();
+
+			std::memset(mix.data(), 0, length * sizeof(int32_t));
+			for (int category = 0; category < 4; category++) {
+				std::memset(bus.data(), 0, length * sizeof(int32_t));
+				for (int v = category; v < voices; v += 4) {
+					// loop the clip like a looping sound would
+					int done = 0;
+					while (done < length) {
+						size_t n = std::min<size_t>(length - done, clip_length - offsets[v]);
+						mixer.accumulate(&bus[done], &clips[v][offsets[v]], n, 64 + v % 192);
+						offsets[v] = (offsets[v] + n) % clip_length;
+						done += n;
+					}
+				}
+				mixer.add_bus(mix.data(), bus.data(), length, category_gains[category]);
+			}
+			mixer.saturate(out.data(), mix.data(), length);
+
+			auto end = std::chrono::steady_clock::now();
+			times.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+			checksum += out[c % length];
+		}
+
+		std::sort(std::begin(times), std::end(times));
+		double sum = 0;
+		for (double t : times) {
+			sum += t;
+		}
+		means[k] = sum / times.size();
+
+		printf("%s per callback: mean %.1f us, median %.1f us, p99 %.1f us, max %.1f us (checksum %lld)\n",
+		       mixer.name, means[k],
+		       times[times.size() / 2],
+		       times[times.size() * 99 / 100],
+		       times.back(),
+		       (long long) checksum);
+	}
+
+	printf("speedup %.2fx\n", means[0] / means[1]);
+}
+
+/**
+ * plays random sounds from a set of generated ones in each tick, and
+ * measures the audio callback of an audio manager without an audio device.
+ *
+ * arguments: [sounds per tick] [seconds] [offline|fast|realtime] [wav file] [spread]
+ *
+ * offline renders one callback per tick on the main thread, which makes the
+ * output reproducible. fast and realtime pull the callbacks on the device
+ * thread. In realtime mode, the main thread plays sounds at 60 ticks per
+ * second. In fast mode both threads run as fast as they can in lockstep:
+ * the device renders one buffer per tick, while the main thread plays the
+ * next tick, so each callback gets the sounds of one tick.
+ *
+ * If spread is given, the sounds are positional, and placed randomly up to
+ * spread tile widths to the right of the listener. Sounds beyond the
+ * audible distance are virtual voices, e.g. of a battle off the screen.
+ */
+void audio_benchmark(int argc, char **argv) {
+	int sounds_per_tick = (argc > 1) ? atoi(argv[1]) : 8;
+	double seconds      = (argc > 2) ? atof(argv[2]) : 10;
+	std::string mode    = (argc > 3) ? argv[3] : "offline";
+	std::string wav     = (argc > 4) ? argv[4] : "";
+	double spread       = (argc > 5) ? atof(argv[5]) : 0;
+
+	if (sounds_per_tick < 0 or seconds <= 0) {
+		return;
+	}
+	if (mode != "offline" and mode != "fast" and mode != "realtime") {
+		printf("unknown mode %s, use offline, fast or realtime\n", mode.c_str());
+		return;
+	}
+
+	const int freq = 48000;
+	const int resource_count = 32;
+
+	AudioManager manager{AudioManager::null_device, freq, AUDIO_S16SYS, 2, 1024};
+	NullAudioDevice device{&manager};
+
+	// noise bursts between 0.1 and 2 seconds, fading out
+	for (int id = 0; id < resource_count; id++) {
+		size_t length = 2 * (freq / 10 + id * (freq * 19 / 10) / (resource_count - 1));
+		pcm_data_t data(length);
+		fill_samples(&data, id + 1);
+		for (size_t i = 0; i < length; i++) {
+			data[i] = static_cast<int16_t>(data[i] / 4 * static_cast<int64_t>(length - i) / length);
+		}
+		manager.add_resource(std::make_shared<SyntheticResource>(category_t::GAME, id, std::move(data)));
+	}
+
+	std::unique_ptr<WavWriter> writer;
+	if (not wav.empty()) {
+		writer.reset(new WavWriter{wav, freq, 2});
+		device.set_output([&writer](const int16_t *data, size_t length) {
+			writer->write(data, length);
+		});
+	}
+
+	uint32_t state = 1;
+	auto play_sounds = [&]() {
+		for (int i = 0; i < sounds_per_tick; i++) {
+			state = state * 1103515245 + 12345;
+			Sound sound = manager.get_sound(category_t::GAME, (state >> 16) % resource_count);
+			sound.set_volume(64 + (state >> 8) % 192);
+			if (spread > 0) {
+				// along the screen's horizontal axis
+				state = state * 1103515245 + 12345;
+				coord::phys_t x = static_cast<coord::phys_t>(spread * coord::settings::phys_per_tile * (state >> 16) / 65536);
+				sound.set_position(coord::phys3{x, x, 0});
+			}
+			sound.play();
+		}
+		manager.update();
+	};
+
+	printf("%d sounds per tick for %.1f s, %s, %.1f ms per callback\n",
+	       sounds_per_tick, seconds, mode.c_str(), device.get_buffer_usec() / 1000);
+
+	if (mode == "offline") {
+		int callbacks = static_cast<int>(seconds * 1e6 / device.get_buffer_usec());
+		for (int c = 0; c < callbacks; c++) {
+			play_sounds();
+			device.render();
+		}
+	} else {
+		if (mode == "fast") {
+			device.set_render_limit(0);
+		}
+		device.start(mode == "realtime");
+		auto start = std::chrono::steady_clock::now();
+		auto tick = std::chrono::microseconds(1000000 / 60);
+		auto next = start;
+		uint64_t ticks = 0;
+		while (std::chrono::steady_clock::now() - start < std::chrono::duration<double>(seconds)) {
+			if (mode == "realtime") {
+				play_sounds();
+				next += tick;
+				std::this_thread::sleep_until(next);
+			} else if (ticks <= device.get_render_count() + 1) {
+				// the next tick, while the device renders the previous one
+				play_sounds();
+				ticks++;
+				device.set_render_limit(ticks);
+			} else {
+				std::this_thread::yield();
+			}
+		}
+		device.stop();
+	}
+	manager.update();
+
+	std::vector<double> times = device.get_callback_times();
+	if (times.empty()) {
+		return;
+	}
+	std::sort(std::begin(times), std::end(times));
+	double sum = 0;
+	size_t over_budget = 0;
+	for (double t : times) {
+		sum += t;
+		if (t > device.get_buffer_usec()) {
+			over_budget += 1;
+		}
+	}
+	auto percentile = [&times](double p) {
+		return times[std::min(times.size() - 1, static_cast<size_t>(times.size() * p))];
+	};
+
+	printf("%zu callbacks: mean %.1f us, p50 %.1f us, p90 %.1f us, p99 %.1f us, p99.9 %.1f us, max %.1f us\n",
+	       times.size(), sum / times.size(),
+	       percentile(0.5), percentile(0.9), percentile(0.99), percentile(0.999),
+	       times.back());
+	printf("%zu callbacks over budget, %llu late callbacks, %llu stream underruns\n",
+	       over_budget,
+	       static_cast<unsigned long long>(device.get_late_count()),
+	       static_cast<unsigned long long>(manager.get_underrun_count()));
+	if (writer) {
+		printf("wrote %s\n", wav.c_str());
+	}
+}
+
+} // namespace tests
+} // namespace audio
+} // namespace openage
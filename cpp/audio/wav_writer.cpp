@@ -0,0 +1,72 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#include "wav_writer.h"
+
+#include "../log.h"
+#include "../util/error.h"
+
+namespace openage {
+namespace audio {
+
+namespace {
+
+void put_le(FILE *file, uint32_t value, int bytes) {
+	for (int i = 0; i < bytes; i++) {
+		fputc((value >> (8 * i)) & 0xff, file);
+	}
+}
+
+} // anonymous namespace
+
+WavWriter::WavWriter(const std::string &path, int freq, int channels)
+		:
+		path{path},
+		file{fopen(path.c_str(), "wb")},
+		freq{freq},
+		channels{channels},
+		data_bytes{0} {
+	if (file == nullptr) {
+		throw util::Error{"could not create %s", path.c_str()};
+	}
+	write_header();
+}
+
+WavWriter::~WavWriter() {
+	// the sizes in the header are known now
+	fseek(file, 0, SEEK_SET);
+	write_header();
+	if (fclose(file) != 0) {
+		log::err("could not write %s", path.c_str());
+	}
+}
+
+void WavWriter::write(const int16_t *data, size_t length) {
+	// the samples are stored in little endian
+	for (size_t i = 0; i < length; i++) {
+		put_le(file, static_cast<uint16_t>(data[i]), 2);
+	}
+	data_bytes += length * sizeof(int16_t);
+}
+
+void WavWriter::write_header() {
+	uint32_t block_align = channels * sizeof(int16_t);
+
+	fputs("RIFF", file);
+	put_le(file, 36 + data_bytes, 4);
+	fputs("WAVE", file);
+
+	fputs("fmt ", file);
+	put_le(file, 16, 4);
+	put_le(file, 1, 2);  // integer pcm
+	put_le(file, channels, 2);
+	put_le(file, freq, 4);
+	put_le(file, freq * block_align, 4);
+	put_le(file, block_align, 2);
+	put_le(file, 16, 2);
+
+	fputs("data", file);
+	put_le(file, data_bytes, 4);
+}
+
+}
+}
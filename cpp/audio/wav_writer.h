@@ -0,0 +1,53 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#ifndef OPENAGE_AUDIO_WAV_WRITER_H_
+#define OPENAGE_AUDIO_WAV_WRITER_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+namespace openage {
+namespace audio {
+
+/**
+ * Writes 16 bit signed integer pcm data to a WAV file, e.g. to compare the
+ * output of the mixer before and after a change.
+ */
+class WavWriter {
+public:
+	/**
+	 * Creates the file. Throws an Error if that fails.
+	 */
+	WavWriter(const std::string &path, int freq, int channels);
+
+	/**
+	 * Completes the header and closes the file.
+	 */
+	~WavWriter();
+
+	WavWriter(const WavWriter&) = delete;
+	WavWriter &operator=(const WavWriter&) = delete;
+
+	/**
+	 * Appends the given number of int16_t values.
+	 */
+	void write(const int16_t *data, size_t length);
+
+private:
+	/**
+	 * Writes the header for the data written so far.
+	 */
+	void write_header();
+
+	std::string path;
+	FILE *file;
+	int freq;
+	int channels;
+	uint32_t data_bytes;
+};
+
+}
+}
+
+#endif
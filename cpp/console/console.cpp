@@ -4,6 +4,7 @@
 
 #include "draw.h"
 #include "../callbacks.h"
+#include "../engine.h"
 #include "../log.h"
 #include "../util/error.h"
 #include "../util/strings.h"
@@ -75,7 +76,7 @@ bool Console::on_drawhud() {
 		return true;
 	}
 
-	draw::to_opengl(this);
+	draw::to_commands(this, Engine::get().get_render_commands());
 
 	return true;
 }
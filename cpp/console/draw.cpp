@@ -6,7 +6,6 @@
 #include <stdio.h>
 #include <stdlib.h>
 
-#include "../crossplatform/opengl.h"
 #include <FTGL/ftgl.h>
 
 #include <unistd.h>
@@ -17,7 +16,7 @@ namespace openage {
 namespace console {
 namespace draw {
 
-void to_opengl(Console *console) {
+void to_commands(Console *console, renderer::CommandList &commands) {
 	coord::camhud topleft = {
 		console->bottomleft.x,
 		console->bottomleft.y + console->charsize.y * console->buf.dims.y
@@ -58,25 +57,22 @@ void to_opengl(Console *console) {
 				fgcolid = bgcolid;
 			}
 
-			console->termcolors[bgcolid].use(0.8);
+			commands.set_color(console->termcolors[bgcolid], 0.8);
 
-			glBegin(GL_QUADS);
-			{
-				glVertex3f(chartopleft.x, chartopleft.y, 0);
-				glVertex3f(chartopleft.x, chartopleft.y - console->charsize.y, 0);
-				glVertex3f(chartopleft.x + console->charsize.x, chartopleft.y - console->charsize.y, 0);
-				glVertex3f(chartopleft.x + console->charsize.x, chartopleft.y, 0);
-			}
-			glEnd();
+			commands.begin_quads();
+			commands.vertex(chartopleft.x, chartopleft.y);
+			commands.vertex(chartopleft.x, chartopleft.y - console->charsize.y);
+			commands.vertex(chartopleft.x + console->charsize.x, chartopleft.y - console->charsize.y);
+			commands.vertex(chartopleft.x + console->charsize.x, chartopleft.y);
 
-			console->termcolors[fgcolid].use(1);
+			commands.set_color(console->termcolors[fgcolid], 1);
 
 			char utf8buf[5];
 			if (util::utf8_encode(p.cp, utf8buf) == 0) {
 				//unrepresentable character (question mark in black rhombus)
-				console->font.render_static(chartopleft.x, chartopleft.y - ascender, "\uFFFD");
+				commands.text(&console->font, chartopleft.x, chartopleft.y - ascender, "\uFFFD");
 			} else {
-				console->font.render_static(chartopleft.x, chartopleft.y - ascender, utf8buf);
+				commands.text(&console->font, chartopleft.x, chartopleft.y - ascender, utf8buf);
 			}
 		}
 	}
@@ -8,6 +8,7 @@
 #include "console.h"
 #include "../coord/camhud.h"
 #include "../font.h"
+#include "../renderer/command_list.h"
 #include "../util/fds.h"
 
 namespace openage {
@@ -16,9 +17,10 @@ namespace console {
 namespace draw {
 
 /**
- * experimental and totally inefficient opengl draw of a terminal buffer.
+ * experimental and totally inefficient drawing of a terminal buffer,
+ * recorded to a render command list.
  */
-void to_opengl(Console *console);
+void to_commands(Console *console, renderer::CommandList &commands);
 
 /**
  * very early and inefficient printing of the console to a pty.
@@ -58,8 +58,9 @@ window camgame::to_window() {
 }
 
 window_delta camgame_delta::to_window() {
-	//the direction of the y axis is flipped
-	return window_delta {(pixel_t) x, (pixel_t) -y};
+	Engine &e = Engine::get();
+	//the direction of the y axis is flipped, and the camera may be zoomed
+	return window_delta {(pixel_t) (x * e.camgame_zoom), (pixel_t) (-y * e.camgame_zoom)};
 }
 
 } //namespace coord
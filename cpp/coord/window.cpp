@@ -16,8 +16,9 @@ camgame window::to_camgame() const {
 }
 
 camgame_delta window_delta::to_camgame() const {
-	//the direction of the y axis is flipped
-	return camgame_delta {(pixel_t) x, (pixel_t) -y};
+	Engine &e = Engine::get();
+	//the direction of the y axis is flipped, and the camera may be zoomed
+	return camgame_delta {(pixel_t) (x / e.camgame_zoom), (pixel_t) (-y / e.camgame_zoom)};
 }
 
 camhud window::to_camhud() const {
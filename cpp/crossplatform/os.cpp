@@ -3,6 +3,7 @@
 #include "os.h"
 
 #include <memory>
+#include <sys/stat.h>
 
 #ifdef WIN32
 // TODO not yet implemented
@@ -97,5 +98,14 @@ int execute_file(const char *path, bool background) {
 	#endif
 }
 
+uint64_t mtime_nsec(const struct stat &st) {
+	#ifdef __APPLE__
+	const struct timespec &mtime = st.st_mtimespec;
+	#else
+	const struct timespec &mtime = st.st_mtim;
+	#endif
+	return (uint64_t) mtime.tv_sec * 1000000000 + mtime.tv_nsec;
+}
+
 } // namespace os
 } // namespace openage
@@ -3,8 +3,11 @@
 #ifndef OPENAGE_CROSSPLATFORM_OS_H_
 #define OPENAGE_CROSSPLATFORM_OS_H_
 
+#include <cstdint>
 #include <string>
 
+struct stat;
+
 namespace openage {
 
 /**
@@ -27,6 +30,11 @@ std::string self_exec_filename();
  */
 int execute_file(const char *path, bool background=true);
 
+/**
+ * the modification time of a stat() result, in nanoseconds
+ */
+uint64_t mtime_nsec(const struct stat &st);
+
 } // namespace os
 } // namespace openage
 
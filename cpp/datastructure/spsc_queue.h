@@ -0,0 +1,152 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#ifndef OPENAGE_DATASTRUCTURE_SPSC_QUEUE_H_
+#define OPENAGE_DATASTRUCTURE_SPSC_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace openage {
+namespace datastructure {
+
+/**
+ * Bounded lock-free queue for exactly one producer and one consumer thread.
+ *
+ * All slots are allocated in the constructor. Pushing and popping
+ * neither locks nor allocates, so the queue can pass data to or from
+ * a realtime thread. Popped items are moved out of their slot, which
+ * keeps the moved-from value until it is overwritten by a later push.
+ */
+template <class T>
+class SPSCQueue {
+public:
+	/**
+	 * The capacity is rounded up to a power of two.
+	 */
+	SPSCQueue(size_t capacity)
+		:
+		head{0},
+		tail{0},
+		tail_cache{0},
+		head_cache{0} {
+
+		size_t size = 1;
+		while (size < capacity) {
+			size *= 2;
+		}
+		this->mask = size - 1;
+		this->slots.reset(new T[size]);
+	}
+
+	SPSCQueue(const SPSCQueue &) = delete;
+	SPSCQueue &operator =(const SPSCQueue &) = delete;
+
+	/**
+	 * Append an item, only call this from the producer thread.
+	 * O(1)
+	 *
+	 * @returns false if the queue is full, the item is left untouched then.
+	 */
+	bool push(T &&item) {
+		size_t pos = this->tail.load(std::memory_order_relaxed);
+		if (not this->has_space(pos)) {
+			return false;
+		}
+		this->slots[pos & this->mask] = std::move(item);
+		this->tail.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool push(const T &item) {
+		size_t pos = this->tail.load(std::memory_order_relaxed);
+		if (not this->has_space(pos)) {
+			return false;
+		}
+		this->slots[pos & this->mask] = item;
+		this->tail.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * Move the oldest item out of the queue, only call this
+	 * from the consumer thread.
+	 * O(1)
+	 *
+	 * @returns false if the queue is empty.
+	 */
+	bool pop(T *item) {
+		size_t pos = this->head.load(std::memory_order_relaxed);
+		if (pos == this->tail_cache) {
+			this->tail_cache = this->tail.load(std::memory_order_acquire);
+			if (pos == this->tail_cache) {
+				return false;
+			}
+		}
+		*item = std::move(this->slots[pos & this->mask]);
+		this->head.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * The number of items that fit in the queue.
+	 */
+	size_t capacity() const {
+		return this->mask + 1;
+	}
+
+	/**
+	 * Whether the next push would fail. Only exact on the producer thread,
+	 * the consumer may pop concurrently.
+	 */
+	bool full() {
+		return not this->has_space(this->tail.load(std::memory_order_relaxed));
+	}
+
+	/**
+	 * Whether the queue is empty. Only exact on the consumer thread,
+	 * the producer may push concurrently.
+	 */
+	bool empty() const {
+		return this->head.load(std::memory_order_relaxed) == this->tail.load(std::memory_order_acquire);
+	}
+
+private:
+	bool has_space(size_t pos) {
+		if (pos - this->head_cache > this->mask) {
+			this->head_cache = this->head.load(std::memory_order_acquire);
+			if (pos - this->head_cache > this->mask) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	std::unique_ptr<T[]> slots;
+	size_t mask;
+
+	// the indices only grow, they are masked to find the slot.
+	// each one is written by one thread, and kept on its own
+	// cache line so the threads don't slow down each other.
+
+	/** next item to pop, written by the consumer */
+	std::atomic<size_t> head;
+	char pad0[64 - sizeof(std::atomic<size_t>)];
+
+	/** next slot to push to, written by the producer */
+	std::atomic<size_t> tail;
+	char pad1[64 - sizeof(std::atomic<size_t>)];
+
+	/** last tail seen by the consumer */
+	size_t tail_cache;
+	char pad2[64 - sizeof(size_t)];
+
+	/** last head seen by the producer */
+	size_t head_cache;
+};
+
+} // namespace datastructure
+} // namespace openage
+
+#endif
@@ -2,9 +2,13 @@
 
 #include "tests.h"
 
+#include <memory>
+#include <thread>
+
 #include "../log.h"
 #include "../datastructure/doubly_linked_list.h"
 #include "../datastructure/pairing_heap.h"
+#include "../datastructure/spsc_queue.h"
 
 
 namespace openage {
@@ -207,6 +211,77 @@ out:
 	throw "linked lisst test failed";
 }
 
+void spsc_queue() {
+	int stage = 0;
+
+	SPSCQueue<std::unique_ptr<int>> queue{3};
+	std::unique_ptr<int> item;
+	size_t received = 0;
+	bool ordered = true;
+
+	if (not (queue.capacity() == 4)) { goto out; }
+	if (not (queue.empty() and not queue.pop(&item))) { goto out; }
+	stage += 1;
+
+	for (int i = 0; i < 4; i++) {
+		if (not queue.push(std::unique_ptr<int>{new int{i}})) { goto out; }
+	}
+	stage += 1;
+
+	// a rejected item stays with the caller
+	item.reset(new int{4});
+	if (queue.push(std::move(item))) { goto out; }
+	if (not (item and *item == 4)) { goto out; }
+	stage += 1;
+
+	for (int i = 0; i < 4; i++) {
+		if (not (queue.pop(&item) and *item == i)) { goto out; }
+	}
+	if (not (queue.empty() and not queue.pop(&item))) { goto out; }
+	stage += 1;
+
+	// the indices wrap around the slots
+	for (int i = 0; i < 10; i++) {
+		if (not queue.push(std::unique_ptr<int>{new int{i}})) { goto out; }
+		if (not (queue.pop(&item) and *item == i)) { goto out; }
+	}
+	stage += 1;
+
+	{
+		// one producer and one consumer thread,
+		// everything arrives once and in order
+		const size_t count = 200000;
+		SPSCQueue<size_t> numbers{64};
+
+		std::thread consumer{[&] {
+			size_t value;
+			while (received < count) {
+				if (numbers.pop(&value)) {
+					if (value != received) {
+						ordered = false;
+					}
+					received += 1;
+				}
+			}
+		}};
+
+		for (size_t i = 0; i < count; i++) {
+			while (not numbers.push(i)) {
+				std::this_thread::yield();
+			}
+		}
+		consumer.join();
+
+		if (not (ordered and received == count and numbers.empty())) { goto out; }
+	}
+
+	return;
+
+out:
+	log::err("spsc queue test failed at stage %d", stage);
+	throw "spsc queue test failed";
+}
+
 } // namespace tests
 } // namespace datastructure
 } // namespace openage
@@ -2,6 +2,7 @@
 
 #include "engine.h"
 
+#include <chrono>
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
@@ -65,10 +66,17 @@ Engine::Engine(util::Dir *data_dir, const char *windowtitle)
 	window_size{800, 600},
 	camgame_phys{10 * coord::settings::phys_per_tile, 10 * coord::settings::phys_per_tile, 0},
 	camgame_window{400, 300},
+	camgame_zoom{1},
 	camhud_window{0, 600},
 	tile_halfsize{48, 24},  // TODO: get from convert script
 	data_dir{data_dir},
-	audio_manager{48000, AUDIO_S16LSB, 2, 4096},
+	simulation_clock{50, 5},  // 20 ticks per second, catch up 250ms at most
+	pipelined_simulation{true},
+	audio_manager{48000, AUDIO_S16SYS, 2, 4096},
+	recording_commands{&this->render_commands},
+	last_simulation_msec{0},
+	last_render_msec{0},
+	last_batch_stats{},
 	dejavuserif20{new Font{"DejaVu Serif", "Book", 20}},
 	dejavuserif12{new Font{"DejaVu Serif", "Book", 12}}
 {
@@ -173,6 +181,7 @@ Engine::Engine(util::Dir *data_dir, const char *windowtitle)
 
 Engine::~Engine() {
 	delete this->job_manager;
+	this->gl_backend.release_gl();
 	SDL_GL_DeleteContext(glcontext);
 	SDL_DestroyWindow(window);
 	IMG_Quit();
@@ -212,7 +221,7 @@ bool Engine::on_resize(coord::window new_size) {
 }
 
 bool Engine::draw_debug_overlay() {
-	util::col {255, 255, 255, 255}.use();
+	this->hud_commands.set_color(util::col {255, 255, 255, 255});
 
 	// Draw FPS counter in the lower right corner
 	this->dejavuserif20->render(
@@ -230,6 +239,35 @@ bool Engine::draw_debug_overlay() {
 		"%s", config::config_option_string
 	);
 
+	// sprite batching counters of the last frame
+	this->dejavuserif12->render(
+		this->window_size.x - 520, 35,
+		"%zu sprites, %zu draw calls, %zu state changes, %zu buffer uploads, %zu impostor renders",
+		this->last_batch_stats.sprites,
+		this->last_batch_stats.draw_calls,
+		this->last_batch_stats.state_changes(),
+		this->last_batch_stats.static_uploads,
+		this->last_batch_stats.impostor_renders
+	);
+	this->dejavuserif12->render(
+		this->window_size.x - 520, 55,
+		"%.1f ms simulation%s, %.1f ms rendering, %llu audio underruns",
+		this->last_simulation_msec,
+		this->pipelined_simulation ? " (pipelined)" : "",
+		this->last_render_msec,
+		static_cast<unsigned long long>(this->audio_manager.get_underrun_count())
+	);
+
+	audio::SampleCache &sample_cache = this->audio_manager.get_sample_cache();
+	this->dejavuserif12->render(
+		this->window_size.x - 520, 75,
+		"%.1f of %.1f MiB decoded audio cached, %llu hits, %llu misses",
+		sample_cache.get_size() / (1024.0 * 1024.0),
+		sample_cache.get_budget() / (1024.0 * 1024.0),
+		static_cast<unsigned long long>(sample_cache.get_hit_count()),
+		static_cast<unsigned long long>(sample_cache.get_miss_count())
+	);
+
 	return true;
 }
 
@@ -248,70 +286,138 @@ void Engine::stop() {
 void Engine::loop() {
 	SDL_Event event;
 
-	while (this->running) {
-		this->fpscounter.frame();
+	try {
+		while (this->running) {
+			this->fpscounter.frame();
 
-		while (SDL_PollEvent(&event)) {
-			for (auto &action : this->on_input_event) {
-				if (false == action->on_input(&event)) {
-					break;
+			// the simulation ticks of the last frame must be done
+			// before anything can look at or change the game state again.
+			this->simulation_worker.wait();
+
+			while (SDL_PollEvent(&event)) {
+				for (auto &action : this->on_input_event) {
+					if (false == action->on_input(&event)) {
+						break;
+					}
 				}
 			}
-		}
 
-		// call engine tick callback methods
-		for (auto &action : this->on_engine_tick) {
-			if (false == action->on_tick()) {
-				break;
+			// call engine tick callback methods
+			for (auto &action : this->on_engine_tick) {
+				if (false == action->on_tick()) {
+					break;
+				}
 			}
-		}
 
-		// clear the framebuffer to black
-		// in the future, we might disable it for lazy drawing
-		glClearColor(0.0, 0.0, 0.0, 0.0);
-		glClear(GL_COLOR_BUFFER_BIT);
+			// sounds are heard from the camera position, and take back
+			// the sounds the audio callback is done with
+			this->audio_manager.set_listener(this->camgame_phys);
+			this->audio_manager.update();
 
-		glPushMatrix(); {
-			// set the framebuffer up for camgame rendering
-			glTranslatef(camgame_window.x, camgame_window.y, 0);
+			unsigned int ticks = this->simulation_clock.advance(this->lastframe_msec());
+			if (not this->pipelined_simulation) {
+				this->simulate(ticks);
+			}
 
-			// invoke all game drawing handlers
+			// record the frame, this is the only time the drawing
+			// handlers may look at the game state.
+			this->recording_commands = &this->render_commands;
 			for (auto &action : this->on_drawgame) {
 				if (false == action->on_draw()) {
 					break;
 				}
 			}
-		}
-		glPopMatrix();
-
-		util::gl_check_error();
-
-		glPushMatrix(); {
-			// the hud coordinate system is automatically established
-
-			// draw the fps overlay
 
+			this->recording_commands = &this->hud_commands;
 			if (this->drawing_debug_overlay) {
 				this->draw_debug_overlay();
 			}
 
 			if (this->drawing_huds) {
-				// invoke all hud drawing callback methods
 				for (auto &action : this->on_drawhud) {
 					if (false == action->on_drawhud()) {
 						break;
 					}
 				}
 			}
+			this->recording_commands = &this->render_commands;
+
+			// the recorded commands don't depend on the game state anymore,
+			// so the next ticks can run while they are drawn.
+			if (this->pipelined_simulation) {
+				this->simulation_worker.start([this, ticks] {
+					this->simulate(ticks);
+				});
+			}
+
+			auto render_start = std::chrono::steady_clock::now();
+
+			// clear the framebuffer to black
+			// in the future, we might disable it for lazy drawing
+			glClearColor(0.0, 0.0, 0.0, 0.0);
+			glClear(GL_COLOR_BUFFER_BIT);
+
+			this->gl_backend.begin_frame();
+
+			glPushMatrix(); {
+				// set the framebuffer up for camgame rendering
+				glTranslatef(camgame_window.x, camgame_window.y, 0);
+				glScalef(this->camgame_zoom, this->camgame_zoom, 1);
+
+				this->gl_backend.execute(this->render_commands);
+			}
+			glPopMatrix();
+
+			util::gl_check_error();
+
+			glPushMatrix(); {
+				// the hud coordinate system is automatically established
+				this->gl_backend.execute(this->hud_commands);
+			}
+			glPopMatrix();
+
+			util::gl_check_error();
+
+			this->render_commands.clear();
+			this->hud_commands.clear();
+
+			this->last_batch_stats = this->gl_backend.get_stats();
+			this->gl_backend.reset_stats();
+			this->last_render_msec = std::chrono::duration<float, std::milli>(
+				std::chrono::steady_clock::now() - render_start
+			).count();
+
+			// the rendering is done
+			// swap the drawing buffers to actually show the frame
+			SDL_GL_SwapWindow(window);
+		}
+	}
+	catch (...) {
+		// don't leave the worker running on the game state
+		try {
+			this->simulation_worker.wait();
 		}
-		glPopMatrix();
+		catch (...) {}
+		throw;
+	}
+
+	this->simulation_worker.wait();
+}
 
-		util::gl_check_error();
+void Engine::simulate(unsigned int ticks) {
+	auto start = std::chrono::steady_clock::now();
 
-		// the rendering is done
-		// swap the drawing buffers to actually show the frame
-		SDL_GL_SwapWindow(window);
+	for (unsigned int i = 0; i < ticks; i++) {
+		for (auto &action : this->on_simulation_tick) {
+			if (false == action->on_tick()) {
+				break;
+			}
+		}
 	}
+
+	this->last_simulation_msec = std::chrono::duration<float, std::milli>(
+		std::chrono::steady_clock::now() - start
+	).count();
 }
 
 void Engine::register_input_action(InputHandler *handler) {
@@ -322,6 +428,10 @@ void Engine::register_tick_action(TickHandler *handler) {
 	this->on_engine_tick.push_back(handler);
 }
 
+void Engine::register_simulation_action(TickHandler *handler) {
+	this->on_simulation_tick.push_back(handler);
+}
+
 void Engine::register_drawhud_action(HudHandler *handler) {
 	this->on_drawhud.push_back(handler);
 }
@@ -346,6 +456,10 @@ audio::AudioManager &Engine::get_audio_manager() {
 	return this->audio_manager;
 }
 
+renderer::CommandList &Engine::get_render_commands() {
+	return *this->recording_commands;
+}
+
 ScreenshotManager &Engine::get_screenshot_manager() {
 	return this->screenshot_manager;
 }
@@ -358,6 +472,18 @@ unsigned int Engine::lastframe_msec() {
 	return this->fpscounter.msec_lastframe;
 }
 
+unsigned int Engine::simulation_tick_msec() {
+	return this->simulation_clock.tick_msec;
+}
+
+float Engine::simulation_tick_fraction() {
+	// the ticks of this frame run only after it was recorded
+	if (this->pipelined_simulation) {
+		return this->simulation_clock.previous_fraction();
+	}
+	return this->simulation_clock.fraction();
+}
+
 
 
 } //namespace openage
@@ -15,8 +15,12 @@
 #include "font.h"
 #include "handlers.h"
 #include "input.h"
+#include "job/frame_worker.h"
 #include "job/job_manager.h"
+#include "renderer/command_list.h"
+#include "renderer/gl_backend.h"
 #include "util/dir.h"
+#include "util/fixed_timestep.h"
 #include "util/fps.h"
 #include "screenshot.h"
 
@@ -135,6 +139,12 @@ public:
 	 */
 	void register_tick_action(TickHandler *handler);
 
+	/**
+	 * register a simulation action, executed at the fixed simulation
+	 * tick rate, independent of the frame rate.
+	 */
+	void register_simulation_action(TickHandler *handler);
+
 	/**
 	 * register a hud drawing handler, drawn in hud coordinates.
 	 */
@@ -165,6 +175,12 @@ public:
 	 */
 	audio::AudioManager &get_audio_manager();
 
+	/**
+	 * return the command list where the drawing handlers
+	 * record what they draw, for the game or the hud.
+	 */
+	renderer::CommandList &get_render_commands();
+
 	/**
 	* return this engine's screenshot manager.
 	*/
@@ -183,6 +199,23 @@ public:
 	 */
 	unsigned int lastframe_msec();
 
+	/**
+	 * return the number of milliseconds that are simulated
+	 * in each simulation tick.
+	 */
+	unsigned int simulation_tick_msec();
+
+	/**
+	 * return how far the real time has progressed from the last
+	 * simulation tick towards the next one, in [0, 1).
+	 *
+	 * use that to interpolate drawing positions between ticks.
+	 * with the pipelined simulation, the drawn state lags one frame
+	 * behind the clock, so this is the fraction before the frame's time
+	 * was added.
+	 */
+	float simulation_tick_fraction();
+
 	/**
 	 * current engine state variable.
 	 * to be set to false to stop the engine loop.
@@ -216,6 +249,12 @@ public:
 	 */
 	coord::window camgame_window;
 
+	/**
+	 * window pixels per camgame pixel.
+	 * below 1, the camera is zoomed out.
+	 */
+	float camgame_zoom;
+
 	/**
 	 * position of the hud camera, in the window system.
 	 * (the position where camhud {0, 0} is rendered)
@@ -237,6 +276,11 @@ private:
 	 */
 	void loop();
 
+	/**
+	 * run the given number of simulation ticks.
+	 */
+	void simulate(unsigned int ticks);
+
 	/**
 	 * the current data directory for the engine.
 	 */
@@ -260,6 +304,26 @@ private:
 	 */
 	std::vector<TickHandler *> on_engine_tick;
 
+	/**
+	 * run on every simulation tick, after the engine tick handlers,
+	 * zero or more times per frame
+	 */
+	std::vector<TickHandler *> on_simulation_tick;
+
+	/**
+	 * the fixed rate clock that schedules the simulation ticks.
+	 */
+	util::FixedTimestep simulation_clock;
+
+	/**
+	 * run the simulation ticks of a frame on a worker thread,
+	 * while the frame recorded before them is rendered.
+	 *
+	 * the simulation then shows up on screen one frame later.
+	 * when false, the ticks run before the frame is drawn.
+	 */
+	bool pipelined_simulation;
+
 	/**
 	 * run every time the game is being drawn,
 	 * with the renderer set to the camgame system
@@ -292,6 +356,46 @@ private:
 	 */
 	job::JobManager *job_manager;
 
+	/**
+	 * the drawing commands recorded by the game drawing handlers.
+	 *
+	 * together with hud_commands, this is the snapshot of a frame:
+	 * it is recorded while the simulation is idle, and executed
+	 * while the next simulation ticks already run.
+	 */
+	renderer::CommandList render_commands;
+
+	/**
+	 * the drawing commands of the hud handlers and the overlay.
+	 */
+	renderer::CommandList hud_commands;
+
+	/**
+	 * the list get_render_commands returns while recording.
+	 */
+	renderer::CommandList *recording_commands;
+
+	/**
+	 * runs the simulation ticks when they are pipelined.
+	 */
+	job::FrameWorker simulation_worker;
+
+	/**
+	 * milliseconds spent in the last frame's simulation ticks and rendering.
+	 */
+	float last_simulation_msec;
+	float last_render_msec;
+
+	/**
+	 * draws the recorded commands.
+	 */
+	renderer::GLBackend gl_backend;
+
+	/**
+	 * the sprite batch counters of the last frame.
+	 */
+	renderer::batch_stats last_batch_stats;
+
 	/**
 	 * the text font to be used for (can you believe it?) texts.
 	 * dejavu serif, book, 20pts
@@ -4,6 +4,7 @@
 
 #include <fontconfig/fontconfig.h>
 
+#include "engine.h"
 #include "log.h"
 #include "util/error.h"
 #include "util/strings.h"
@@ -84,7 +85,7 @@ Font::~Font() {
 }
 
 void Font::render_static(coord::pixel_t x, coord::pixel_t y, const char *text, int len) {
-	this->internal_font->Render(text, len, FTPoint(x, y));
+	Engine::get().get_render_commands().text(this, x, y, text, len);
 }
 
 void Font::render(coord::pixel_t x, coord::pixel_t y, const char *format, ...) {
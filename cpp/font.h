@@ -26,6 +26,10 @@ public:
 	Font(const char *family, const char *style, unsigned size);
 	~Font();
 
+	/**
+	 * record drawing the text in the engine's render commands,
+	 * with the current color of the command list.
+	 */
 	void render_static(coord::pixel_t x, coord::pixel_t y, const char *text, int len = -1);
 	void render(coord::pixel_t x, coord::pixel_t y, const char *format, ...);
 	void render(coord::camhud pos, const char *format, ...);
@@ -7,6 +7,7 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <algorithm>
 #include <cinttypes>
 
 #include "args.h"
@@ -110,14 +111,14 @@ GameMain::GameMain(Engine *engine)
 	scrolling_active{false},
 	construct_mode{true},
 	selected_unit{nullptr},
-	assetmanager{engine->get_data_dir()},
+	assetmanager{engine->get_data_dir(), engine->get_job_manager()},
 	gamedata_loaded{false},
 	engine{engine} {
 
 	engine->register_draw_action(this);
 	engine->register_input_action(this);
 	engine->register_tick_action(this);
-	engine->register_tick_action(&this->placed_units);
+	engine->register_simulation_action(&this->placed_units);
 	engine->register_drawhud_action(this);
 
 	util::Dir *data_dir = engine->get_data_dir();
@@ -158,6 +159,11 @@ GameMain::GameMain(Engine *engine)
 	auto plaintexture_frag = new shader::Shader(GL_FRAGMENT_SHADER, texture_frag_code);
 	delete[] texture_frag_code;
 
+	char *teamcolor_vert_code;
+	util::read_whole_file(&teamcolor_vert_code, data_dir->join("shaders/teamcolors.vert.glsl"));
+	auto teamcolor_vert = new shader::Shader(GL_VERTEX_SHADER, teamcolor_vert_code);
+	delete[] teamcolor_vert_code;
+
 	char *teamcolor_frag_code;
 	util::read_whole_file(&teamcolor_frag_code, data_dir->join("shaders/teamcolors.frag.glsl"));
 	auto teamcolor_frag = new shader::Shader(GL_FRAGMENT_SHADER, teamcolor_frag_code);
@@ -173,6 +179,16 @@ GameMain::GameMain(Engine *engine)
 	auto alphamask_frag = new shader::Shader(GL_FRAGMENT_SHADER, alphamask_frag_code);
 	delete[] alphamask_frag_code;
 
+	char *terrainblend_vert_code;
+	util::read_whole_file(&terrainblend_vert_code, data_dir->join("shaders/terrainblend.vert.glsl"));
+	auto terrainblend_vert = new shader::Shader(GL_VERTEX_SHADER, terrainblend_vert_code);
+	delete[] terrainblend_vert_code;
+
+	char *terrainblend_frag_code;
+	util::read_whole_file(&terrainblend_frag_code, data_dir->join("shaders/terrainblend.frag.glsl"));
+	auto terrainblend_frag = new shader::Shader(GL_FRAGMENT_SHADER, terrainblend_frag_code);
+	delete[] terrainblend_frag_code;
+
 
 
 	// create program for rendering simple textures
@@ -187,11 +203,11 @@ GameMain::GameMain(Engine *engine)
 
 	// create program for tinting textures at alpha-marked pixels
 	// with team colors
-	teamcolor_shader::program = new shader::Program(plaintexture_vert, teamcolor_frag);
+	teamcolor_shader::program = new shader::Program(teamcolor_vert, teamcolor_frag);
 	teamcolor_shader::program->link();
 	teamcolor_shader::texture = teamcolor_shader::program->get_uniform_id("texture");
 	teamcolor_shader::tex_coord = teamcolor_shader::program->get_attribute_id("tex_coordinates");
-	teamcolor_shader::player_id_var = teamcolor_shader::program->get_uniform_id("player_number");
+	teamcolor_shader::player_id_var = teamcolor_shader::program->get_attribute_id("player_number");
 	teamcolor_shader::alpha_marker_var = teamcolor_shader::program->get_uniform_id("alpha_marker");
 	teamcolor_shader::player_color_var = teamcolor_shader::program->get_uniform_id("player_color");
 	teamcolor_shader::program->use();
@@ -216,12 +232,32 @@ GameMain::GameMain(Engine *engine)
 	glUniform1i(alphamask_shader::mask_texture, 1);
 	alphamask_shader::program->stopusing();
 
+	// create program for drawing terrain tiles blended with their neighbors
+	terrain_blend_shader::program = new shader::Program(terrainblend_vert, terrainblend_frag);
+	terrain_blend_shader::program->link();
+	terrain_blend_shader::base_coord = terrain_blend_shader::program->get_attribute_id("base_tex_coordinates");
+	for (unsigned i = 0; i < renderer::max_blend_layers; i++) {
+		char *name = util::format("layer_coordinates%u", i);
+		terrain_blend_shader::layer_coord[i] = terrain_blend_shader::program->get_attribute_id(name);
+		delete[] name;
+	}
+	terrain_blend_shader::layer_count = terrain_blend_shader::program->get_attribute_id("layer_count");
+	terrain_blend_shader::base_texture = terrain_blend_shader::program->get_uniform_id("base_texture");
+	terrain_blend_shader::mask_texture = terrain_blend_shader::program->get_uniform_id("mask_texture");
+	terrain_blend_shader::program->use();
+	glUniform1i(terrain_blend_shader::base_texture, 0);
+	glUniform1i(terrain_blend_shader::mask_texture, 1);
+	terrain_blend_shader::program->stopusing();
+
 	// after linking, the shaders are no longer necessary
 	delete plaintexture_vert;
 	delete plaintexture_frag;
+	delete teamcolor_vert;
 	delete teamcolor_frag;
 	delete alphamask_vert;
 	delete alphamask_frag;
+	delete terrainblend_vert;
+	delete terrainblend_frag;
 
 	auto gamedata_load_function = [this, engine, asset_dir]() -> std::vector<gamedata::empiresdat> {
 		log::msg("loading game specification files... stand by, will be faster soon...");
@@ -292,7 +328,7 @@ void GameMain::on_gamedata_loaded(std::vector<gamedata::empiresdat> &gamedata) {
 
 	// load the requested sounds.
 	audio::AudioManager &am = engine->get_audio_manager();
-	am.load_resources(asset_dir, sound_files);
+	am.load_resources(asset_dir, sound_files, engine->get_job_manager());
 }
 
 GameMain::~GameMain() {
@@ -304,6 +340,7 @@ GameMain::~GameMain() {
 	delete texture_shader::program;
 	delete teamcolor_shader::program;
 	delete alphamask_shader::program;
+	delete terrain_blend_shader::program;
 }
 
 
@@ -358,6 +395,7 @@ bool GameMain::on_input(SDL_Event *e) {
 
 			TerrainChunk *chunk = terrain->get_create_chunk(mousepos_tile);
 			chunk->get_data(mousepos_tile)->terrain_id = editor_current_terrain;
+			terrain->tile_changed(mousepos_tile);
 		}
 		else if (clicking_active and e->button.button == SDL_BUTTON_RIGHT and !construct_mode and selected_unit) {
 			TerrainChunk *chunk = terrain->get_chunk(mousepos_tile);
@@ -432,8 +470,9 @@ bool GameMain::on_input(SDL_Event *e) {
 			cam_movement.x = e->motion.xrel;
 			cam_movement.y = e->motion.yrel;
 
-			// this factor controls the scroll speed
-			// cam_movement *= 1;
+			// this factor controls the scroll speed,
+			// the view follows the mouse at any zoom
+			cam_movement *= 1 / engine.camgame_zoom;
 
 			// calculate camera position delta from velocity and frame duration
 			coord::camgame_delta cam_delta;
@@ -480,6 +519,7 @@ bool GameMain::on_input(SDL_Event *e) {
 
 		case SDLK_SPACE:
 			this->terrain->blending_enabled = !terrain->blending_enabled;
+			this->terrain->all_tiles_changed();
 			break;
 
 		case SDLK_F12:
@@ -501,6 +541,12 @@ bool GameMain::on_input(SDL_Event *e) {
 		case SDLK_p:
 			UnitAction::show_debug = !UnitAction::show_debug;
 			break;
+		case SDLK_PAGEUP:
+			engine.camgame_zoom = std::min(engine.camgame_zoom * 2, 1.0f);
+			break;
+		case SDLK_PAGEDOWN:
+			engine.camgame_zoom = std::max(engine.camgame_zoom / 2, 1.0f / 16);
+			break;
 		}
 
 		break;
@@ -543,7 +589,7 @@ void GameMain::move_camera() {
 		cam_movement.y += cam_movement_speed_keyboard;
 	}
 
-	cam_movement *= (float) engine.lastframe_msec();
+	cam_movement *= (float) engine.lastframe_msec() / engine.camgame_zoom;
 
 	// calculate camera position delta from velocity and frame duration
 	coord::camgame_delta cam_delta;
@@ -558,6 +604,7 @@ void GameMain::move_camera() {
 bool GameMain::on_tick() {
 	this->move_camera();
 	assetmanager.check_updates();
+	assetmanager.upload_decoded();
 
 	if (not gamedata_loaded and this->gamedata_load_job.is_finished()) {
 		auto gamedata = this->gamedata_load_job.get_result();
@@ -663,23 +710,21 @@ void GameMain::draw_debug_grid() {
 	int y0         = cam_offset_y - line_half_height;
 	int y1         = cam_offset_y + line_half_height;
 
-	glLineWidth(1);
-	glColor3f(0.0, 0.0, 0.0);
-	glBegin(GL_LINES); {
+	renderer::CommandList &commands = e.get_render_commands();
+	commands.set_color(0.0, 0.0, 0.0);
+	commands.begin_lines(1);
 
-		for (int i = -k; i < k; i++) {
-				glVertex3f(i * tilesize_x + x0, y1, 0);
-				glVertex3f(i * tilesize_x + x1, y0, 0);
+	for (int i = -k; i < k; i++) {
+		commands.vertex(i * tilesize_x + x0, y1);
+		commands.vertex(i * tilesize_x + x1, y0);
 
-				glVertex3f(i * tilesize_x + x0, y0 - 1, 0);
-				glVertex3f(i * tilesize_x + x1, y1 - 1, 0);
-		}
-
-	} glEnd();
+		commands.vertex(i * tilesize_x + x0, y0 - 1);
+		commands.vertex(i * tilesize_x + x1, y1 - 1);
+	}
 
 }
 
-void TestSound::play() {
+void TestSound::play(coord::phys3 position) {
 	if (this->sound_items.size() <= 0) {
 		return;
 	}
@@ -688,7 +733,9 @@ void TestSound::play() {
 	int rand = util::random_range(0, this->sound_items.size());
 	int sndid = this->sound_items[rand];
 	try {
-		audio::Sound{am.get_sound(audio::category_t::GAME, sndid)}.play();
+		audio::Sound sound = am.get_sound(audio::category_t::GAME, sndid);
+		sound.set_position(position);
+		sound.play();
 	}
 	catch(util::Error &e) {
 		log::dbg("cannot play: %s", e.str());
@@ -52,7 +52,10 @@ public:
 
 class TestSound {
 public:
-	void play();
+	/**
+	 * plays a random sound of this set at a position on the map.
+	 */
+	void play(openage::coord::phys3 position);
 
 	std::vector<int> sound_items;
 };
@@ -0,0 +1,87 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#include "frame_worker.h"
+
+#include "../util/error.h"
+
+namespace openage {
+namespace job {
+
+FrameWorker::FrameWorker()
+	:
+	busy{false},
+	quit{false} {
+}
+
+FrameWorker::~FrameWorker() {
+	if (this->thread.joinable()) {
+		{
+			std::unique_lock<std::mutex> lock{this->mtx};
+			this->changed.wait(lock, [this] { return !this->busy; });
+			this->quit = true;
+		}
+		this->changed.notify_all();
+		this->thread.join();
+	}
+}
+
+void FrameWorker::start(const std::function<void()> &task) {
+	{
+		std::unique_lock<std::mutex> lock{this->mtx};
+		if (this->busy) {
+			throw util::Error{"frame worker started while it is still busy"};
+		}
+		this->task = task;
+		this->busy = true;
+	}
+
+	if (!this->thread.joinable()) {
+		this->thread = std::thread{&FrameWorker::run, this};
+	}
+	this->changed.notify_all();
+}
+
+void FrameWorker::wait() {
+	std::exception_ptr exception;
+	{
+		std::unique_lock<std::mutex> lock{this->mtx};
+		this->changed.wait(lock, [this] { return !this->busy; });
+		std::swap(exception, this->exception);
+	}
+
+	if (exception) {
+		std::rethrow_exception(exception);
+	}
+}
+
+bool FrameWorker::is_busy() {
+	std::unique_lock<std::mutex> lock{this->mtx};
+	return this->busy;
+}
+
+void FrameWorker::run() {
+	std::unique_lock<std::mutex> lock{this->mtx};
+	while (true) {
+		this->changed.wait(lock, [this] { return this->busy || this->quit; });
+		if (this->quit) {
+			return;
+		}
+
+		// the owner doesn't touch the task while it runs
+		lock.unlock();
+		try {
+			this->task();
+		} catch (...) {
+			lock.lock();
+			this->exception = std::current_exception();
+			lock.unlock();
+		}
+		lock.lock();
+
+		this->busy = false;
+		this->changed.notify_all();
+	}
+}
+
+} // namespace job
+} // namespace openage
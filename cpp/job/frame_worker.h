@@ -0,0 +1,63 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#ifndef OPENAGE_JOB_FRAME_WORKER_H_
+#define OPENAGE_JOB_FRAME_WORKER_H_
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace openage {
+namespace job {
+
+/**
+ * A thread that runs one task at a time, handed over by the owner once
+ * per frame, so the task overlaps with what the owner does meanwhile.
+ *
+ * Unlike JobManager jobs, a task never waits behind other queued jobs,
+ * and may use the JobManager itself, e.g. with parallel_for.
+ */
+class FrameWorker {
+public:
+	FrameWorker();
+
+	/** Waits for the running task and stops the thread. */
+	~FrameWorker();
+
+	FrameWorker(const FrameWorker&) = delete;
+	FrameWorker &operator=(const FrameWorker&) = delete;
+
+	/**
+	 * Run the task on the worker thread, which is started on the first call.
+	 * The previous task must have been waited for.
+	 */
+	void start(const std::function<void()> &task);
+
+	/**
+	 * Block until the current task, if any, has returned.
+	 * An exception thrown by the task is rethrown here.
+	 */
+	void wait();
+
+	/** Whether a task was started and not waited for yet. */
+	bool is_busy();
+
+private:
+	void run();
+
+	std::thread thread;
+	std::mutex mtx;
+	std::condition_variable changed;
+
+	std::function<void()> task;
+	bool busy;
+	bool quit;
+	std::exception_ptr exception;
+};
+
+} // namespace job
+} // namespace openage
+
+#endif
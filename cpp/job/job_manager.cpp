@@ -2,6 +2,8 @@
 
 #include "job_manager.h"
 
+#include <algorithm>
+
 #include "../log.h"
 
 namespace openage {
@@ -38,6 +40,86 @@ void JobManager::stop() {
 			this->number_of_workers);
 }
 
+/**
+ * shared state of one parallel_for call.
+ * helper jobs may start after the call has returned,
+ * so they must not touch the function unless they claimed a batch.
+ */
+struct ParallelForState {
+	const std::function<void(size_t)> *function;
+	size_t count;
+	size_t batch_size;
+	size_t batches;
+	std::atomic<size_t> next_batch;
+	std::atomic<size_t> done_batches;
+	std::mutex exception_mtx;
+	std::exception_ptr exception;
+
+	/**
+	 * processes batches until none are left.
+	 */
+	void run() {
+		size_t batch;
+		while ((batch = this->next_batch.fetch_add(1)) < this->batches) {
+			size_t begin = batch * this->batch_size;
+			size_t end = std::min(begin + this->batch_size, this->count);
+			try {
+				for (size_t i = begin; i < end; i++) {
+					(*this->function)(i);
+				}
+			} catch (...) {
+				std::lock_guard<std::mutex> lock{this->exception_mtx};
+				if (!this->exception) {
+					this->exception = std::current_exception();
+				}
+			}
+			this->done_batches.fetch_add(1);
+		}
+	}
+};
+
+void JobManager::parallel_for(size_t count, const std::function<void(size_t)> &function,
+                              size_t batch_size) {
+	if (batch_size == 0) {
+		batch_size = 1;
+	}
+	size_t batches = (count + batch_size - 1) / batch_size;
+
+	// not worth distributing, or nobody to distribute to
+	if (batches <= 1 || !this->is_running.load()) {
+		for (size_t i = 0; i < count; i++) {
+			function(i);
+		}
+		return;
+	}
+
+	auto state = std::make_shared<ParallelForState>();
+	state->function   = &function;
+	state->count      = count;
+	state->batch_size = batch_size;
+	state->batches    = batches;
+	state->next_batch.store(0);
+	state->done_batches.store(0);
+
+	// the calling thread takes one share of the work itself
+	size_t helpers = std::min(static_cast<size_t>(this->number_of_workers), batches - 1);
+	for (size_t i = 0; i < helpers; i++) {
+		this->enqueue<bool>([state]() {
+			state->run();
+			return true;
+		});
+	}
+
+	state->run();
+	while (state->done_batches.load() < batches) {
+		std::this_thread::yield();
+	}
+
+	if (state->exception) {
+		std::rethrow_exception(state->exception);
+	}
+}
+
 void JobManager::dispatch_queue() {
 	// loop as long as is_running is set
 	while (this->is_running.load()) {
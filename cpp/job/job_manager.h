@@ -5,6 +5,7 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <queue>
@@ -78,6 +79,20 @@ public:
 		return Job<T>{state};
 	}
 
+	/**
+	 * Calls the given function for every index in [0, count) and blocks until
+	 * all calls have returned. The index range is split into batches of
+	 * batch_size, which are processed by the worker threads and the calling
+	 * thread. The calling thread always takes part, so this never waits for
+	 * a worker that is busy with another job, and it degrades to a plain loop
+	 * if the JobManager is not running.
+	 *
+	 * The first exception thrown by the function is rethrown in the calling
+	 * thread, after all batches have finished.
+	 */
+	void parallel_for(size_t count, const std::function<void(size_t)> &function,
+	                  size_t batch_size=64);
+
 private:
 	/**
 	 * This function is passed to all worker threads, takes Job's from the
@@ -0,0 +1,149 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#include <atomic>
+#include <vector>
+
+#include "../log.h"
+#include "frame_worker.h"
+#include "job_manager.h"
+
+namespace openage {
+namespace job {
+namespace tests {
+
+void parallel_for() {
+	int stage = 0;
+	JobManager manager{3};
+
+	// not started yet, runs on the calling thread
+	std::vector<int> visits(1000, 0);
+	manager.parallel_for(visits.size(), [&](size_t i) {
+		visits[i] += 1;
+	}, 16);
+	for (auto &v : visits) {
+		if (v != 1) { goto out; }
+	}
+	stage += 1;
+
+	manager.start();
+	{
+		std::vector<std::atomic<int>> counts(10000);
+		for (auto &c : counts) {
+			c.store(0);
+		}
+		manager.parallel_for(counts.size(), [&](size_t i) {
+			counts[i].fetch_add(1);
+		}, 7);
+		for (auto &c : counts) {
+			if (c.load() != 1) { manager.stop(); goto out; }
+		}
+	}
+	stage += 1;
+
+	// an exception is passed on once all batches are done,
+	// the rest of the failing batch is skipped
+	{
+		std::atomic<int> done{0};
+		bool caught = false;
+		try {
+			manager.parallel_for(512, [&](size_t i) {
+				if (i == 100) {
+					throw "expected";
+				}
+				done.fetch_add(1);
+			}, 8);
+		}
+		catch (const char *) {
+			caught = true;
+		}
+		if (not caught or done.load() != 512 - 4) { manager.stop(); goto out; }
+	}
+	stage += 1;
+
+	// nothing to do
+	manager.parallel_for(0, [&](size_t) {
+		stage = -1;
+	});
+	manager.stop();
+	if (stage < 0) { goto out; }
+
+	return;
+
+out:
+	log::err("parallel_for test failed at stage %d", stage);
+	throw "parallel_for test failed";
+}
+
+void frame_worker() {
+	int stage = 0;
+	FrameWorker worker;
+	std::atomic<int> runs{0};
+	int main_work = 0;
+	bool caught = false;
+
+	// never started, nothing to wait for
+	worker.wait();
+	if (worker.is_busy()) { goto out; }
+	stage += 1;
+
+	// the owner keeps working while the task runs
+	for (int frame = 0; frame < 100; frame++) {
+		worker.start([&] {
+			runs.fetch_add(1);
+		});
+		main_work += 1;
+		worker.wait();
+		if (worker.is_busy() or runs.load() != frame + 1) { goto out; }
+	}
+	if (main_work != 100) { goto out; }
+	stage += 1;
+
+	// the task may use the job manager
+	{
+		JobManager manager{2};
+		manager.start();
+		std::vector<int> visits(100, 0);
+		worker.start([&] {
+			manager.parallel_for(visits.size(), [&](size_t i) {
+				visits[i] += 1;
+			}, 10);
+		});
+		worker.wait();
+		manager.stop();
+		for (auto &v : visits) {
+			if (v != 1) { goto out; }
+		}
+	}
+	stage += 1;
+
+	// an exception is passed to the waiting owner once
+	worker.start([] {
+		throw "expected";
+	});
+	try {
+		worker.wait();
+	}
+	catch (const char *) {
+		caught = true;
+	}
+	if (not caught) { goto out; }
+	worker.wait();
+	stage += 1;
+
+	// the worker is still usable afterwards
+	worker.start([&] {
+		runs.fetch_add(1);
+	});
+	worker.wait();
+	if (runs.load() != 101) { goto out; }
+
+	return;
+
+out:
+	log::err("frame_worker test failed at stage %d", stage);
+	throw "frame_worker test failed";
+}
+
+} // namespace tests
+} // namespace job
+} // namespace openage
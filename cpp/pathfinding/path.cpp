@@ -3,6 +3,7 @@
 #include <cmath>
 
 #include "path.h"
+#include "../engine.h"
 #include "../terrain/terrain.h"
 
 namespace openage {
@@ -123,15 +124,13 @@ Path::~Path() {
 }
 
 void Path::draw_path() {
-	glLineWidth(1);
-	glColor3f(0.3, 1.0, 0.3);
-	glBegin(GL_LINES); {
-		for (Node &n : waypoints) {
-			coord::camgame draw_pos = n.position.to_camgame();
-			glVertex3f(draw_pos.x, draw_pos.y, 0);
-		}
+	renderer::CommandList &commands = Engine::get().get_render_commands();
+	commands.set_color(0.3, 1.0, 0.3);
+	commands.begin_lines(1);
+	for (Node &n : waypoints) {
+		coord::camgame draw_pos = n.position.to_camgame();
+		commands.vertex(draw_pos.x, draw_pos.y);
 	}
-	glEnd();
 }
 
 } // namespace path
@@ -0,0 +1,115 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#include "atlas_packer.h"
+
+#include <algorithm>
+
+namespace openage {
+namespace renderer {
+
+AtlasPacker::AtlasPacker(int width, int height)
+	:
+	width{width},
+	height{height},
+	used_area{0} {
+	this->skyline.push_back({0, 0, width});
+}
+
+int AtlasPacker::fit(size_t index, int w) const {
+	int x = this->skyline[index].x;
+	if (x + w > this->width) {
+		return -1;
+	}
+
+	// the rectangle rests on the highest segment below it
+	int y = 0;
+	int remaining = w;
+	for (size_t i = index; remaining > 0; i++) {
+		y = std::max(y, this->skyline[i].y);
+		remaining -= this->skyline[i].w;
+	}
+	return y;
+}
+
+bool AtlasPacker::pack(int w, int h, int *x, int *y) {
+	if (w <= 0 or h <= 0) {
+		return false;
+	}
+
+	size_t best = this->skyline.size();
+	int best_top = this->height + 1;
+	int best_width = 0;
+	int best_y = 0;
+
+	for (size_t i = 0; i < this->skyline.size(); i++) {
+		int pos_y = this->fit(i, w);
+		if (pos_y < 0 or pos_y + h > this->height) {
+			continue;
+		}
+
+		// lowest top edge first, then the narrowest segment
+		int top = pos_y + h;
+		if (top < best_top or (top == best_top and this->skyline[i].w < best_width)) {
+			best = i;
+			best_top = top;
+			best_width = this->skyline[i].w;
+			best_y = pos_y;
+		}
+	}
+
+	if (best == this->skyline.size()) {
+		return false;
+	}
+
+	*x = this->skyline[best].x;
+	*y = best_y;
+	this->add_segment(best, *x, best_top, w);
+	this->used_area += (size_t) w * h;
+	return true;
+}
+
+void AtlasPacker::add_segment(size_t index, int x, int y, int w) {
+	this->skyline.insert(std::begin(this->skyline) + index, {x, y, w});
+
+	// shrink or remove the segments now covered by the new one
+	size_t i = index + 1;
+	while (i < this->skyline.size()) {
+		segment &prev = this->skyline[i - 1];
+		segment &cur = this->skyline[i];
+		int overlap = prev.x + prev.w - cur.x;
+		if (overlap <= 0) {
+			break;
+		}
+		if (overlap < cur.w) {
+			cur.x += overlap;
+			cur.w -= overlap;
+			break;
+		}
+		this->skyline.erase(std::begin(this->skyline) + i);
+	}
+
+	// merge neighbors of equal height
+	for (size_t j = 0; j + 1 < this->skyline.size();) {
+		if (this->skyline[j].y == this->skyline[j + 1].y) {
+			this->skyline[j].w += this->skyline[j + 1].w;
+			this->skyline.erase(std::begin(this->skyline) + j + 1);
+		} else {
+			j++;
+		}
+	}
+}
+
+float AtlasPacker::occupancy() const {
+	return (float) this->used_area / ((float) this->width * this->height);
+}
+
+int AtlasPacker::get_width() const {
+	return this->width;
+}
+
+int AtlasPacker::get_height() const {
+	return this->height;
+}
+
+} //namespace renderer
+} //namespace openage
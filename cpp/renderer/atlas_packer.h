@@ -0,0 +1,64 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#ifndef OPENAGE_RENDERER_ATLAS_PACKER_H_
+#define OPENAGE_RENDERER_ATLAS_PACKER_H_
+
+#include <cstddef>
+#include <vector>
+
+namespace openage {
+namespace renderer {
+
+/**
+ * places rectangles in a fixed size area, one after another.
+ *
+ * uses the skyline bottom-left heuristic: the top edge of the
+ * placed rectangles is kept as a list of horizontal segments,
+ * and each new rectangle is placed where its top ends lowest.
+ * rectangles can't be removed again.
+ */
+class AtlasPacker {
+public:
+	AtlasPacker(int width, int height);
+
+	/**
+	 * find a place for a w * h rectangle and mark it as used.
+	 *
+	 * @returns false if it doesn't fit anymore.
+	 */
+	bool pack(int w, int h, int *x, int *y);
+
+	/**
+	 * the fraction of the area covered by rectangles, in [0, 1].
+	 */
+	float occupancy() const;
+
+	int get_width() const;
+	int get_height() const;
+
+private:
+	/**
+	 * a part of the skyline: everything from x to x + w
+	 * is used up to y.
+	 */
+	struct segment {
+		int x, y, w;
+	};
+
+	/**
+	 * the y where a w wide rectangle starting at the given
+	 * segment would be placed, or -1 if it exceeds the width.
+	 */
+	int fit(size_t index, int w) const;
+
+	void add_segment(size_t index, int x, int y, int w);
+
+	int width, height;
+	size_t used_area;
+	std::vector<segment> skyline;
+};
+
+} //namespace renderer
+} //namespace openage
+
+#endif
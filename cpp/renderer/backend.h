@@ -0,0 +1,27 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#ifndef OPENAGE_RENDERER_BACKEND_H_
+#define OPENAGE_RENDERER_BACKEND_H_
+
+#include "command_list.h"
+
+namespace openage {
+namespace renderer {
+
+/**
+ * replays recorded command lists.
+ */
+class Backend {
+public:
+	virtual ~Backend() = default;
+
+	/**
+	 * draw all commands of the list, in their order.
+	 */
+	virtual void execute(const CommandList &commands) = 0;
+};
+
+} //namespace renderer
+} //namespace openage
+
+#endif
@@ -0,0 +1,131 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#include "command_list.h"
+
+#include <cstring>
+
+#include "../util/error.h"
+
+namespace openage {
+namespace renderer {
+
+CommandList::CommandList()
+	:
+	current_color{1, 1, 1, 1} {}
+
+command &CommandList::append(command_type type) {
+	command c;
+	c.type = type;
+	c.col = this->current_color;
+	c.line_width = 1;
+	c.font = nullptr;
+	c.buffer = nullptr;
+	c.impostor = nullptr;
+	c.x = 0;
+	c.y = 0;
+	c.first = 0;
+	c.count = 0;
+	this->commands.push_back(c);
+	return this->commands.back();
+}
+
+void CommandList::sprite(const sprite_quad &quad) {
+	if (this->commands.empty() or this->commands.back().type != command_type::sprites) {
+		this->append(command_type::sprites).first = this->sprites.size();
+	}
+	this->sprites.push_back(quad);
+	this->commands.back().count += 1;
+}
+
+void CommandList::static_sprites(StaticSprites *buffer, float x, float y) {
+	command &c = this->append(command_type::static_sprites);
+	c.buffer = buffer;
+	c.x = x;
+	c.y = y;
+}
+
+void CommandList::impostor(Impostor *impostor, StaticSprites *buffer, float x, float y) {
+	command &c = this->append(command_type::impostor);
+	c.impostor = impostor;
+	c.buffer = buffer;
+	c.x = x;
+	c.y = y;
+}
+
+void CommandList::set_color(float r, float g, float b, float a) {
+	this->current_color = {r, g, b, a};
+}
+
+void CommandList::set_color(const util::col &c) {
+	this->set_color(c.r / 255.f, c.g / 255.f, c.b / 255.f, c.a / 255.f);
+}
+
+void CommandList::set_color(const util::col &c, float alpha) {
+	this->set_color(c.r / 255.f, c.g / 255.f, c.b / 255.f, alpha);
+}
+
+void CommandList::begin_lines(float width) {
+	command &c = this->append(command_type::lines);
+	c.line_width = width;
+	c.first = this->vertices.size() / 2;
+}
+
+void CommandList::begin_quads() {
+	this->append(command_type::quads).first = this->vertices.size() / 2;
+}
+
+void CommandList::vertex(float x, float y) {
+	if (this->commands.empty() or
+	    (this->commands.back().type != command_type::lines and
+	     this->commands.back().type != command_type::quads)) {
+		throw util::Error{"vertex recorded without begin_lines or begin_quads"};
+	}
+	this->vertices.push_back(x);
+	this->vertices.push_back(y);
+	this->commands.back().count += 1;
+}
+
+void CommandList::text(Font *font, float x, float y, const char *text, int len) {
+	size_t length = (len < 0) ? strlen(text) : len;
+
+	command &c = this->append(command_type::text);
+	c.font = font;
+	c.x = x;
+	c.y = y;
+	c.first = this->chars.size();
+	c.count = length;
+
+	this->chars.insert(std::end(this->chars), text, text + length);
+	this->chars.push_back('\0');
+}
+
+void CommandList::clear() {
+	this->commands.clear();
+	this->sprites.clear();
+	this->vertices.clear();
+	this->chars.clear();
+	this->current_color = {1, 1, 1, 1};
+}
+
+bool CommandList::empty() const {
+	return this->commands.empty();
+}
+
+const std::vector<command> &CommandList::get_commands() const {
+	return this->commands;
+}
+
+const std::vector<sprite_quad> &CommandList::get_sprites() const {
+	return this->sprites;
+}
+
+const std::vector<float> &CommandList::get_vertices() const {
+	return this->vertices;
+}
+
+const std::vector<char> &CommandList::get_chars() const {
+	return this->chars;
+}
+
+} //namespace renderer
+} //namespace openage
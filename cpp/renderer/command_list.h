@@ -0,0 +1,166 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#ifndef OPENAGE_RENDERER_COMMAND_LIST_H_
+#define OPENAGE_RENDERER_COMMAND_LIST_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../util/color.h"
+#include "sprite_batch.h"
+
+namespace openage {
+
+class Font;
+
+namespace renderer {
+
+class Impostor;
+class StaticSprites;
+
+enum class command_type : uint8_t {
+	/** a range of sprites, see CommandList::sprite */
+	sprites,
+	/** untextured lines, two vertices each */
+	lines,
+	/** untextured quads, four vertices each */
+	quads,
+	/** a text string */
+	text,
+	/** a prebuilt sprite buffer, drawn on top of everything before */
+	static_sprites,
+	/** a prebuilt sprite buffer, drawn as its impostor texture */
+	impostor,
+};
+
+/**
+ * rgba color, components in range 0.0 to 1.0
+ */
+struct color {
+	float r, g, b, a;
+};
+
+/**
+ * a sprite and its depth in a prebuilt sprite buffer,
+ * see StaticSprites::build.
+ */
+struct sprite_command {
+	sprite_quad quad;
+	int32_t depth;
+};
+
+/**
+ * one recorded command.
+ * the payload is stored in the command list,
+ * first and count index into the array of its type.
+ */
+struct command {
+	command_type type;
+	color col;
+	float line_width;
+	Font *font;
+	StaticSprites *buffer;
+	Impostor *impostor;
+	float x, y;
+	size_t first;
+	size_t count;
+};
+
+/**
+ * records drawing commands for a backend to replay.
+ *
+ * game code records what it wants to draw, and a backend
+ * (gl, or a null backend for headless benchmarks) executes it.
+ * the drawing order is the recording order.
+ *
+ * like the immediate mode gl api it replaces, untextured
+ * geometry and text use the current color set with set_color.
+ *
+ * the storage is kept when clearing, so recording a frame
+ * doesn't allocate once the list has grown to its size.
+ */
+class CommandList {
+public:
+	CommandList();
+
+	/**
+	 * add a sprite on top of everything recorded before.
+	 */
+	void sprite(const sprite_quad &quad);
+
+	/**
+	 * draw a prebuilt sprite buffer, translated by x, y.
+	 * the buffer must stay alive until the list is executed.
+	 */
+	void static_sprites(StaticSprites *buffer, float x, float y);
+
+	/**
+	 * draw a prebuilt sprite buffer as a single quad showing the impostor,
+	 * which is rendered from the buffer first if that changed.
+	 * both must stay alive until the list is executed.
+	 */
+	void impostor(Impostor *impostor, StaticSprites *buffer, float x, float y);
+
+	/**
+	 * set the color for the following lines, quads and texts.
+	 */
+	void set_color(float r, float g, float b, float a = 1);
+	void set_color(const util::col &c);
+	void set_color(const util::col &c, float alpha);
+
+	/**
+	 * start recording lines, their vertices are added with vertex().
+	 */
+	void begin_lines(float width = 1);
+
+	/**
+	 * start recording quads, their vertices are added with vertex().
+	 */
+	void begin_quads();
+
+	/**
+	 * add a vertex to the lines or quads begun last.
+	 */
+	void vertex(float x, float y);
+
+	/**
+	 * add text, drawn with the given font at x, y.
+	 * len < 0 means the text is null-terminated.
+	 */
+	void text(Font *font, float x, float y, const char *text, int len = -1);
+
+	/**
+	 * remove all commands, keeping the allocated storage.
+	 */
+	void clear();
+
+	/**
+	 * true if nothing was recorded.
+	 */
+	bool empty() const;
+
+	const std::vector<command> &get_commands() const;
+	const std::vector<sprite_quad> &get_sprites() const;
+
+	/** x, y pairs of the lines and quads */
+	const std::vector<float> &get_vertices() const;
+
+	/** the characters of all texts, each one null-terminated */
+	const std::vector<char> &get_chars() const;
+
+private:
+	command &append(command_type type);
+
+	std::vector<command> commands;
+	std::vector<sprite_quad> sprites;
+	std::vector<float> vertices;
+	std::vector<char> chars;
+
+	color current_color;
+};
+
+} //namespace renderer
+} //namespace openage
+
+#endif
@@ -0,0 +1,127 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#include "gl_backend.h"
+
+#include "../crossplatform/opengl.h"
+#include "../font.h"
+#include "impostor.h"
+#include "static_sprites.h"
+
+namespace openage {
+namespace renderer {
+
+GLBackend::GLBackend(size_t impostor_budget)
+	:
+	impostor_budget{impostor_budget},
+	impostor_renders_left{impostor_budget},
+	impostor_renders{0} {}
+
+void GLBackend::execute(const CommandList &commands) {
+	const std::vector<sprite_quad> &sprites = commands.get_sprites();
+
+	for (const command &c : commands.get_commands()) {
+		switch (c.type) {
+		case command_type::sprites:
+			for (size_t i = c.first; i < c.first + c.count; i++) {
+				this->batch.add(sprites[i]);
+			}
+			break;
+
+		case command_type::lines:
+		case command_type::quads:
+			// drawn directly on top of the sprites queued so far
+			this->batch.flush();
+			this->draw_geometry(commands, c);
+			break;
+
+		case command_type::text:
+			this->batch.flush();
+			this->draw_text(commands, c);
+			break;
+
+		case command_type::static_sprites:
+			this->batch.flush();
+			glPushMatrix();
+			glTranslatef(c.x, c.y, 0);
+			this->batch.draw_static(c.buffer);
+			glPopMatrix();
+			break;
+
+		case command_type::impostor:
+			this->draw_impostor(c);
+			break;
+		}
+	}
+
+	this->batch.flush();
+}
+
+void GLBackend::draw_geometry(const CommandList &commands, const command &c) {
+	const float *vertices = &commands.get_vertices()[c.first * 2];
+
+	glColor4f(c.col.r, c.col.g, c.col.b, c.col.a);
+	if (c.type == command_type::lines) {
+		glLineWidth(c.line_width);
+		glBegin(GL_LINES);
+	} else {
+		glBegin(GL_QUADS);
+	}
+	for (size_t i = 0; i < c.count; i++) {
+		glVertex3f(vertices[i * 2], vertices[i * 2 + 1], 0);
+	}
+	glEnd();
+}
+
+void GLBackend::draw_impostor(const command &c) {
+	if (c.buffer->get_quad_count() == 0) {
+		return;
+	}
+
+	if (c.impostor->is_outdated(c.buffer)) {
+		if (this->impostor_renders_left == 0) {
+			// over budget for this frame, draw the full buffer instead
+			this->batch.flush();
+			glPushMatrix();
+			glTranslatef(c.x, c.y, 0);
+			this->batch.draw_static(c.buffer);
+			glPopMatrix();
+			return;
+		}
+
+		this->batch.flush();
+		c.impostor->render(&this->batch, c.buffer);
+		this->impostor_renders_left -= 1;
+		this->impostor_renders += 1;
+	}
+
+	this->batch.add(c.impostor->get_quad(c.x, c.y));
+}
+
+void GLBackend::draw_text(const CommandList &commands, const command &c) {
+	const char *text = &commands.get_chars()[c.first];
+
+	glColor4f(c.col.r, c.col.g, c.col.b, c.col.a);
+	c.font->internal_font->Render(text, c.count, FTPoint(c.x, c.y));
+}
+
+batch_stats GLBackend::get_stats() const {
+	batch_stats stats = this->batch.get_stats();
+	stats.impostor_renders = this->impostor_renders;
+	return stats;
+}
+
+void GLBackend::reset_stats() {
+	this->batch.reset_stats();
+	this->impostor_renders = 0;
+}
+
+void GLBackend::begin_frame() {
+	this->impostor_renders_left = this->impostor_budget;
+}
+
+void GLBackend::release_gl() {
+	this->batch.release_gl();
+}
+
+} //namespace renderer
+} //namespace openage
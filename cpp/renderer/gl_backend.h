@@ -0,0 +1,63 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#ifndef OPENAGE_RENDERER_GL_BACKEND_H_
+#define OPENAGE_RENDERER_GL_BACKEND_H_
+
+#include "backend.h"
+#include "sprite_batch.h"
+
+namespace openage {
+namespace renderer {
+
+/**
+ * draws command lists with opengl.
+ *
+ * sprites are collected in a sprite batch, which is flushed
+ * whenever other geometry or text has to be drawn on top.
+ */
+class GLBackend : public Backend {
+public:
+	/**
+	 * impostors rendered per frame at most, the other outdated
+	 * ones are drawn from their buffers until their turn comes.
+	 */
+	static constexpr size_t default_impostor_budget = 4;
+
+	GLBackend(size_t impostor_budget = default_impostor_budget);
+	virtual ~GLBackend() = default;
+
+	void execute(const CommandList &commands) override;
+
+	/**
+	 * the draw call counters of the sprite batch.
+	 */
+	batch_stats get_stats() const;
+
+	void reset_stats();
+
+	/**
+	 * start a new frame, which renews the impostor budget.
+	 */
+	void begin_frame();
+
+	/**
+	 * free the gl resources while the context is still current.
+	 */
+	void release_gl();
+
+private:
+	void draw_geometry(const CommandList &commands, const command &c);
+	void draw_text(const CommandList &commands, const command &c);
+	void draw_impostor(const command &c);
+
+	SpriteBatch batch;
+
+	size_t impostor_budget;
+	size_t impostor_renders_left;
+	size_t impostor_renders;
+};
+
+} //namespace renderer
+} //namespace openage
+
+#endif
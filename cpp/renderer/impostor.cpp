@@ -0,0 +1,164 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#include "impostor.h"
+
+#include <cmath>
+
+#include "../util/error.h"
+#include "static_sprites.h"
+
+namespace openage {
+namespace renderer {
+
+Impostor::Impostor(float scale)
+	:
+	scale{scale},
+	left{0},
+	right{0},
+	bottom{0},
+	top{0},
+	texture_w{0},
+	texture_h{0},
+	content{nullptr},
+	content_revision{0},
+	rendered{false},
+	gl_ready{false},
+	texture{0},
+	framebuffer{0} {}
+
+Impostor::~Impostor() {
+	this->release_gl();
+}
+
+bool Impostor::is_supported() {
+	return GLEW_ARB_framebuffer_object;
+}
+
+void Impostor::set_scale(float scale) {
+	if (scale != this->scale) {
+		this->scale = scale;
+		this->rendered = false;
+	}
+}
+
+bool Impostor::is_outdated(const StaticSprites *content) const {
+	return (not this->rendered or
+	        this->content != content or
+	        this->content_revision != content->get_revision());
+}
+
+void Impostor::render(SpriteBatch *batch, StaticSprites *content) {
+	content->get_bounds(&this->left, &this->right, &this->bottom, &this->top);
+
+	int w = std::ceil((this->right - this->left) * this->scale);
+	int h = std::ceil((this->top - this->bottom) * this->scale);
+	if (w <= 0 or h <= 0) {
+		throw util::Error{"impostor of an empty sprite buffer"};
+	}
+
+	// the chunk buffers keep their size, so this rarely reallocates
+	if (w != this->texture_w or h != this->texture_h) {
+		this->release_gl();
+		this->texture_w = w;
+		this->texture_h = h;
+	}
+
+	if (not this->gl_ready) {
+		glGenTextures(1, &this->texture);
+		glBindTexture(GL_TEXTURE_2D, this->texture);
+		glTexImage2D(
+			GL_TEXTURE_2D, 0,
+			GL_RGBA8, this->texture_w, this->texture_h, 0,
+			GL_RGBA, GL_UNSIGNED_BYTE, nullptr
+		);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		glGenFramebuffers(1, &this->framebuffer);
+		glBindFramebuffer(GL_FRAMEBUFFER, this->framebuffer);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, this->texture, 0);
+		GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		this->gl_ready = true;
+
+		if (status != GL_FRAMEBUFFER_COMPLETE) {
+			this->release_gl();
+			throw util::Error{"impostor framebuffer of %dx%d is incomplete: 0x%x",
+			                  this->texture_w, this->texture_h, status};
+		}
+	}
+
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, this->framebuffer);
+	glViewport(0, 0, this->texture_w, this->texture_h);
+	glClearColor(0, 0, 0, 0);
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	glMatrixMode(GL_PROJECTION);
+	glPushMatrix();
+	glLoadIdentity();
+	glOrtho(this->left, this->right, this->bottom, this->top, 9001, -1);
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glLoadIdentity();
+
+	// keep the coverage in the alpha channel instead of squaring it,
+	// so the transparent borders don't darken when drawn again.
+	glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+	batch->draw_static(content);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	glPopMatrix();
+	glMatrixMode(GL_PROJECTION);
+	glPopMatrix();
+	glMatrixMode(GL_MODELVIEW);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+	glBindTexture(GL_TEXTURE_2D, this->texture);
+	glGenerateMipmap(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	this->content = content;
+	this->content_revision = content->get_revision();
+	this->rendered = true;
+}
+
+sprite_quad Impostor::get_quad(float x, float y) const {
+	sprite_quad quad;
+	quad.program = sprite_program::plain;
+	quad.texture = this->texture;
+	quad.mask_texture = 0;
+	quad.left = this->left + x;
+	quad.right = this->right + x;
+	quad.top = this->top + y;
+	quad.bottom = this->bottom + y;
+
+	// rendered textures start at the bottom row
+	quad.txl = 0;
+	quad.txr = 1;
+	quad.txt = 1;
+	quad.txb = 0;
+
+	quad.mtxl = quad.mtxr = quad.mtxt = quad.mtxb = 0;
+	quad.player = 0;
+	return quad;
+}
+
+void Impostor::release_gl() {
+	if (this->gl_ready) {
+		glDeleteFramebuffers(1, &this->framebuffer);
+		glDeleteTextures(1, &this->texture);
+		this->gl_ready = false;
+	}
+	this->rendered = false;
+}
+
+} //namespace renderer
+} //namespace openage
@@ -0,0 +1,88 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#ifndef OPENAGE_RENDERER_IMPOSTOR_H_
+#define OPENAGE_RENDERER_IMPOSTOR_H_
+
+#include <cstdint>
+
+#include "../crossplatform/opengl.h"
+#include "sprite_batch.h"
+
+namespace openage {
+namespace renderer {
+
+class StaticSprites;
+
+/**
+ * a prebuilt sprite buffer rendered once into a texture,
+ * to be drawn as a single quad when seen from far away.
+ *
+ * the texture covers the bounds of the buffer and is rendered
+ * again when the buffer was rebuilt. it has mipmaps, so it can
+ * be drawn much smaller than its size.
+ */
+class Impostor {
+public:
+	/**
+	 * the texture has scale pixels per unit of the sprite coordinates.
+	 */
+	Impostor(float scale=1);
+	~Impostor();
+
+	Impostor(const Impostor &) = delete;
+	Impostor &operator =(const Impostor &) = delete;
+
+	/**
+	 * true if the gl implementation can render to textures.
+	 */
+	static bool is_supported();
+
+	/**
+	 * change the resolution, the texture is rendered again on the next use.
+	 */
+	void set_scale(float scale);
+
+	/**
+	 * true if the texture doesn't show the current contents of the buffer.
+	 */
+	bool is_outdated(const StaticSprites *content) const;
+
+	/**
+	 * render the buffer into the texture, which must not be empty.
+	 * the gl state of the batch is reset afterwards,
+	 * and it must have no sprites queued.
+	 */
+	void render(SpriteBatch *batch, StaticSprites *content);
+
+	/**
+	 * the quad showing the texture, translated by x, y.
+	 */
+	sprite_quad get_quad(float x, float y) const;
+
+	/**
+	 * free the gl objects while the context is still current.
+	 * the texture is rendered again on the next use.
+	 */
+	void release_gl();
+
+private:
+	float scale;
+
+	/** the area shown by the texture, in sprite coordinates */
+	float left, right, bottom, top;
+	int texture_w, texture_h;
+
+	/** the buffer and its revision shown by the texture */
+	const StaticSprites *content;
+	uint32_t content_revision;
+	bool rendered;
+
+	bool gl_ready;
+	GLuint texture;
+	GLuint framebuffer;
+};
+
+} //namespace renderer
+} //namespace openage
+
+#endif
@@ -0,0 +1,123 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#include "null_backend.h"
+
+#include "static_sprites.h"
+
+namespace openage {
+namespace renderer {
+
+namespace {
+
+// 64 bit fnv-1a
+constexpr uint64_t fnv_offset = 0xcbf29ce484222325;
+constexpr uint64_t fnv_prime  = 0x100000001b3;
+
+} //anonymous namespace
+
+NullBackend::NullBackend() {
+	this->reset();
+}
+
+void NullBackend::execute(const CommandList &commands) {
+	const std::vector<sprite_quad> &sprites = commands.get_sprites();
+	const std::vector<float> &vertices = commands.get_vertices();
+	const std::vector<char> &chars = commands.get_chars();
+
+	this->stats.lists += 1;
+
+	for (const command &c : commands.get_commands()) {
+		this->stats.commands += 1;
+		this->hash((uint64_t) c.type);
+
+		switch (c.type) {
+		case command_type::sprites:
+			this->stats.sprites += c.count;
+			for (size_t i = c.first; i < c.first + c.count; i++) {
+				// the members are hashed one by one,
+				// the padding of the struct is undefined.
+				const sprite_quad &q = sprites[i];
+				this->hash((uint64_t) q.program);
+				this->hash((uint64_t) q.texture);
+				this->hash((uint64_t) q.mask_texture);
+				this->hash((uint64_t) q.player);
+				for (float f : {q.left, q.right, q.top, q.bottom,
+				                q.txl, q.txr, q.txt, q.txb,
+				                q.mtxl, q.mtxr, q.mtxt, q.mtxb}) {
+					this->hash(f);
+				}
+			}
+			break;
+
+		case command_type::lines:
+		case command_type::quads:
+			this->stats.vertices += c.count;
+			for (float f : {c.col.r, c.col.g, c.col.b, c.col.a, c.line_width}) {
+				this->hash(f);
+			}
+			this->hash(vertices.data() + c.first * 2, c.count * 2 * sizeof(float));
+			break;
+
+		case command_type::text:
+			this->stats.texts += 1;
+			this->stats.chars += c.count;
+			for (float f : {c.col.r, c.col.g, c.col.b, c.col.a, c.x, c.y}) {
+				this->hash(f);
+			}
+			this->hash(&chars[c.first], c.count);
+			break;
+
+		case command_type::static_sprites:
+			// the buffer address differs between runs,
+			// its revision identifies the contents.
+			this->stats.static_buffers += 1;
+			this->stats.static_sprites += c.buffer->get_quad_count();
+			this->hash((uint64_t) c.buffer->get_revision());
+			this->hash((uint64_t) c.buffer->get_quad_count());
+			this->hash(c.x);
+			this->hash(c.y);
+			break;
+
+		case command_type::impostor:
+			// drawn from the same contents as the buffer itself
+			this->stats.impostors += 1;
+			this->hash((uint64_t) c.buffer->get_revision());
+			this->hash((uint64_t) c.buffer->get_quad_count());
+			this->hash(c.x);
+			this->hash(c.y);
+			break;
+		}
+	}
+}
+
+const command_stats &NullBackend::get_stats() const {
+	return this->stats;
+}
+
+uint64_t NullBackend::get_digest() const {
+	return this->digest;
+}
+
+void NullBackend::reset() {
+	this->stats = command_stats{};
+	this->digest = fnv_offset;
+}
+
+void NullBackend::hash(const void *data, size_t size) {
+	const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+	for (size_t i = 0; i < size; i++) {
+		this->digest ^= bytes[i];
+		this->digest *= fnv_prime;
+	}
+}
+
+void NullBackend::hash(float value) {
+	this->hash(&value, sizeof(value));
+}
+
+void NullBackend::hash(uint64_t value) {
+	this->hash(&value, sizeof(value));
+}
+
+} //namespace renderer
+} //namespace openage
@@ -0,0 +1,65 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#ifndef OPENAGE_RENDERER_NULL_BACKEND_H_
+#define OPENAGE_RENDERER_NULL_BACKEND_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "backend.h"
+
+namespace openage {
+namespace renderer {
+
+/**
+ * what a null backend was asked to draw.
+ */
+struct command_stats {
+	size_t lists;
+	size_t commands;
+	size_t sprites;
+	size_t vertices;
+	size_t texts;
+	size_t chars;
+	size_t static_buffers;
+	size_t static_sprites;
+	size_t impostors;
+};
+
+/**
+ * a backend that draws nothing, but counts the commands
+ * and hashes their contents.
+ *
+ * use it to measure the cpu cost of preparing frames without
+ * a gpu, and to detect changes in what is drawn:
+ * equal frames give equal digests.
+ */
+class NullBackend : public Backend {
+public:
+	NullBackend();
+	virtual ~NullBackend() = default;
+
+	void execute(const CommandList &commands) override;
+
+	const command_stats &get_stats() const;
+
+	/**
+	 * hash of all commands executed since the last reset.
+	 */
+	uint64_t get_digest() const;
+
+	void reset();
+
+private:
+	void hash(const void *data, size_t size);
+	void hash(float value);
+	void hash(uint64_t value);
+
+	command_stats stats;
+	uint64_t digest;
+};
+
+} //namespace renderer
+} //namespace openage
+
+#endif
@@ -0,0 +1,444 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#include "sprite_batch.h"
+
+#include <algorithm>
+#include <tuple>
+
+#include "../texture.h"
+#include "../util/error.h"
+#include "static_sprites.h"
+
+namespace openage {
+namespace renderer {
+
+namespace {
+
+/**
+ * the vertex attributes of a sprite program.
+ * attributes the program doesn't have are -1.
+ */
+struct program_attributes {
+	shader::Program *program;
+	GLint pos, tex_coord, mask_coord, player;
+	GLint layer_coord[max_blend_layers], layer_count;
+};
+
+program_attributes attributes_of(sprite_program program) {
+	program_attributes attr;
+	attr.mask_coord = -1;
+	attr.player = -1;
+	for (unsigned i = 0; i < max_blend_layers; i++) {
+		attr.layer_coord[i] = -1;
+	}
+	attr.layer_count = -1;
+
+	switch (program) {
+	case sprite_program::teamcolor:
+		attr.program = teamcolor_shader::program;
+		attr.tex_coord = teamcolor_shader::tex_coord;
+		attr.player = teamcolor_shader::player_id_var;
+		break;
+	case sprite_program::alphamask:
+		attr.program = alphamask_shader::program;
+		attr.tex_coord = alphamask_shader::base_coord;
+		attr.mask_coord = alphamask_shader::mask_coord;
+		break;
+	case sprite_program::terrain_blend:
+		attr.program = terrain_blend_shader::program;
+		attr.tex_coord = terrain_blend_shader::base_coord;
+		for (unsigned i = 0; i < max_blend_layers; i++) {
+			attr.layer_coord[i] = terrain_blend_shader::layer_coord[i];
+		}
+		attr.layer_count = terrain_blend_shader::layer_count;
+		break;
+	case sprite_program::plain:
+	default:
+		attr.program = texture_shader::program;
+		attr.tex_coord = texture_shader::tex_coord;
+		break;
+	}
+
+	attr.pos = attr.program->pos_id;
+	return attr;
+}
+
+/**
+ * enable or disable all vertex attribute arrays of a program.
+ */
+void set_attributes_enabled(const program_attributes &attr, bool enabled) {
+	auto set = [enabled](GLint id) {
+		if (id < 0) {
+			return;
+		}
+		if (enabled) {
+			glEnableVertexAttribArray(id);
+		} else {
+			glDisableVertexAttribArray(id);
+		}
+	};
+
+	for (GLint id : {attr.pos, attr.tex_coord, attr.mask_coord, attr.player, attr.layer_count}) {
+		set(id);
+	}
+	for (GLint id : attr.layer_coord) {
+		set(id);
+	}
+}
+
+} //anonymous namespace
+
+void append_vertices(const sprite_quad &q, std::vector<sprite_vertex> *vertices) {
+	float player = q.player;
+	vertices->push_back({q.left,  q.top,    q.txl, q.txt, q.mtxl, q.mtxt, player});
+	vertices->push_back({q.left,  q.bottom, q.txl, q.txb, q.mtxl, q.mtxb, player});
+	vertices->push_back({q.right, q.bottom, q.txr, q.txb, q.mtxr, q.mtxb, player});
+	vertices->push_back({q.right, q.top,    q.txr, q.txt, q.mtxr, q.mtxt, player});
+}
+
+void append_vertices(const terrain_quad &q, std::vector<terrain_vertex> *vertices) {
+	// the corners in the order of the index pattern,
+	// as flags for choosing right and bottom coordinates.
+	constexpr bool right[]  = {false, false, true, true};
+	constexpr bool bottom[] = {false, true, true, false};
+
+	for (int c = 0; c < 4; c++) {
+		terrain_vertex v;
+		v.x = right[c] ? q.right : q.left;
+		v.y = bottom[c] ? q.bottom : q.top;
+		v.u = right[c] ? q.txr : q.txl;
+		v.v = bottom[c] ? q.txb : q.txt;
+		for (unsigned i = 0; i < max_blend_layers; i++) {
+			if (i < q.layer_count) {
+				v.layers[i][0] = right[c] ? q.layers[i].txr : q.layers[i].txl;
+				v.layers[i][1] = bottom[c] ? q.layers[i].txb : q.layers[i].txt;
+				v.layers[i][2] = right[c] ? q.layers[i].mtxr : q.layers[i].mtxl;
+				v.layers[i][3] = bottom[c] ? q.layers[i].mtxb : q.layers[i].mtxt;
+			} else {
+				v.layers[i][0] = v.layers[i][1] = v.layers[i][2] = v.layers[i][3] = 0;
+			}
+		}
+		v.layer_count = q.layer_count;
+		vertices->push_back(v);
+	}
+}
+
+SpriteBatch::SpriteBatch(size_t ring_quads)
+	:
+	layer{0},
+	ring_quads{ring_quads},
+	ring_pos{0},
+	gl_ready{false},
+	vertbuf{0},
+	indexbuf{0},
+	state_valid{false},
+	current_program{sprite_program::plain},
+	current_texture{0},
+	current_mask{0},
+	stats{} {
+	if (ring_quads == 0 or ring_quads > max_quads) {
+		throw util::Error{"sprite batch ring size %zu not in [1, %zu]", ring_quads, max_quads};
+	}
+}
+
+SpriteBatch::~SpriteBatch() {
+	this->release_gl();
+}
+
+void SpriteBatch::add(const sprite_quad &quad) {
+	this->begin_layer();
+	this->add(quad, 0);
+}
+
+void SpriteBatch::begin_layer() {
+	this->layer += 1;
+}
+
+void SpriteBatch::add(const sprite_quad &quad, unsigned depth) {
+	uint32_t seq = this->entries.size();
+	this->entries.push_back({this->layer, depth, seq, quad});
+}
+
+size_t SpriteBatch::pending() const {
+	return this->entries.size();
+}
+
+const batch_stats &SpriteBatch::get_stats() const {
+	return this->stats;
+}
+
+void SpriteBatch::reset_stats() {
+	this->stats = batch_stats{};
+}
+
+void SpriteBatch::create_gl() {
+	glGenBuffers(1, &this->vertbuf);
+	glBindBuffer(GL_ARRAY_BUFFER, this->vertbuf);
+	glBufferData(GL_ARRAY_BUFFER, this->ring_quads * 4 * sizeof(sprite_vertex), nullptr, GL_STREAM_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	// the index pattern is the same for all quads,
+	// as every draw points the attributes to its first vertex.
+	std::vector<GLushort> indices;
+	indices.reserve(this->ring_quads * 6);
+	for (size_t i = 0; i < this->ring_quads; i++) {
+		GLushort base = i * 4;
+		for (GLushort corner : {0, 1, 2, 2, 3, 0}) {
+			indices.push_back(base + corner);
+		}
+	}
+
+	glGenBuffers(1, &this->indexbuf);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->indexbuf);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLushort), indices.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+	this->ring_pos = 0;
+	this->gl_ready = true;
+}
+
+void SpriteBatch::release_gl() {
+	if (this->gl_ready) {
+		glDeleteBuffers(1, &this->vertbuf);
+		glDeleteBuffers(1, &this->indexbuf);
+		this->gl_ready = false;
+	}
+}
+
+void SpriteBatch::flush() {
+	if (this->entries.empty()) {
+		this->layer = 0;
+		return;
+	}
+
+	if (not this->gl_ready) {
+		this->create_gl();
+	}
+
+	// sort by drawing position, then by gl state.
+	size_t count = this->entries.size();
+	this->order.resize(count);
+	for (size_t i = 0; i < count; i++) {
+		this->order[i] = i;
+	}
+
+	const std::vector<entry> &e = this->entries;
+	std::sort(std::begin(this->order), std::end(this->order), [&e](uint32_t a, uint32_t b) {
+		const entry &x = e[a], &y = e[b];
+		return std::tie(x.layer, x.depth, x.quad.program, x.quad.texture, x.quad.mask_texture, x.seq)
+		     < std::tie(y.layer, y.depth, y.quad.program, y.quad.texture, y.quad.mask_texture, y.seq);
+	});
+
+	glColor4f(1, 1, 1, 1);
+	glBindBuffer(GL_ARRAY_BUFFER, this->vertbuf);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->indexbuf);
+
+	// consecutive sprites with the same state are drawn together,
+	// even if they are on different layers.
+	size_t run_start = 0;
+	for (size_t i = 1; i <= count; i++) {
+		if (i < count) {
+			const sprite_quad &a = e[this->order[run_start]].quad;
+			const sprite_quad &b = e[this->order[i]].quad;
+			if (a.program == b.program and
+			    a.texture == b.texture and
+			    a.mask_texture == b.mask_texture) {
+				continue;
+			}
+		}
+		this->draw_run(run_start, i - run_start);
+		run_start = i;
+	}
+
+	this->reset_state();
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	this->stats.sprites += count;
+	this->stats.flushes += 1;
+	this->entries.clear();
+	this->layer = 0;
+}
+
+void SpriteBatch::draw_run(size_t first, size_t count) {
+	const sprite_quad &state = this->entries[this->order[first]].quad;
+	this->use_state(state.program, state.texture, state.mask_texture);
+
+	// runs larger than the ring are split
+	while (count > 0) {
+		size_t quads = std::min(count, this->ring_quads);
+
+		// orphan the buffer when the ring is full, so the driver
+		// doesn't have to wait for draws still reading it.
+		if (this->ring_pos + quads > this->ring_quads) {
+			glBufferData(GL_ARRAY_BUFFER, this->ring_quads * 4 * sizeof(sprite_vertex), nullptr, GL_STREAM_DRAW);
+			this->ring_pos = 0;
+			this->stats.buffer_orphans += 1;
+		}
+
+		this->vertices.clear();
+		for (size_t i = first; i < first + quads; i++) {
+			append_vertices(this->entries[this->order[i]].quad, &this->vertices);
+		}
+
+		size_t offset = this->ring_pos * 4 * sizeof(sprite_vertex);
+		glBufferSubData(GL_ARRAY_BUFFER, offset, this->vertices.size() * sizeof(sprite_vertex), this->vertices.data());
+		this->draw_quads(state.program, offset, quads);
+
+		this->ring_pos += quads;
+		first += quads;
+		count -= quads;
+	}
+}
+
+void SpriteBatch::draw_quads(sprite_program program, size_t offset, size_t quads) {
+	program_attributes attr = attributes_of(program);
+
+	// point the attributes at the first vertex of the quads,
+	// so the shared index pattern can be used.
+	auto at = [offset](size_t member) {
+		return reinterpret_cast<void *>(offset + member);
+	};
+	glVertexAttribPointer(attr.pos, 2, GL_FLOAT, GL_FALSE, sizeof(sprite_vertex), at(offsetof(sprite_vertex, x)));
+	glVertexAttribPointer(attr.tex_coord, 2, GL_FLOAT, GL_FALSE, sizeof(sprite_vertex), at(offsetof(sprite_vertex, u)));
+	if (attr.mask_coord >= 0) {
+		glVertexAttribPointer(attr.mask_coord, 2, GL_FLOAT, GL_FALSE, sizeof(sprite_vertex), at(offsetof(sprite_vertex, mask_u)));
+	}
+	if (attr.player >= 0) {
+		glVertexAttribPointer(attr.player, 1, GL_FLOAT, GL_FALSE, sizeof(sprite_vertex), at(offsetof(sprite_vertex, player)));
+	}
+
+	glDrawElements(GL_TRIANGLES, quads * 6, GL_UNSIGNED_SHORT, nullptr);
+	this->stats.draw_calls += 1;
+}
+
+void SpriteBatch::draw_terrain_quads(size_t offset, size_t quads) {
+	program_attributes attr = attributes_of(sprite_program::terrain_blend);
+
+	auto at = [offset](size_t member) {
+		return reinterpret_cast<void *>(offset + member);
+	};
+	glVertexAttribPointer(attr.pos, 2, GL_FLOAT, GL_FALSE, sizeof(terrain_vertex), at(offsetof(terrain_vertex, x)));
+	glVertexAttribPointer(attr.tex_coord, 2, GL_FLOAT, GL_FALSE, sizeof(terrain_vertex), at(offsetof(terrain_vertex, u)));
+	for (unsigned i = 0; i < max_blend_layers; i++) {
+		size_t layer = offsetof(terrain_vertex, layers) + i * 4 * sizeof(float);
+		glVertexAttribPointer(attr.layer_coord[i], 4, GL_FLOAT, GL_FALSE, sizeof(terrain_vertex), at(layer));
+	}
+	glVertexAttribPointer(attr.layer_count, 1, GL_FLOAT, GL_FALSE, sizeof(terrain_vertex), at(offsetof(terrain_vertex, layer_count)));
+
+	glDrawElements(GL_TRIANGLES, quads * 6, GL_UNSIGNED_SHORT, nullptr);
+	this->stats.draw_calls += 1;
+}
+
+void SpriteBatch::draw_static(StaticSprites *sprites) {
+	if (sprites->runs.empty() and sprites->terrain_runs.empty()) {
+		return;
+	}
+
+	if (not this->gl_ready) {
+		this->create_gl();
+	}
+
+	if (not sprites->gl_ready) {
+		glGenBuffers(1, &sprites->vertbuf);
+		sprites->gl_ready = true;
+		sprites->upload_pending = true;
+	}
+
+	// the terrain vertices are stored after the sprite vertices
+	size_t sprite_bytes = sprites->vertices.size() * sizeof(sprite_vertex);
+	size_t terrain_bytes = sprites->terrain_vertices.size() * sizeof(terrain_vertex);
+
+	glBindBuffer(GL_ARRAY_BUFFER, sprites->vertbuf);
+	if (sprites->upload_pending) {
+		glBufferData(GL_ARRAY_BUFFER, sprite_bytes + terrain_bytes, nullptr, GL_STATIC_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, sprite_bytes, sprites->vertices.data());
+		glBufferSubData(GL_ARRAY_BUFFER, sprite_bytes, terrain_bytes, sprites->terrain_vertices.data());
+		sprites->upload_pending = false;
+		this->stats.static_uploads += 1;
+	}
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->indexbuf);
+
+	glColor4f(1, 1, 1, 1);
+
+	// the index pattern limits the quads per draw
+	for (auto &run : sprites->terrain_runs) {
+		this->use_state(run.program, run.texture, run.mask_texture);
+		for (size_t done = 0; done < run.count;) {
+			size_t quads = std::min(run.count - done, this->ring_quads);
+			this->draw_terrain_quads(sprite_bytes + (run.first + done) * 4 * sizeof(terrain_vertex), quads);
+			done += quads;
+		}
+	}
+
+	for (auto &run : sprites->runs) {
+		this->use_state(run.program, run.texture, run.mask_texture);
+		for (size_t done = 0; done < run.count;) {
+			size_t quads = std::min(run.count - done, this->ring_quads);
+			this->draw_quads(run.program, (run.first + done) * 4 * sizeof(sprite_vertex), quads);
+			done += quads;
+		}
+	}
+	this->stats.sprites += sprites->get_quad_count();
+
+	this->reset_state();
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void SpriteBatch::use_state(sprite_program program, GLuint texture, GLuint mask_texture) {
+	if (not this->state_valid or program != this->current_program) {
+		if (this->state_valid) {
+			set_attributes_enabled(attributes_of(this->current_program), false);
+		}
+
+		program_attributes attr = attributes_of(program);
+		attr.program->use();
+		set_attributes_enabled(attr, true);
+		this->current_program = program;
+		this->stats.program_changes += 1;
+	}
+
+	bool masked = (program == sprite_program::alphamask or
+	               program == sprite_program::terrain_blend);
+	if (masked and
+	    (not this->state_valid or mask_texture != this->current_mask)) {
+		glActiveTexture(GL_TEXTURE1);
+		glBindTexture(GL_TEXTURE_2D, mask_texture);
+		glActiveTexture(GL_TEXTURE0);
+		this->current_mask = mask_texture;
+		this->stats.texture_changes += 1;
+	}
+
+	if (not this->state_valid or texture != this->current_texture) {
+		glBindTexture(GL_TEXTURE_2D, texture);
+		this->current_texture = texture;
+		this->stats.texture_changes += 1;
+	}
+
+	this->state_valid = true;
+}
+
+void SpriteBatch::reset_state() {
+	if (not this->state_valid) {
+		return;
+	}
+
+	program_attributes attr = attributes_of(this->current_program);
+	set_attributes_enabled(attr, false);
+	attr.program->stopusing();
+
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	// the next flush may start with an unmasked program,
+	// which doesn't rebind the mask texture.
+	this->current_texture = 0;
+	this->current_mask = 0;
+	this->state_valid = false;
+}
+
+} //namespace renderer
+} //namespace openage
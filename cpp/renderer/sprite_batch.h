@@ -0,0 +1,274 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#ifndef OPENAGE_RENDERER_SPRITE_BATCH_H_
+#define OPENAGE_RENDERER_SPRITE_BATCH_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../crossplatform/opengl.h"
+
+namespace openage {
+namespace renderer {
+
+/**
+ * the shader programs a sprite can be drawn with.
+ */
+enum class sprite_program : uint8_t {
+	plain,
+	teamcolor,
+	alphamask,
+	/** only for terrain quads, see StaticSprites */
+	terrain_blend,
+};
+
+/**
+ * one textured quad to be drawn.
+ * positions are in the coordinate system of the current modelview matrix.
+ */
+struct sprite_quad {
+	sprite_program program;
+	GLuint texture;
+	GLuint mask_texture;
+
+	float left, right, top, bottom;
+
+	/** texture coordinates */
+	float txl, txr, txt, txb;
+
+	/** mask texture coordinates, only used for alphamask sprites */
+	float mtxl, mtxr, mtxt, mtxb;
+
+	unsigned player;
+};
+
+/**
+ * vertex layout of the sprite vertex buffers.
+ */
+struct sprite_vertex {
+	float x, y;
+	float u, v;
+	float mask_u, mask_v;
+	float player;
+};
+
+/**
+ * append the four vertices of a quad.
+ */
+void append_vertices(const sprite_quad &quad, std::vector<sprite_vertex> *vertices);
+
+/**
+ * number of neighbor layers blended over a terrain tile in one pass.
+ * limited by the varyings guaranteed by glsl 1.20.
+ */
+constexpr unsigned max_blend_layers = 4;
+
+/**
+ * a terrain tile together with the influences of its neighbors,
+ * drawn in one pass by the terrain blending shader.
+ *
+ * the layers are drawn over the base in order, each one is a
+ * subtexture of the base texture masked by a blending mask.
+ * all masks are subtextures of the same mask texture.
+ */
+struct terrain_quad {
+	GLuint texture;
+	GLuint mask_texture;
+
+	float left, right, top, bottom;
+
+	/** texture coordinates of the base tile */
+	float txl, txr, txt, txb;
+
+	unsigned layer_count;
+	struct {
+		/** texture coordinates of the layer and of its mask */
+		float txl, txr, txt, txb;
+		float mtxl, mtxr, mtxt, mtxb;
+	} layers[max_blend_layers];
+};
+
+/**
+ * vertex layout of terrain quads.
+ */
+struct terrain_vertex {
+	float x, y;
+	float u, v;
+
+	/** per layer: texture u, v and mask u, v */
+	float layers[max_blend_layers][4];
+	float layer_count;
+};
+
+/**
+ * append the four vertices of a terrain quad.
+ */
+void append_vertices(const terrain_quad &quad, std::vector<terrain_vertex> *vertices);
+
+class StaticSprites;
+
+/**
+ * counters about the gl work done for the sprites.
+ */
+struct batch_stats {
+	size_t sprites;
+	size_t draw_calls;
+	size_t program_changes;
+	size_t texture_changes;
+	size_t buffer_orphans;
+	size_t static_uploads;
+	size_t impostor_renders;
+	size_t flushes;
+
+	/** gl state changes, that is program switches and texture binds */
+	size_t state_changes() const {
+		return this->program_changes + this->texture_changes;
+	}
+};
+
+/**
+ * collects textured quads and draws them with as few gl calls as possible.
+ *
+ * each sprite gets a (layer, depth) drawing position.
+ * layers are drawn in the order they were started,
+ * within a layer, lower depth is drawn first.
+ * sprites of equal layer and depth may be drawn in any order,
+ * so they are grouped by (program, texture, mask texture) and
+ * every group is submitted as one indexed draw call.
+ *
+ * vertex data is streamed into a ring buffer which is only
+ * orphaned once it is full.
+ *
+ * the batch needs the globally initialized shader programs
+ * from texture.h, and a gl context for flushing.
+ */
+class SpriteBatch {
+public:
+	/**
+	 * maximum number of quads in the vertex ring buffer.
+	 * limited by the 16 bit indices.
+	 */
+	static constexpr size_t max_quads = 16384;
+
+	SpriteBatch(size_t ring_quads=8192);
+	~SpriteBatch();
+
+	SpriteBatch(const SpriteBatch &) = delete;
+	SpriteBatch &operator =(const SpriteBatch &) = delete;
+
+	/**
+	 * add a sprite on top of everything added before.
+	 * this starts a new layer.
+	 */
+	void add(const sprite_quad &quad);
+
+	/**
+	 * start a new layer, drawn on top of everything added before.
+	 */
+	void begin_layer();
+
+	/**
+	 * add a sprite to the most recently started layer.
+	 * sprites of the same depth must not overlap, as their
+	 * drawing order is undefined.
+	 */
+	void add(const sprite_quad &quad, unsigned depth);
+
+	/**
+	 * draw all collected sprites.
+	 * call this before drawing anything directly with gl,
+	 * and before the modelview matrix is changed.
+	 */
+	void flush();
+
+	/**
+	 * draw prebuilt sprites, uploading them first if they changed.
+	 * flush before, as the queued sprites are not drawn.
+	 */
+	void draw_static(StaticSprites *sprites);
+
+	/**
+	 * number of sprites waiting for the next flush.
+	 */
+	size_t pending() const;
+
+	/**
+	 * return the counters collected since the last reset.
+	 */
+	const batch_stats &get_stats() const;
+
+	/**
+	 * zero the counters.
+	 */
+	void reset_stats();
+
+	/**
+	 * free the gl buffers while the context is still current.
+	 * they are recreated on the next flush.
+	 */
+	void release_gl();
+
+private:
+	/**
+	 * a collected sprite with its drawing position.
+	 */
+	struct entry {
+		uint32_t layer;
+		uint32_t depth;
+		uint32_t seq;
+		sprite_quad quad;
+	};
+
+	void create_gl();
+
+	/**
+	 * upload and draw count sorted sprites starting at the given one,
+	 * which all share the same gl state.
+	 */
+	void draw_run(size_t first, size_t count);
+
+	/**
+	 * draw quads from the bound vertex buffer, starting at the
+	 * given vertex buffer offset, with the current state.
+	 */
+	void draw_quads(sprite_program program, size_t offset, size_t quads);
+
+	/**
+	 * draw terrain quads like draw_quads.
+	 */
+	void draw_terrain_quads(size_t offset, size_t quads);
+
+	/**
+	 * switch to the program and textures of the given sprite.
+	 */
+	void use_state(sprite_program program, GLuint texture, GLuint mask_texture);
+
+	void reset_state();
+
+	std::vector<entry> entries;
+	std::vector<uint32_t> order;
+	std::vector<sprite_vertex> vertices;
+
+	uint32_t layer;
+
+	size_t ring_quads;
+	size_t ring_pos;
+
+	bool gl_ready;
+	GLuint vertbuf;
+	GLuint indexbuf;
+
+	/** currently bound gl state, valid during a flush */
+	bool state_valid;
+	sprite_program current_program;
+	GLuint current_texture;
+	GLuint current_mask;
+
+	batch_stats stats;
+};
+
+} //namespace renderer
+} //namespace openage
+
+#endif
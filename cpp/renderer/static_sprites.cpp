@@ -0,0 +1,158 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#include "static_sprites.h"
+
+#include <algorithm>
+#include <limits>
+#include <tuple>
+
+#include "../util/error.h"
+
+namespace openage {
+namespace renderer {
+
+StaticSprites::StaticSprites()
+	:
+	revision{0},
+	left{0},
+	right{0},
+	bottom{0},
+	top{0},
+	gl_ready{false},
+	upload_pending{false},
+	vertbuf{0} {}
+
+StaticSprites::~StaticSprites() {
+	this->release_gl();
+}
+
+void StaticSprites::build(const std::vector<sprite_command> &sprites) {
+	this->build(std::vector<terrain_quad>{}, sprites);
+}
+
+void StaticSprites::build(const std::vector<terrain_quad> &tiles, const std::vector<sprite_command> &sprites) {
+	// tiles without layers don't sample the mask, so sorting
+	// them first lets them join the run of any mask.
+	std::vector<uint32_t> tile_order(tiles.size());
+	for (size_t i = 0; i < tiles.size(); i++) {
+		tile_order[i] = i;
+	}
+
+	std::sort(std::begin(tile_order), std::end(tile_order), [&tiles](uint32_t a, uint32_t b) {
+		return std::tie(tiles[a].texture, tiles[a].mask_texture, a)
+		     < std::tie(tiles[b].texture, tiles[b].mask_texture, b);
+	});
+
+	this->terrain_vertices.clear();
+	this->terrain_vertices.reserve(tiles.size() * 4);
+	this->terrain_runs.clear();
+
+	for (size_t i = 0; i < tile_order.size(); i++) {
+		const terrain_quad &q = tiles[tile_order[i]];
+		append_vertices(q, &this->terrain_vertices);
+
+		if (this->terrain_runs.empty() or
+		    this->terrain_runs.back().texture != q.texture or
+		    (q.mask_texture != 0 and
+		     this->terrain_runs.back().mask_texture != 0 and
+		     this->terrain_runs.back().mask_texture != q.mask_texture)) {
+			this->terrain_runs.push_back({sprite_program::terrain_blend, q.texture, q.mask_texture, i, 0});
+		}
+		if (q.mask_texture != 0) {
+			this->terrain_runs.back().mask_texture = q.mask_texture;
+		}
+		this->terrain_runs.back().count += 1;
+	}
+
+	std::vector<uint32_t> order(sprites.size());
+	for (size_t i = 0; i < sprites.size(); i++) {
+		if (sprites[i].depth < 0) {
+			throw util::Error{"static sprite %zu has no depth", i};
+		}
+		order[i] = i;
+	}
+
+	std::sort(std::begin(order), std::end(order), [&sprites](uint32_t a, uint32_t b) {
+		const sprite_command &x = sprites[a], &y = sprites[b];
+		return std::tie(x.depth, x.quad.program, x.quad.texture, x.quad.mask_texture, a)
+		     < std::tie(y.depth, y.quad.program, y.quad.texture, y.quad.mask_texture, b);
+	});
+
+	this->vertices.clear();
+	this->vertices.reserve(sprites.size() * 4);
+	this->runs.clear();
+
+	for (size_t i = 0; i < order.size(); i++) {
+		const sprite_quad &q = sprites[order[i]].quad;
+		append_vertices(q, &this->vertices);
+
+		// like in the batch, runs may span depths
+		if (this->runs.empty() or
+		    this->runs.back().program != q.program or
+		    this->runs.back().texture != q.texture or
+		    this->runs.back().mask_texture != q.mask_texture) {
+			this->runs.push_back({q.program, q.texture, q.mask_texture, i, 0});
+		}
+		this->runs.back().count += 1;
+	}
+
+	this->left = this->bottom = std::numeric_limits<float>::max();
+	this->right = this->top = std::numeric_limits<float>::lowest();
+	auto extend = [this](float x, float y) {
+		this->left = std::min(this->left, x);
+		this->right = std::max(this->right, x);
+		this->bottom = std::min(this->bottom, y);
+		this->top = std::max(this->top, y);
+	};
+	for (auto &v : this->terrain_vertices) {
+		extend(v.x, v.y);
+	}
+	for (auto &v : this->vertices) {
+		extend(v.x, v.y);
+	}
+	if (this->get_quad_count() == 0) {
+		this->left = this->right = this->bottom = this->top = 0;
+	}
+
+	this->revision += 1;
+	this->upload_pending = true;
+}
+
+void StaticSprites::clear() {
+	this->vertices.clear();
+	this->runs.clear();
+	this->terrain_vertices.clear();
+	this->terrain_runs.clear();
+	this->left = this->right = this->bottom = this->top = 0;
+	this->revision += 1;
+	this->upload_pending = true;
+}
+
+size_t StaticSprites::get_quad_count() const {
+	return (this->vertices.size() + this->terrain_vertices.size()) / 4;
+}
+
+size_t StaticSprites::get_run_count() const {
+	return this->runs.size() + this->terrain_runs.size();
+}
+
+uint32_t StaticSprites::get_revision() const {
+	return this->revision;
+}
+
+void StaticSprites::get_bounds(float *left, float *right, float *bottom, float *top) const {
+	*left = this->left;
+	*right = this->right;
+	*bottom = this->bottom;
+	*top = this->top;
+}
+
+void StaticSprites::release_gl() {
+	if (this->gl_ready) {
+		glDeleteBuffers(1, &this->vertbuf);
+		this->gl_ready = false;
+	}
+}
+
+} //namespace renderer
+} //namespace openage
@@ -0,0 +1,112 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#ifndef OPENAGE_RENDERER_STATIC_SPRITES_H_
+#define OPENAGE_RENDERER_STATIC_SPRITES_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../crossplatform/opengl.h"
+#include "command_list.h"
+#include "sprite_batch.h"
+
+namespace openage {
+namespace renderer {
+
+/**
+ * sprites that rarely change, kept in their own gl vertex buffer.
+ *
+ * the vertices are built once and uploaded on the next draw,
+ * afterwards drawing them costs one draw call per gl state
+ * and no vertex traffic, until they are rebuilt.
+ *
+ * besides sprites, the buffer can hold blended terrain tiles,
+ * which are drawn below all sprites.
+ */
+class StaticSprites {
+public:
+	StaticSprites();
+	~StaticSprites();
+
+	StaticSprites(const StaticSprites &) = delete;
+	StaticSprites &operator =(const StaticSprites &) = delete;
+
+	/**
+	 * replace the contents with the given sprites.
+	 * sprites are drawn in order of their depth, with equal depths
+	 * grouped by gl state, so those must not overlap.
+	 * the depth of every sprite must be >= 0.
+	 */
+	void build(const std::vector<sprite_command> &sprites);
+
+	/**
+	 * replace the contents with terrain tiles and sprites on top of them.
+	 * the tiles may be drawn in any order.
+	 */
+	void build(const std::vector<terrain_quad> &tiles, const std::vector<sprite_command> &sprites);
+
+	/**
+	 * remove all sprites.
+	 */
+	void clear();
+
+	/**
+	 * the number of sprites and terrain tiles.
+	 */
+	size_t get_quad_count() const;
+
+	/**
+	 * the number of gl state runs, i.e. draw calls without splits.
+	 */
+	size_t get_run_count() const;
+
+	/**
+	 * incremented by every build or clear.
+	 */
+	uint32_t get_revision() const;
+
+	/**
+	 * the rectangle covered by all quads.
+	 * it is all zero without quads.
+	 */
+	void get_bounds(float *left, float *right, float *bottom, float *top) const;
+
+	/**
+	 * free the gl buffer while the context is still current.
+	 * it is recreated on the next draw.
+	 */
+	void release_gl();
+
+private:
+	friend class SpriteBatch;
+
+	/**
+	 * consecutive quads sharing the same gl state.
+	 */
+	struct run {
+		sprite_program program;
+		GLuint texture;
+		GLuint mask_texture;
+		size_t first;
+		size_t count;
+	};
+
+	std::vector<sprite_vertex> vertices;
+	std::vector<run> runs;
+
+	std::vector<terrain_vertex> terrain_vertices;
+	std::vector<run> terrain_runs;
+	uint32_t revision;
+
+	float left, right, bottom, top;
+
+	bool gl_ready;
+	bool upload_pending;
+	GLuint vertbuf;
+};
+
+} //namespace renderer
+} //namespace openage
+
+#endif
@@ -0,0 +1,743 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#include <SDL2/SDL.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "../crossplatform/opengl.h"
+#include "../log.h"
+#include "../shader/program.h"
+#include "../shader/shader.h"
+#include "../texture.h"
+#include "../util/error.h"
+#include "atlas_packer.h"
+#include "command_list.h"
+#include "gl_backend.h"
+#include "impostor.h"
+#include "null_backend.h"
+#include "sprite_batch.h"
+#include "static_sprites.h"
+#include "texture_cache.h"
+
+namespace openage {
+namespace renderer {
+namespace tests {
+
+namespace {
+
+constexpr int test_size = 64;
+
+const char *test_vert_code = R"(
+#version 120
+attribute vec4 vertex_position;
+attribute vec2 tex_coordinates;
+varying vec2 tex_position;
+void main(void) {
+	gl_Position = gl_ModelViewProjectionMatrix * vertex_position;
+	tex_position = tex_coordinates;
+}
+)";
+
+const char *test_frag_code = R"(
+#version 120
+uniform sampler2D texture;
+varying vec2 tex_position;
+void main(void) {
+	gl_FragColor = texture2D(texture, tex_position);
+}
+)";
+
+GLuint make_color_texture(uint8_t r, uint8_t g, uint8_t b) {
+	uint8_t pixel[4] {r, g, b, 255};
+	GLuint id;
+	glGenTextures(1, &id);
+	glBindTexture(GL_TEXTURE_2D, id);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	return id;
+}
+
+sprite_quad make_quad(GLuint texture, float x, float y, float size) {
+	sprite_quad q;
+	q.program = sprite_program::plain;
+	q.texture = texture;
+	q.mask_texture = 0;
+	q.left = x;
+	q.right = x + size;
+	q.bottom = y;
+	q.top = y + size;
+	q.txl = 0; q.txr = 1; q.txt = 0; q.txb = 1;
+	q.mtxl = q.mtxr = q.mtxt = q.mtxb = 0;
+	q.player = 0;
+	return q;
+}
+
+/**
+ * test whether the framebuffer pixel has the given color.
+ */
+bool pixel_is(int x, int y, uint8_t r, uint8_t g, uint8_t b) {
+	uint8_t pixel[4];
+	glReadPixels(x, y, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+	return pixel[0] == r and pixel[1] == g and pixel[2] == b;
+}
+
+/**
+ * the checks that need a gl context.
+ */
+int run_batch_checks() {
+	int stage = 0;
+
+	GLuint red = make_color_texture(255, 0, 0);
+	GLuint blue = make_color_texture(0, 0, 255);
+
+	{
+		SpriteBatch batch;
+
+		// one layer: sprites are grouped by texture,
+		// the left half red, the right half blue.
+		batch.begin_layer();
+		for (int i = 0; i < 64; i++) {
+			int cx = i % 8, cy = i / 8;
+			batch.add(make_quad(cx < 4 ? red : blue, cx * 8, cy * 8, 8), 0);
+		}
+		batch.flush();
+		const batch_stats &s = batch.get_stats();
+		if (s.sprites != 64 or s.draw_calls != 2 or
+		    s.program_changes != 1 or s.texture_changes != 2) { goto out; }
+		if (not pixel_is(4, 4, 255, 0, 0) or not pixel_is(60, 60, 0, 0, 255)) { goto out; }
+		stage += 1;
+
+		// ordered sprites keep their order,
+		// even if that needs more draw calls.
+		batch.reset_stats();
+		batch.add(make_quad(blue, 0, 0, test_size));
+		batch.add(make_quad(red, 0, 0, test_size));
+		batch.add(make_quad(blue, 0, 0, test_size));
+		batch.add(make_quad(red, 0, 0, test_size));
+		batch.flush();
+		if (batch.get_stats().draw_calls != 4) { goto out; }
+		if (not pixel_is(32, 32, 255, 0, 0)) { goto out; }
+		stage += 1;
+
+		// successive layers with the same state are merged.
+		batch.reset_stats();
+		for (int i = 0; i < 10; i++) {
+			batch.add(make_quad(blue, 0, 0, test_size));
+		}
+		batch.flush();
+		if (batch.get_stats().draw_calls != 1 or batch.pending() != 0) { goto out; }
+		if (not pixel_is(32, 32, 0, 0, 255)) { goto out; }
+		stage += 1;
+	}
+
+	{
+		// runs larger than the ring are split,
+		// the ring is orphaned when it wraps.
+		SpriteBatch batch{16};
+		batch.begin_layer();
+		for (int i = 0; i < 40; i++) {
+			batch.add(make_quad(red, 0, 0, test_size), 0);
+		}
+		batch.flush();
+		batch.add(make_quad(red, 0, 0, test_size));
+		batch.flush();
+		const batch_stats &s = batch.get_stats();
+		if (s.draw_calls != 4 or s.buffer_orphans != 2 or s.flushes != 2) { goto out; }
+		if (not pixel_is(32, 32, 255, 0, 0)) { goto out; }
+		stage += 1;
+	}
+
+	{
+		// static sprites are uploaded once, then drawn
+		// with one call per texture until they are rebuilt.
+		std::vector<sprite_command> sprites;
+		for (int i = 0; i < 64; i++) {
+			int cx = i % 8, cy = i / 8;
+			sprites.push_back({make_quad(cx < 4 ? blue : red, cx * 8, cy * 8, 8), 0});
+		}
+		StaticSprites chunk;
+		chunk.build(sprites);
+
+		SpriteBatch batch;
+		batch.draw_static(&chunk);
+		batch.draw_static(&chunk);
+		const batch_stats &s = batch.get_stats();
+		if (s.sprites != 128 or s.draw_calls != 4 or s.static_uploads != 1) { goto out; }
+		if (not pixel_is(4, 4, 0, 0, 255) or not pixel_is(60, 60, 255, 0, 0)) { goto out; }
+		stage += 1;
+	}
+
+	if (Impostor::is_supported()) {
+		// an impostor shows the buffer as one quad,
+		// and is only rendered again when the buffer changes.
+		std::vector<sprite_command> sprites;
+		for (int i = 0; i < 64; i++) {
+			int cx = i % 8, cy = i / 8;
+			sprites.push_back({make_quad(cy < 4 ? blue : red, cx * 8, cy * 8, 8), 0});
+		}
+		StaticSprites chunk;
+		chunk.build(sprites);
+
+		Impostor impostor;
+		CommandList commands;
+		commands.impostor(&impostor, &chunk, 0, 0);
+
+		GLBackend backend;
+		for (int frame = 0; frame < 3; frame++) {
+			if (frame == 2) {
+				chunk.build(sprites);
+			}
+			glClear(GL_COLOR_BUFFER_BIT);
+			backend.begin_frame();
+			backend.execute(commands);
+			if (not pixel_is(4, 4, 0, 0, 255) or not pixel_is(60, 60, 255, 0, 0)) { goto out; }
+		}
+		if (backend.get_stats().impostor_renders != 2 or backend.get_stats().draw_calls != 7) { goto out; }
+		backend.release_gl();
+		stage += 1;
+	}
+
+	if (glGetError() != GL_NO_ERROR) { goto out; }
+	stage = -1;
+
+out:
+	glDeleteTextures(1, &red);
+	glDeleteTextures(1, &blue);
+	return stage;
+}
+
+/**
+ * record a frame like the game does: terrain tiles with blending
+ * layers, units, the debug grid and some text.
+ */
+void record_frame(CommandList &commands, int tiles, int units, int frame) {
+	for (int i = 0; i < tiles; i++) {
+		float x = (i % 40) * 48, y = (i / 40) * 24;
+		commands.sprite(make_quad(1 + i % 4, x, y, 97));
+		if (i % 3 == 0) {
+			sprite_quad blend = make_quad(1 + (i + 1) % 4, x, y, 97);
+			blend.program = sprite_program::alphamask;
+			blend.mask_texture = 10 + i % 8;
+			commands.sprite(blend);
+		}
+	}
+
+	for (int i = 0; i < units; i++) {
+		sprite_quad unit = make_quad(20 + i % 16, (i * 37 + frame) % 1900, (i * 53) % 1000, 64);
+		unit.program = sprite_program::teamcolor;
+		unit.player = 1 + i % 8;
+		commands.sprite(unit);
+	}
+
+	commands.set_color(0, 0, 0);
+	commands.begin_lines(1);
+	for (int i = 0; i < 40; i++) {
+		commands.vertex(i * 96, 0);
+		commands.vertex(i * 96 + 1000, 500);
+	}
+
+	commands.set_color(1, 1, 1);
+	commands.text(nullptr, 5, 35, "openage benchmark");
+	commands.text(nullptr, 5, 15, "frame preparation");
+}
+
+/**
+ * create the tile layers of a terrain chunk with 16x16 tiles,
+ * like the terrain does. the textures depend on the revision.
+ */
+void make_chunk_sprites(int chunk, int revision, std::vector<sprite_command> *sprites) {
+	sprites->clear();
+	for (int i = 0; i < 16 * 16; i++) {
+		float x = (chunk % 4) * 768 + (i % 16) * 48;
+		float y = (chunk / 4) * 384 + (i / 16) * 24;
+		sprites->push_back({make_quad(1 + (i + revision) % 4, x, y, 97), 0});
+		if ((i + revision) % 3 == 0) {
+			sprite_quad blend = make_quad(1 + (i + 1) % 4, x, y, 97);
+			blend.program = sprite_program::alphamask;
+			blend.mask_texture = 10 + i % 8;
+			sprites->push_back({blend, 1});
+		}
+	}
+}
+
+/**
+ * print mean, median, p99 and maximum of the frame times.
+ */
+void print_frame_times(const char *name, std::vector<double> *times) {
+	if (times->empty()) {
+		return;
+	}
+
+	std::sort(std::begin(*times), std::end(*times));
+	double sum = 0;
+	for (double t : *times) {
+		sum += t;
+	}
+
+	printf("%s per frame: mean %.1f us, median %.1f us, p99 %.1f us, max %.1f us\n",
+	       name,
+	       sum / times->size(),
+	       (*times)[times->size() / 2],
+	       (*times)[times->size() * 99 / 100],
+	       times->back());
+}
+
+} //anonymous namespace
+
+/**
+ * packs rectangles of random sizes until the atlas is full.
+ */
+void atlas_packer() {
+	int stage = 0;
+
+	struct rect {
+		int x, y, w, h;
+	};
+	std::vector<rect> placed;
+
+	AtlasPacker packer{1024, 512};
+	int x, y;
+
+	if (packer.pack(1025, 1, &x, &y) or packer.pack(1, 513, &x, &y)) { goto out; }
+	if (packer.occupancy() != 0) { goto out; }
+	stage += 1;
+
+	{
+		// deterministic sizes from a linear congruential generator
+		uint32_t state = 1337;
+		int failures = 0;
+		while (failures < 20) {
+			state = state * 1103515245 + 12345;
+			int w = 4 + (state >> 16) % 120;
+			state = state * 1103515245 + 12345;
+			int h = 4 + (state >> 16) % 120;
+
+			if (packer.pack(w, h, &x, &y)) {
+				placed.push_back({x, y, w, h});
+			} else {
+				failures += 1;
+			}
+		}
+	}
+	if (placed.size() < 50) { goto out; }
+	stage += 1;
+
+	for (size_t i = 0; i < placed.size(); i++) {
+		const rect &a = placed[i];
+		if (a.x < 0 or a.y < 0 or a.x + a.w > 1024 or a.y + a.h > 512) { goto out; }
+		for (size_t j = i + 1; j < placed.size(); j++) {
+			const rect &b = placed[j];
+			if (a.x < b.x + b.w and b.x < a.x + a.w and
+			    a.y < b.y + b.h and b.y < a.y + a.h) { goto out; }
+		}
+	}
+	stage += 1;
+
+	// the skyline wastes some space, but not too much
+	if (packer.occupancy() < 0.7) { goto out; }
+
+	return;
+
+out:
+	log::err("atlas packer test failed at stage %d", stage);
+	throw "atlas packer test failed";
+}
+
+/**
+ * writes a texture cache and maps it again.
+ */
+void texture_cache() {
+	int stage = 0;
+
+	char image_template[] = "/tmp/openage_texture_cache_XXXXXX";
+	int image_fd = mkstemp(image_template);
+	if (image_fd < 0) {
+		throw "texture cache test can't create a file";
+	}
+	close(image_fd);
+
+	std::string image_filename{image_template};
+	std::string cache_filename = texture_cache_filename(image_filename);
+
+	// rgb rows padded to 4 bytes, like sdl does
+	std::vector<uint8_t> pixels(12 * 2);
+	for (size_t i = 0; i < pixels.size(); i++) {
+		pixels[i] = i * 7;
+	}
+
+	texture_data data;
+	data.w = 3;
+	data.h = 2;
+	data.bytes_per_pixel = 3;
+	data.pitch = 12;
+	data.pixels = pixels.data();
+	data.has_metafile = true;
+	data.subtextures.push_back({0, 0, 2, 2, 1, 1});
+	data.subtextures.push_back({2, 0, 1, 2, 0, -1});
+
+	texture_data loaded;
+	FILE *image;
+	struct timespec times[2];
+
+	// the image file itself is only checked for changes
+	if (not store_texture_cache(image_filename, image_filename, data)) { goto out; }
+	stage += 1;
+
+	if (not load_texture_cache(image_filename, image_filename, &loaded)) { goto out; }
+	stage += 1;
+
+	if (loaded.w != 3 or loaded.h != 2 or loaded.bytes_per_pixel != 3 or
+	    loaded.pitch != 12 or not loaded.has_metafile or loaded.mapping == nullptr) { goto out; }
+	if (memcmp(loaded.pixels, pixels.data(), pixels.size()) != 0) { goto out; }
+	if (loaded.subtextures.size() != 2 or
+	    loaded.subtextures[1].x != 2 or loaded.subtextures[1].cy != -1) { goto out; }
+	stage += 1;
+
+	// without the meta file, the cache doesn't match
+	if (load_texture_cache(image_filename, "", &loaded)) { goto out; }
+	stage += 1;
+
+	// neither when the image changed
+	image = fopen(image_filename.c_str(), "ab");
+	fputc(0, image);
+	fclose(image);
+	if (load_texture_cache(image_filename, image_filename, &loaded)) { goto out; }
+	stage += 1;
+
+	// nor when it was modified again within the same second
+	times[0].tv_sec = times[1].tv_sec = 1000000000;
+	times[0].tv_nsec = times[1].tv_nsec = 1000;
+	if (utimensat(AT_FDCWD, image_filename.c_str(), times, 0) != 0) { goto out; }
+	if (not store_texture_cache(image_filename, image_filename, data)) { goto out; }
+	if (not load_texture_cache(image_filename, image_filename, &loaded)) { goto out; }
+	times[0].tv_nsec = times[1].tv_nsec = 2000;
+	if (utimensat(AT_FDCWD, image_filename.c_str(), times, 0) != 0) { goto out; }
+	if (load_texture_cache(image_filename, image_filename, &loaded)) { goto out; }
+
+	remove(image_filename.c_str());
+	remove(cache_filename.c_str());
+	return;
+
+out:
+	remove(image_filename.c_str());
+	remove(cache_filename.c_str());
+	log::err("texture cache test failed at stage %d", stage);
+	throw "texture cache test failed";
+}
+
+/**
+ * records commands and checks what the null backend sees.
+ */
+void command_list() {
+	int stage = 0;
+	CommandList commands;
+	NullBackend backend;
+
+	// consecutive sprites share one command,
+	// other commands split them.
+	commands.sprite(make_quad(1, 0, 0, 8));
+	commands.set_color(1, 0, 0);
+	commands.begin_lines(2);
+	commands.vertex(0, 0);
+	commands.vertex(10, 10);
+	commands.sprite(make_quad(1, 0, 0, 8));
+	commands.sprite(make_quad(2, 8, 0, 8));
+	commands.sprite(make_quad(1, 0, 8, 8));
+	commands.begin_quads();
+	for (int i = 0; i < 4; i++) {
+		commands.vertex(i, i);
+	}
+	commands.text(nullptr, 1, 2, "hello", 4);
+
+	backend.execute(commands);
+	{
+		const command_stats &s = backend.get_stats();
+		const std::vector<command> &c = commands.get_commands();
+		if (s.commands != 5 or c.size() != 5) { goto out; }
+		if (s.sprites != 4 or s.vertices != 6) { goto out; }
+		if (s.texts != 1 or s.chars != 4) { goto out; }
+		if (c[2].type != command_type::sprites or c[2].count != 3) { goto out; }
+		if (c[1].col.r != 1 or c[1].col.g != 0 or c[1].line_width != 2) { goto out; }
+		if (std::string{&commands.get_chars()[c[4].first]} != "hell") { goto out; }
+	}
+	stage += 1;
+
+	// vertices need a lines or quads command
+	try {
+		commands.text(nullptr, 0, 0, "x");
+		commands.vertex(0, 0);
+		goto out;
+	}
+	catch (util::Error &) {}
+	stage += 1;
+
+	// equal frames have equal digests,
+	// recording again reuses the storage.
+	{
+		commands.clear();
+		if (not commands.empty()) { goto out; }
+
+		record_frame(commands, 400, 100, 0);
+		backend.reset();
+		backend.execute(commands);
+		uint64_t first = backend.get_digest();
+		const sprite_quad *storage = commands.get_sprites().data();
+
+		commands.clear();
+		record_frame(commands, 400, 100, 0);
+		backend.reset();
+		backend.execute(commands);
+		if (backend.get_digest() != first) { goto out; }
+		if (commands.get_sprites().data() != storage) { goto out; }
+		stage += 1;
+
+		commands.clear();
+		record_frame(commands, 400, 100, 1);
+		backend.reset();
+		backend.execute(commands);
+		if (backend.get_digest() == first) { goto out; }
+		if (backend.get_stats().sprites != 400 + 134 + 100) { goto out; }
+		stage += 1;
+	}
+
+	{
+		// prebuilt sprites are sorted into runs by depth and state,
+		// rebuilding them changes the digest.
+		std::vector<sprite_command> sprites;
+		make_chunk_sprites(0, 0, &sprites);
+		StaticSprites chunk;
+		chunk.build(sprites);
+		if (chunk.get_quad_count() != sprites.size()) { goto out; }
+		if (chunk.get_run_count() != 4 + 8) { goto out; }
+
+		CommandList commands;
+		NullBackend backend;
+		commands.static_sprites(&chunk, 10, 20);
+		backend.execute(commands);
+		uint64_t first = backend.get_digest();
+		const command_stats &s = backend.get_stats();
+		if (s.static_buffers != 1 or s.static_sprites != sprites.size()) { goto out; }
+		stage += 1;
+
+		chunk.build(sprites);
+		backend.reset();
+		backend.execute(commands);
+		if (backend.get_digest() == first) { goto out; }
+		stage += 1;
+
+		chunk.clear();
+		if (chunk.get_quad_count() != 0 or chunk.get_run_count() != 0) { goto out; }
+	}
+
+	return;
+
+out:
+	log::err("command list test failed at stage %d", stage);
+	throw "command list test failed";
+}
+
+/**
+ * records and replays synthetic frames with the null backend
+ * and prints the time per frame.
+ *
+ * arguments: [frames] [tiles] [units]
+ */
+void command_list_benchmark(int argc, char **argv) {
+	int frames = (argc > 1) ? atoi(argv[1]) : 1000;
+	int tiles  = (argc > 2) ? atoi(argv[2]) : 1600;
+	int units  = (argc > 3) ? atoi(argv[3]) : 500;
+
+	CommandList commands;
+	NullBackend backend;
+	std::vector<double> times;
+	times.reserve(frames);
+
+	for (int i = 0; i < frames; i++) {
+		auto start = std::chrono::steady_clock::now();
+		record_frame(commands, tiles, units, i);
+		backend.execute(commands);
+		commands.clear();
+		auto end = std::chrono::steady_clock::now();
+		times.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+	}
+
+	if (frames <= 0) {
+		return;
+	}
+
+	const command_stats &s = backend.get_stats();
+	printf("%d frames, %zu sprites and %zu commands per frame\n",
+	       frames, s.sprites / frames, s.commands / frames);
+	print_frame_times("recording", &times);
+	printf("digest %016llx\n", (unsigned long long) backend.get_digest());
+}
+
+/**
+ * compares recording all terrain tiles every frame with drawing
+ * prebuilt chunk buffers that are only rebuilt when a chunk changes.
+ * both are replayed with the null backend.
+ *
+ * arguments: [frames] [chunks] [frames between chunk changes, 0 for never]
+ */
+void terrain_chunk_benchmark(int argc, char **argv) {
+	int frames   = (argc > 1) ? atoi(argv[1]) : 1000;
+	int chunks   = (argc > 2) ? atoi(argv[2]) : 16;
+	int interval = (argc > 3) ? atoi(argv[3]) : 60;
+
+	if (frames <= 0 or chunks <= 0) {
+		return;
+	}
+
+	CommandList commands;
+	NullBackend backend;
+	std::vector<sprite_command> sprites;
+	std::vector<int> revisions(chunks, 0);
+	std::vector<double> times;
+	times.reserve(frames);
+
+	// every interval frames, the next chunk changes
+	auto change_chunks = [&](int frame) {
+		if (interval > 0 and frame % interval == interval - 1) {
+			revisions[(frame / interval) % chunks] += 1;
+		}
+	};
+
+	// the tiles of all chunks are recreated every frame
+	for (int i = 0; i < frames; i++) {
+		auto start = std::chrono::steady_clock::now();
+		for (int c = 0; c < chunks; c++) {
+			make_chunk_sprites(c, revisions[c], &sprites);
+			for (auto &s : sprites) {
+				commands.sprite(s.quad);
+			}
+		}
+		backend.execute(commands);
+		commands.clear();
+		auto end = std::chrono::steady_clock::now();
+		times.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+		change_chunks(i);
+	}
+
+	const command_stats &s = backend.get_stats();
+	printf("%d frames, %d chunks, %zu tile sprites per frame\n",
+	       frames, chunks, s.sprites / frames);
+	print_frame_times("tile sprites", &times);
+
+	// chunk buffers are rebuilt when their revision changed
+	std::fill(std::begin(revisions), std::end(revisions), 0);
+	std::vector<StaticSprites> buffers(chunks);
+	std::vector<int> built(chunks, -1);
+	size_t rebuilds = 0;
+	backend.reset();
+	times.clear();
+
+	for (int i = 0; i < frames; i++) {
+		auto start = std::chrono::steady_clock::now();
+		for (int c = 0; c < chunks; c++) {
+			if (built[c] != revisions[c]) {
+				make_chunk_sprites(c, revisions[c], &sprites);
+				buffers[c].build(sprites);
+				built[c] = revisions[c];
+				rebuilds += 1;
+			}
+			commands.static_sprites(&buffers[c], 0, 0);
+		}
+		backend.execute(commands);
+		commands.clear();
+		auto end = std::chrono::steady_clock::now();
+		times.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+		change_chunks(i);
+	}
+
+	printf("%zu chunk rebuilds, %zu commands per frame\n",
+	       rebuilds, backend.get_stats().commands / frames);
+	print_frame_times("chunk buffers", &times);
+}
+
+/**
+ * draws sprites with a batch and checks the draw call counters
+ * and the resulting pixels.
+ *
+ * this needs a gl context. when none can be created, the test is skipped.
+ * for headless runs, use a software renderer like mesa's llvmpipe,
+ * e.g. with SDL_VIDEODRIVER=offscreen LIBGL_ALWAYS_SOFTWARE=1.
+ */
+void sprite_batch() {
+	if (SDL_InitSubSystem(SDL_INIT_VIDEO) != 0) {
+		log::msg("skipping sprite batch test, no video: %s", SDL_GetError());
+		return;
+	}
+
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 2);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 1);
+
+	SDL_Window *window = SDL_CreateWindow(
+		"openage sprite batch test",
+		SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
+		test_size, test_size,
+		SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN
+	);
+	SDL_GLContext context = nullptr;
+	if (window != nullptr) {
+		context = SDL_GL_CreateContext(window);
+	}
+	if (context == nullptr or glewInit() != GLEW_OK) {
+		log::msg("skipping sprite batch test, no gl context: %s", SDL_GetError());
+		if (context != nullptr) {
+			SDL_GL_DeleteContext(context);
+		}
+		if (window != nullptr) {
+			SDL_DestroyWindow(window);
+		}
+		SDL_QuitSubSystem(SDL_INIT_VIDEO);
+		return;
+	}
+
+	glViewport(0, 0, test_size, test_size);
+	glMatrixMode(GL_PROJECTION);
+	glLoadIdentity();
+	glOrtho(0, test_size, 0, test_size, -1, 1);
+	glMatrixMode(GL_MODELVIEW);
+	glLoadIdentity();
+	glDisable(GL_BLEND);
+	glClearColor(0, 0, 0, 1);
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	// the batch draws with the global texture shader
+	auto vert = new shader::Shader(GL_VERTEX_SHADER, test_vert_code);
+	auto frag = new shader::Shader(GL_FRAGMENT_SHADER, test_frag_code);
+	texture_shader::program = new shader::Program(vert, frag);
+	texture_shader::program->link();
+	texture_shader::tex_coord = texture_shader::program->get_attribute_id("tex_coordinates");
+	delete vert;
+	delete frag;
+
+	int stage = run_batch_checks();
+
+	delete texture_shader::program;
+	texture_shader::program = nullptr;
+
+	SDL_GL_DeleteContext(context);
+	SDL_DestroyWindow(window);
+	SDL_QuitSubSystem(SDL_INIT_VIDEO);
+
+	if (stage >= 0) {
+		log::err("sprite batch test failed at stage %d", stage);
+		throw "failed sprite batch test";
+	}
+}
+
+} //namespace tests
+} //namespace renderer
+} //namespace openage
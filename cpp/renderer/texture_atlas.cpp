@@ -0,0 +1,154 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#include "texture_atlas.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+#include "../log.h"
+#include "../util/error.h"
+
+namespace openage {
+namespace renderer {
+
+TextureAtlas::TextureAtlas(int page_size, int padding)
+	:
+	page_size{page_size},
+	padding{padding},
+	image_count{0} {}
+
+TextureAtlas::~TextureAtlas() {
+	for (auto &p : this->pages) {
+		glDeleteTextures(1, &p.texture);
+	}
+}
+
+bool TextureAtlas::place(int w, int h, int bytes_per_pixel, int pitch, const void *pixels, atlas_slot *slot) {
+	if (bytes_per_pixel != 3 and bytes_per_pixel != 4) {
+		throw util::Error{"texture atlas can't store %d bytes per pixel", bytes_per_pixel};
+	}
+
+	if (this->pages.empty()) {
+		GLint max_size;
+		glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+		this->page_size = std::min<int>(this->page_size, max_size);
+	}
+
+	int padded_w = w + 2 * this->padding;
+	int padded_h = h + 2 * this->padding;
+	if (padded_w > this->page_size or padded_h > this->page_size) {
+		return false;
+	}
+
+	// reuse a released slot, the latest one is likely the same image reloaded
+	for (auto it = this->free_slots.rbegin(); it != this->free_slots.rend(); ++it) {
+		if (it->w == w and it->h == h) {
+			*slot = *it;
+			this->free_slots.erase(std::next(it).base());
+			this->upload(slot->texture, slot->x - this->padding, slot->y - this->padding,
+			             w, h, bytes_per_pixel, pitch, pixels);
+			this->image_count += 1;
+			return true;
+		}
+	}
+
+	// first fit: earlier pages get filled up with small images
+	int x, y;
+	size_t index = 0;
+	for (; index < this->pages.size(); index++) {
+		if (this->pages[index].packer.pack(padded_w, padded_h, &x, &y)) {
+			break;
+		}
+	}
+	if (index == this->pages.size()) {
+		this->create_page();
+		if (not this->pages.back().packer.pack(padded_w, padded_h, &x, &y)) {
+			throw util::Error{"image of %dx%d doesn't fit an empty atlas page", w, h};
+		}
+	}
+
+	page &p = this->pages[index];
+	slot->texture = p.texture;
+	slot->page_width = this->page_size;
+	slot->page_height = this->page_size;
+	slot->x = x + this->padding;
+	slot->y = y + this->padding;
+	slot->w = w;
+	slot->h = h;
+
+	this->upload(p.texture, x, y, w, h, bytes_per_pixel, pitch, pixels);
+	this->image_count += 1;
+	return true;
+}
+
+void TextureAtlas::release(const atlas_slot &slot) {
+	this->free_slots.push_back(slot);
+	this->image_count -= 1;
+}
+
+void TextureAtlas::create_page() {
+	GLuint texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+
+	// the space between the images is never sampled,
+	// so the page can start with undefined contents.
+	glTexImage2D(
+		GL_TEXTURE_2D, 0,
+		GL_RGBA8, this->page_size, this->page_size, 0,
+		GL_RGBA, GL_UNSIGNED_BYTE, nullptr
+	);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	this->pages.push_back({texture, AtlasPacker{this->page_size, this->page_size}});
+
+	if (this->pages.size() > 1) {
+		log::msg("texture atlas page %zu created, the last one is %.0f%% used",
+		         this->pages.size(), 100 * this->pages[this->pages.size() - 2].packer.occupancy());
+	}
+}
+
+void TextureAtlas::upload(GLuint texture, int x, int y, int w, int h, int bytes_per_pixel, int pitch, const void *pixels) {
+	int padded_w = w + 2 * this->padding;
+	int padded_h = h + 2 * this->padding;
+
+	this->upload_buffer.assign((size_t) padded_w * padded_h * 4, 0);
+
+	const uint8_t *src = reinterpret_cast<const uint8_t *>(pixels);
+	for (int row = 0; row < h; row++) {
+		const uint8_t *in = src + (size_t) row * pitch;
+		uint8_t *out = &this->upload_buffer[(((size_t) row + this->padding) * padded_w + this->padding) * 4];
+
+		if (bytes_per_pixel == 4) {
+			memcpy(out, in, (size_t) w * 4);
+		} else {
+			for (int col = 0; col < w; col++) {
+				out[col * 4 + 0] = in[col * 3 + 0];
+				out[col * 4 + 1] = in[col * 3 + 1];
+				out[col * 4 + 2] = in[col * 3 + 2];
+				out[col * 4 + 3] = 255;
+			}
+		}
+	}
+
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexSubImage2D(
+		GL_TEXTURE_2D, 0,
+		x, y, padded_w, padded_h,
+		GL_RGBA, GL_UNSIGNED_BYTE, this->upload_buffer.data()
+	);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+size_t TextureAtlas::get_page_count() const {
+	return this->pages.size();
+}
+
+size_t TextureAtlas::get_image_count() const {
+	return this->image_count;
+}
+
+} //namespace renderer
+} //namespace openage
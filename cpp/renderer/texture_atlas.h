@@ -0,0 +1,103 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#ifndef OPENAGE_RENDERER_TEXTURE_ATLAS_H_
+#define OPENAGE_RENDERER_TEXTURE_ATLAS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../crossplatform/opengl.h"
+#include "atlas_packer.h"
+
+namespace openage {
+namespace renderer {
+
+/**
+ * where an image was placed in a texture atlas.
+ */
+struct atlas_slot {
+	/** the gl texture of the atlas page */
+	GLuint texture;
+	int page_width, page_height;
+
+	/** position and size of the image on the page */
+	int x, y, w, h;
+};
+
+/**
+ * packs many images into a few large gl textures ("pages"),
+ * so sprites from different image files can be drawn
+ * with the same texture bound.
+ *
+ * each image gets a transparent border, so linear filtering
+ * doesn't bleed in pixels of its neighbors.
+ *
+ * released slots are kept in a free list and handed to the next
+ * image of the same size, e.g. a reloaded texture. their area is
+ * not merged or split, so pages are never freed again.
+ */
+class TextureAtlas {
+public:
+	/**
+	 * page_size is limited to the maximum gl texture size
+	 * when the first page is created.
+	 */
+	TextureAtlas(int page_size=4096, int padding=1);
+	~TextureAtlas();
+
+	TextureAtlas(const TextureAtlas &) = delete;
+	TextureAtlas &operator =(const TextureAtlas &) = delete;
+
+	/**
+	 * upload an image to a free place in the atlas.
+	 * the image has 3 (rgb) or 4 (rgba) bytes per pixel,
+	 * and its rows are pitch bytes apart.
+	 * a released slot of the same size is preferred.
+	 *
+	 * @returns false if the image is too large for a page.
+	 */
+	bool place(int w, int h, int bytes_per_pixel, int pitch, const void *pixels, atlas_slot *slot);
+
+	/**
+	 * the image in the slot is no longer used,
+	 * the slot can be given to an image of the same size.
+	 */
+	void release(const atlas_slot &slot);
+
+	size_t get_page_count() const;
+
+	/**
+	 * the number of images currently placed.
+	 */
+	size_t get_image_count() const;
+
+private:
+	struct page {
+		GLuint texture;
+		AtlasPacker packer;
+	};
+
+	void create_page();
+
+	/**
+	 * upload the image with a transparent border around it.
+	 */
+	void upload(GLuint texture, int x, int y, int w, int h, int bytes_per_pixel, int pitch, const void *pixels);
+
+	int page_size;
+	int padding;
+	size_t image_count;
+	std::vector<page> pages;
+
+	/** released slots, the most recently released one last */
+	std::vector<atlas_slot> free_slots;
+
+	/** staging memory for the padded rgba image */
+	std::vector<uint8_t> upload_buffer;
+};
+
+} //namespace renderer
+} //namespace openage
+
+#endif
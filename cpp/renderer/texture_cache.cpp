@@ -0,0 +1,193 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#include "texture_cache.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+#include "../crossplatform/os.h"
+#include "../log.h"
+#include "../texture.h"
+#include "../util/error.h"
+#include "../util/mapped_file.h"
+
+namespace openage {
+namespace renderer {
+
+namespace {
+
+constexpr char cache_magic[4] {'O', 'A', 'T', 'C'};
+constexpr uint32_t cache_version = 2;
+
+/** values per subtexture entry */
+constexpr size_t subtexture_fields = 6;
+
+/** the pixels start at a multiple of this */
+constexpr size_t pixel_alignment = 16;
+
+/**
+ * get size and modification time of a file, in nanoseconds,
+ * so changes within the same second are noticed.
+ * a missing file has both zero.
+ */
+void file_stamp(const std::string &filename, uint64_t *size, uint64_t *mtime) {
+	struct stat st;
+	if (filename.empty() or stat(filename.c_str(), &st) < 0) {
+		*size = 0;
+		*mtime = 0;
+	}
+	else {
+		*size = st.st_size;
+		*mtime = os::mtime_nsec(st);
+	}
+}
+
+/**
+ * byte offset of the pixels in the cache file.
+ */
+size_t pixel_offset(size_t subtexture_count) {
+	size_t table_end = sizeof(texture_cache_header) + subtexture_count * subtexture_fields * sizeof(int32_t);
+	return (table_end + pixel_alignment - 1) / pixel_alignment * pixel_alignment;
+}
+
+} //anonymous namespace
+
+std::string texture_cache_filename(const std::string &image_filename) {
+	return image_filename + ".texcache";
+}
+
+bool load_texture_cache(const std::string &image_filename, const std::string &meta_filename, texture_data *data) {
+	std::string cache_filename = texture_cache_filename(image_filename);
+	if (util::file_size(cache_filename) < (ssize_t) sizeof(texture_cache_header)) {
+		return false;
+	}
+
+	std::unique_ptr<util::MappedFile> mapping;
+	try {
+		mapping.reset(new util::MappedFile{cache_filename});
+	}
+	catch (util::Error &e) {
+		log::dbg("can't use texture cache: %s", e.str());
+		return false;
+	}
+
+	const uint8_t *file = reinterpret_cast<const uint8_t *>(mapping->data());
+	texture_cache_header header;
+	memcpy(&header, file, sizeof(header));
+
+	texture_cache_header expected;
+	file_stamp(image_filename, &expected.image_size, &expected.image_mtime);
+	file_stamp(meta_filename, &expected.meta_size, &expected.meta_mtime);
+
+	if (memcmp(header.magic, cache_magic, sizeof(cache_magic)) != 0 or
+	    header.version != cache_version or
+	    header.image_size != expected.image_size or
+	    header.image_mtime != expected.image_mtime or
+	    header.meta_size != expected.meta_size or
+	    header.meta_mtime != expected.meta_mtime or
+	    header.has_metafile != (meta_filename.empty() ? 0 : 1)) {
+		log::dbg1("texture cache of %s is outdated", image_filename.c_str());
+		return false;
+	}
+
+	if ((header.bytes_per_pixel != 3 and header.bytes_per_pixel != 4) or
+	    header.w < 0 or header.h < 0 or header.pitch < header.w * header.bytes_per_pixel) {
+		log::err("texture cache of %s is corrupt", image_filename.c_str());
+		return false;
+	}
+
+	size_t offset = pixel_offset(header.subtexture_count);
+	if (mapping->size() < offset + (size_t) header.pitch * header.h) {
+		log::err("texture cache of %s is truncated", image_filename.c_str());
+		return false;
+	}
+
+	data->subtextures.resize(header.subtexture_count);
+	const uint8_t *table = file + sizeof(header);
+	for (auto &s : data->subtextures) {
+		int32_t fields[subtexture_fields];
+		memcpy(fields, table, sizeof(fields));
+		table += sizeof(fields);
+
+		s.x  = fields[0];
+		s.y  = fields[1];
+		s.w  = fields[2];
+		s.h  = fields[3];
+		s.cx = fields[4];
+		s.cy = fields[5];
+	}
+
+	data->w = header.w;
+	data->h = header.h;
+	data->bytes_per_pixel = header.bytes_per_pixel;
+	data->pitch = header.pitch;
+	data->pixels = file + offset;
+	data->has_metafile = header.has_metafile;
+	data->mapping = std::move(mapping);
+	return true;
+}
+
+bool store_texture_cache(const std::string &image_filename, const std::string &meta_filename, const texture_data &data) {
+	texture_cache_header header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, cache_magic, sizeof(cache_magic));
+	header.version = cache_version;
+	file_stamp(image_filename, &header.image_size, &header.image_mtime);
+	file_stamp(meta_filename, &header.meta_size, &header.meta_mtime);
+	header.w = data.w;
+	header.h = data.h;
+	header.bytes_per_pixel = data.bytes_per_pixel;
+	header.pitch = data.pitch;
+	header.has_metafile = data.has_metafile;
+	header.subtexture_count = data.subtextures.size();
+
+	std::vector<uint8_t> table(pixel_offset(header.subtexture_count) - sizeof(header), 0);
+	uint8_t *entry = table.data();
+	for (auto &s : data.subtextures) {
+		int32_t fields[subtexture_fields] {s.x, s.y, s.w, s.h, s.cx, s.cy};
+		memcpy(entry, fields, sizeof(fields));
+		entry += sizeof(fields);
+	}
+
+	// write to a temporary file, so readers never see half a cache.
+	// each writer gets its own, textures are decoded by several jobs.
+	std::string cache_filename = texture_cache_filename(image_filename);
+	std::string temp_filename = cache_filename + ".XXXXXX";
+
+	int fd = mkstemp(&temp_filename[0]);
+	if (fd < 0) {
+		log::dbg("can't write texture cache %s", cache_filename.c_str());
+		return false;
+	}
+
+	// mkstemp only allows the owner to read
+	fchmod(fd, 0644);
+
+	FILE *file = fdopen(fd, "wb");
+	if (file == nullptr) {
+		log::dbg("can't write texture cache %s", cache_filename.c_str());
+		close(fd);
+		remove(temp_filename.c_str());
+		return false;
+	}
+
+	size_t pixel_bytes = (size_t) data.pitch * data.h;
+	bool ok = (fwrite(&header, sizeof(header), 1, file) == 1 and
+	           fwrite(table.data(), 1, table.size(), file) == table.size() and
+	           fwrite(data.pixels, 1, pixel_bytes, file) == pixel_bytes);
+
+	if (fclose(file) != 0 or not ok or rename(temp_filename.c_str(), cache_filename.c_str()) != 0) {
+		log::err("failed writing texture cache %s", cache_filename.c_str());
+		remove(temp_filename.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+} //namespace renderer
+} //namespace openage
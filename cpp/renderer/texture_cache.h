@@ -0,0 +1,67 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#ifndef OPENAGE_RENDERER_TEXTURE_CACHE_H_
+#define OPENAGE_RENDERER_TEXTURE_CACHE_H_
+
+#include <cstdint>
+#include <string>
+
+namespace openage {
+
+struct texture_data;
+
+namespace renderer {
+
+/**
+ * the texture cache stores decoded images and their subtexture tables
+ * in a binary file next to the image, so the next start maps the pixels
+ * instead of decoding the png and parsing the meta file.
+ *
+ * file layout, all values in native byte order:
+ *   texture_cache_header
+ *   subtexture_count * 6 int32: x, y, w, h, cx, cy
+ *   padding to 16 bytes
+ *   h rows of pitch bytes
+ *
+ * the header records size and modification time (in nanoseconds) of the
+ * image and meta file, a cache that doesn't match them is ignored and rewritten.
+ */
+struct texture_cache_header {
+	char magic[4];
+	uint32_t version;
+
+	uint64_t image_size, image_mtime;
+	uint64_t meta_size, meta_mtime;
+
+	int32_t w, h;
+	int32_t bytes_per_pixel;
+	int32_t pitch;
+	uint32_t has_metafile;
+	uint32_t subtexture_count;
+};
+
+/**
+ * the name of the cache file for an image file.
+ */
+std::string texture_cache_filename(const std::string &image_filename);
+
+/**
+ * map the cached data of an image, with the subtextures of the given
+ * meta file, which is empty if the image has none.
+ *
+ * @returns false if there is no up to date cache.
+ */
+bool load_texture_cache(const std::string &image_filename, const std::string &meta_filename, texture_data *data);
+
+/**
+ * write the cache file of a decoded image.
+ * failures are logged, as the cache is optional.
+ *
+ * @returns true if the cache was written.
+ */
+bool store_texture_cache(const std::string &image_filename, const std::string &meta_filename, const texture_data &data);
+
+} //namespace renderer
+} //namespace openage
+
+#endif
@@ -0,0 +1,185 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#include "proximity_grid.h"
+
+#include <algorithm>
+
+#include "terrain_object.h"
+#include "../unit/unit.h"
+#include "../util/misc.h"
+
+namespace openage {
+
+object_filter with_attribute(attr_type type) {
+	return [type](TerrainObject *obj) {
+		return obj->unit->has_attribute(type);
+	};
+}
+
+object_filter with_ability(ability_type type) {
+	return [type](TerrainObject *obj) {
+		return obj->unit->get_ability(type) != nullptr;
+	};
+}
+
+namespace {
+
+coord::phys_t distance_sq(const coord::phys3 &a, const coord::phys3 &b) {
+	coord::phys_t dne = a.ne - b.ne;
+	coord::phys_t dse = a.se - b.se;
+	return dne * dne + dse * dse;
+}
+
+} // anonymous namespace
+
+ProximityGrid::ProximityGrid(unsigned cell_tiles)
+	:
+	cell_size{coord::settings::phys_per_tile * cell_tiles},
+	object_count{0} {
+}
+
+ProximityGrid::~ProximityGrid() {}
+
+ProximityGrid::cell_position ProximityGrid::cell_of(const coord::phys3 &pos) const {
+	return cell_position{
+		util::div(pos.ne, this->cell_size),
+		util::div(pos.se, this->cell_size)
+	};
+}
+
+void ProximityGrid::insert(TerrainObject *obj) {
+	this->cells[this->cell_of(obj->pos.draw)].push_back(obj);
+	this->object_count += 1;
+}
+
+void ProximityGrid::erase(TerrainObject *obj) {
+	auto cell_it = this->cells.find(this->cell_of(obj->pos.draw));
+	if (cell_it == this->cells.end()) {
+		return;
+	}
+
+	// order within a cell does not matter,
+	// empty cells are kept to avoid reallocating them
+	auto &objects = cell_it->second;
+	auto obj_it = std::find(objects.begin(), objects.end(), obj);
+	if (obj_it != objects.end()) {
+		*obj_it = objects.back();
+		objects.pop_back();
+		this->object_count -= 1;
+	}
+}
+
+void ProximityGrid::move(TerrainObject *obj, const coord::phys3 &old_pos) {
+	cell_position old_cell = this->cell_of(old_pos);
+	cell_position new_cell = this->cell_of(obj->pos.draw);
+
+	// most moves stay within a cell
+	if (old_cell == new_cell) {
+		return;
+	}
+
+	auto &objects = this->cells[old_cell];
+	auto obj_it = std::find(objects.begin(), objects.end(), obj);
+	if (obj_it != objects.end()) {
+		*obj_it = objects.back();
+		objects.pop_back();
+		this->cells[new_cell].push_back(obj);
+	}
+}
+
+void ProximityGrid::collect(const cell_position &cell, const coord::phys3 &point,
+                            coord::phys_t max_dist_sq, const object_filter &filter,
+                            std::vector<TerrainObject *> &result) const {
+	auto cell_it = this->cells.find(cell);
+	if (cell_it == this->cells.end()) {
+		return;
+	}
+
+	for (TerrainObject *obj : cell_it->second) {
+		if (distance_sq(obj->pos.draw, point) <= max_dist_sq &&
+		    (!filter || filter(obj))) {
+			result.push_back(obj);
+		}
+	}
+}
+
+void ProximityGrid::sort_by_distance(const coord::phys3 &point,
+                                     std::vector<TerrainObject *>::iterator begin,
+                                     std::vector<TerrainObject *>::iterator end) const {
+	std::sort(begin, end, [&point](TerrainObject *a, TerrainObject *b) {
+		coord::phys_t dist_a = distance_sq(a->pos.draw, point);
+		coord::phys_t dist_b = distance_sq(b->pos.draw, point);
+		if (dist_a != dist_b) {
+			return dist_a < dist_b;
+		}
+		return a->unit->id < b->unit->id;
+	});
+}
+
+void ProximityGrid::in_range(const coord::phys3 &point, coord::phys_t radius,
+                             const object_filter &filter,
+                             std::vector<TerrainObject *> &result) const {
+	result.clear();
+
+	coord::phys3_delta extent{radius, radius, 0};
+	cell_position first = this->cell_of(point - extent);
+	cell_position last = this->cell_of(point + extent);
+
+	for (coord::phys_t ne = first.ne; ne <= last.ne; ne++) {
+		for (coord::phys_t se = first.se; se <= last.se; se++) {
+			this->collect(cell_position{ne, se}, point, radius * radius, filter, result);
+		}
+	}
+	this->sort_by_distance(point, result.begin(), result.end());
+}
+
+void ProximityGrid::nearest(const coord::phys3 &point, size_t k, coord::phys_t max_radius,
+                            const object_filter &filter,
+                            std::vector<TerrainObject *> &result) const {
+	result.clear();
+	if (k == 0) {
+		return;
+	}
+
+	cell_position center = this->cell_of(point);
+	coord::phys_t max_dist_sq = max_radius * max_radius;
+	coord::phys_t max_ring = max_radius / this->cell_size + 1;
+
+	/*
+	 * visit square rings of cells around the center cell.
+	 * the point lies in the center cell, so everything beyond
+	 * ring r is at least r cells away from it.
+	 */
+	for (coord::phys_t ring = 0; ring <= max_ring; ring++) {
+		if (ring == 0) {
+			this->collect(center, point, max_dist_sq, filter, result);
+		}
+		else {
+			for (coord::phys_t d = -ring; d <= ring; d++) {
+				this->collect(cell_position{center.ne + d, center.se - ring}, point, max_dist_sq, filter, result);
+				this->collect(cell_position{center.ne + d, center.se + ring}, point, max_dist_sq, filter, result);
+			}
+			for (coord::phys_t d = -ring + 1; d <= ring - 1; d++) {
+				this->collect(cell_position{center.ne - ring, center.se + d}, point, max_dist_sq, filter, result);
+				this->collect(cell_position{center.ne + ring, center.se + d}, point, max_dist_sq, filter, result);
+			}
+		}
+
+		if (result.size() >= k) {
+			this->sort_by_distance(point, result.begin(), result.end());
+			result.resize(k);
+
+			coord::phys_t ring_dist = ring * this->cell_size;
+			if (distance_sq(result.back()->pos.draw, point) < ring_dist * ring_dist) {
+				return;
+			}
+		}
+	}
+	this->sort_by_distance(point, result.begin(), result.end());
+}
+
+size_t ProximityGrid::size() const {
+	return this->object_count;
+}
+
+} // namespace openage
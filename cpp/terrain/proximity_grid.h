@@ -0,0 +1,137 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#ifndef OPENAGE_TERRAIN_PROXIMITY_GRID_H_
+#define OPENAGE_TERRAIN_PROXIMITY_GRID_H_
+
+#include <functional>
+#include <stddef.h>
+#include <unordered_map>
+#include <vector>
+
+#include "../coord/phys3.h"
+#include "../unit/ability.h"
+#include "../unit/attribute.h"
+
+namespace openage {
+
+class TerrainObject;
+
+/**
+ * decides whether a found object is part of a query result.
+ * an empty filter accepts every object.
+ */
+using object_filter = std::function<bool(TerrainObject *)>;
+
+/**
+ * accepts objects whose unit has the given attribute.
+ */
+object_filter with_attribute(attr_type type);
+
+/**
+ * accepts objects whose unit has the given ability.
+ */
+object_filter with_ability(ability_type type);
+
+/**
+ * a coarse grid over the object center positions of a terrain,
+ * to find objects near a point without looking at all of them.
+ *
+ * the terrain objects keep it up to date when they are placed,
+ * moved or removed. queries only read the grid, so they may run
+ * concurrently as long as no object is moved meanwhile.
+ */
+class ProximityGrid {
+public:
+	/**
+	 * @param cell_tiles: edge length of one grid cell, in tiles
+	 */
+	ProximityGrid(unsigned cell_tiles=8);
+	~ProximityGrid();
+
+	/**
+	 * add a placed object at its current position.
+	 */
+	void insert(TerrainObject *obj);
+
+	/**
+	 * remove an object, which must still be at the position it was inserted or moved to.
+	 */
+	void erase(TerrainObject *obj);
+
+	/**
+	 * update the cell of an object, which was moved away from old_pos.
+	 */
+	void move(TerrainObject *obj, const coord::phys3 &old_pos);
+
+	/**
+	 * find all objects whose center is at most radius away from point.
+	 *
+	 * @param result: cleared, then filled with the matching objects,
+	 *                ordered by distance, then unit id
+	 */
+	void in_range(const coord::phys3 &point, coord::phys_t radius,
+	              const object_filter &filter,
+	              std::vector<TerrainObject *> &result) const;
+
+	/**
+	 * find the k objects with their center closest to point,
+	 * searching no further than max_radius.
+	 *
+	 * @param result: cleared, then filled with at most k objects,
+	 *                ordered by distance, then unit id
+	 */
+	void nearest(const coord::phys3 &point, size_t k, coord::phys_t max_radius,
+	             const object_filter &filter,
+	             std::vector<TerrainObject *> &result) const;
+
+	/**
+	 * number of objects in the grid.
+	 */
+	size_t size() const;
+
+private:
+	struct cell_position {
+		coord::phys_t ne, se;
+
+		bool operator ==(const cell_position &other) const {
+			return this->ne == other.ne && this->se == other.se;
+		}
+	};
+
+	struct cell_hash {
+		size_t operator ()(const cell_position &pos) const {
+			return std::hash<coord::phys_t>()(pos.ne * 73856093) ^
+			       std::hash<coord::phys_t>()(pos.se * 19349663);
+		}
+	};
+
+	cell_position cell_of(const coord::phys3 &pos) const;
+
+	/**
+	 * add the matching objects of one cell within the squared distance to result.
+	 */
+	void collect(const cell_position &cell, const coord::phys3 &point,
+	             coord::phys_t max_dist_sq, const object_filter &filter,
+	             std::vector<TerrainObject *> &result) const;
+
+	/**
+	 * sort objects by distance to point, ties are broken by unit id
+	 * so the order does not depend on memory layout.
+	 */
+	void sort_by_distance(const coord::phys3 &point,
+	                      std::vector<TerrainObject *>::iterator begin,
+	                      std::vector<TerrainObject *>::iterator end) const;
+
+	/**
+	 * cell edge length in phys units
+	 */
+	const coord::phys_t cell_size;
+
+	std::unordered_map<cell_position, std::vector<TerrainObject *>, cell_hash> cells;
+
+	size_t object_count;
+};
+
+} // namespace openage
+
+#endif
@@ -3,8 +3,8 @@
 #include "terrain.h"
 
 #include <unordered_map>
-#include <set>
 #include <cinttypes>
+#include <limits>
 
 #include "terrain_chunk.h"
 #include "../engine.h"
@@ -14,6 +14,7 @@
 #include "../coord/chunk.h"
 #include "../coord/tile.h"
 #include "../coord/tile3.h"
+#include "../util/algorithm.h"
 #include "../util/dir.h"
 #include "../util/error.h"
 #include "../util/misc.h"
@@ -33,11 +34,14 @@ Terrain::Terrain(AssetManager &assetmanager,
                  bool is_infinite)
 	:
 	blending_enabled(true),
+	impostor_zoom(0.5),
 	infinite(is_infinite),
 	terrain_id_count(terrain_meta.size()),
 	blendmode_count(blending_meta.size()),
+	chunk_rebuild_count(0),
 	textures(this->terrain_id_count),
 	blending_masks(this->blendmode_count),
+	texture_revision(0),
 	terrain_id_priority_map(terrain_id_count),
 	terrain_id_blendmode_map(terrain_id_count),
 	influences_buf(terrain_id_count){
@@ -102,6 +106,7 @@ bool Terrain::fill(const int *data, coord::tile_delta size) {
 			int terrain_id = data[pos.ne * size.ne + pos.se];
 			TerrainChunk *chunk = this->get_create_chunk(pos);
 			chunk->get_data(pos)->terrain_id = terrain_id;
+			this->tile_changed(pos);
 		}
 	}
 	return was_cut;
@@ -114,6 +119,7 @@ void Terrain::attach_chunk(TerrainChunk *new_chunk,
 	new_chunk->manually_created = manually_created;
 	log::dbg("inserting new chunk at (%02d,%02d)", position.ne, position.se);
 	this->chunks[position] = new_chunk;
+	new_chunk->tiles_dirty = true;
 
 	struct chunk_neighbors neigh = this->get_chunk_neighbors(position);
 	for (int i = 0; i < 8; i++) {
@@ -126,6 +132,9 @@ void Terrain::attach_chunk(TerrainChunk *new_chunk,
 			//to the new chunk
 			neighbor->neighbors.neighbor[(i+4) % 8] = new_chunk;
 
+			//the border tiles of the neighbor now blend with the new chunk
+			neighbor->tiles_dirty = true;
+
 			log::dbg("neighbor %d gets notified of new neighbor.", i);
 		}
 		else {
@@ -294,10 +303,28 @@ bool Terrain::check_tile_position(coord::tile pos) {
 
 }
 
-void Terrain::draw(Engine *engine) {
-	// TODO: move this draw invokation to a render manager.
-	//       it can reorder the draw instructions and minimize texture switching.
+void Terrain::tile_changed(coord::tile position) {
+	// the tile itself and the blending of its neighbors change
+	TerrainChunk *chunk = this->get_chunk(position);
+	if (chunk != nullptr) {
+		chunk->tiles_dirty = true;
+	}
+
+	for (int i = 0; i < 8; i++) {
+		TerrainChunk *neighbor = this->get_chunk(position + neigh_offsets[i]);
+		if (neighbor != nullptr) {
+			neighbor->tiles_dirty = true;
+		}
+	}
+}
 
+void Terrain::all_tiles_changed() {
+	for (auto &chunk : this->chunks) {
+		chunk.second->tiles_dirty = true;
+	}
+}
+
+void Terrain::draw(Engine *engine) {
 	// top left, bottom right tile coordinates
 	// that are currently visible in the window
 	coord::tile tl, tr, bl, br;
@@ -316,28 +343,53 @@ void Terrain::draw(Engine *engine) {
 	br = wbr.to_camgame().to_phys3(0).to_phys2().to_tile();
 
 	// main terrain calculation call: get the `terrain_render_data`
-	auto draw_data = this->create_draw_advice(tl, tr, br, bl);
+	auto &draw_data = this->create_draw_advice(tl, tr, br, bl);
 
-	// TODO: the following loop is totally inefficient and shit.
-	//       it reloads the drawing texture to the gpu FOR EACH TILE!
-	//       nevertheless, currently it works.
+	// the chunks covering the drawn rhombus, see create_draw_advice
+	coord::chunk first = coord::tile{bl.ne, tl.se}.to_chunk();
+	coord::chunk last  = coord::tile{tr.ne, br.se}.to_chunk();
 
-	// draw the terrain ground
-	for (auto &tile : draw_data.tiles) {
+	// the chunk sprites are positioned relative to the camgame origin,
+	// so they stay valid when the camera moves.
+	coord::camgame origin = coord::phys3{0, 0, 0}.to_camgame();
 
-		// iterate over all layers to be drawn
-		for (int i = 0; i < tile.count; i++) {
-			struct tile_data *layer = &tile.data[i];
+	// textures may finish loading after the chunks were built
+	unsigned revision = 0;
+	for (auto tex : this->textures) {
+		revision += tex->get_revision();
+	}
+	for (auto tex : this->blending_masks) {
+		revision += tex->get_revision();
+	}
+	if (revision != this->texture_revision) {
+		this->texture_revision = revision;
+		this->all_tiles_changed();
+	}
 
-			// position, where the tile is drawn
-			coord::tile tile_pos = layer->pos;
+	// far away, every chunk is a single textured quad
+	bool use_impostors = (engine->camgame_zoom <= this->impostor_zoom and
+	                      renderer::Impostor::is_supported());
 
-			int      mask_id       = layer->mask_id;
-			Texture *texture       = layer->tex;
-			int      subtexture_id = layer->subtexture_id;
-			Texture *mask_texture  = layer->mask_tex;
+	// draw the terrain ground, one buffer per chunk.
+	for (coord::chunk pos = first; pos.ne <= last.ne; pos.ne++) {
+		for (pos.se = first.se; pos.se <= last.se; pos.se++) {
+			TerrainChunk *chunk = this->get_chunk(pos);
+			if (chunk == nullptr) {
+				continue;
+			}
+
+			if (chunk->tiles_dirty) {
+				this->build_chunk_sprites(pos, chunk);
+			}
 
-			texture->draw(tile_pos, ALPHAMASKED, subtexture_id, mask_texture, mask_id);
+			if (use_impostors) {
+				// the impostor resolution matches the screen at the threshold
+				chunk->impostor.set_scale(this->impostor_zoom);
+				engine->get_render_commands().impostor(&chunk->impostor, &chunk->tile_sprites, origin.x, origin.y);
+			}
+			else {
+				engine->get_render_commands().static_sprites(&chunk->tile_sprites, origin.x, origin.y);
+			}
 		}
 	}
 
@@ -348,10 +400,60 @@ void Terrain::draw(Engine *engine) {
 	}
 }
 
-struct terrain_render_data Terrain::create_draw_advice(coord::tile ab,
-                                                       coord::tile cd,
-                                                       coord::tile ef,
-                                                       coord::tile gh) {
+void Terrain::build_chunk_sprites(coord::chunk position, TerrainChunk *chunk) {
+	this->chunk_tiles_buf.clear();
+	this->chunk_sprites_buf.clear();
+
+	for (coord::tile_t ne = 0; ne < coord::settings::tiles_per_chunk; ne++) {
+		for (coord::tile_t se = 0; se < coord::settings::tiles_per_chunk; se++) {
+			coord::tile tile_pos = position.to_tile({ne, se});
+			auto tile = this->create_tile_advice(tile_pos);
+			if (tile.count == 0) {
+				continue;
+			}
+
+			// the camera independent position of the tile
+			coord::phys3_delta tile_phys = tile_pos.to_tile3().to_phys3() - coord::phys3{0, 0, 0};
+			coord::camgame_delta draw_pos = tile_phys.to_camgame();
+
+			// the base tile and as many blending layers as possible
+			// are drawn in one pass by the terrain blending shader.
+			struct tile_data *base = &tile.data[0];
+			renderer::terrain_quad quad = base->tex->make_terrain_quad(draw_pos.x, draw_pos.y, base->subtexture_id);
+
+			int i = 1;
+			for (; i < tile.count; i++) {
+				struct tile_data *layer = &tile.data[i];
+				if (not layer->tex->add_blend_layer(&quad, draw_pos.x, draw_pos.y,
+				                                    layer->subtexture_id, layer->mask_tex, layer->mask_id)) {
+					break;
+				}
+			}
+			this->chunk_tiles_buf.push_back(quad);
+
+			// the remaining layers are drawn above the blended tiles
+			// by their index as depth.
+			for (; i < tile.count; i++) {
+				struct tile_data *layer = &tile.data[i];
+
+				renderer::sprite_quad overlay = layer->tex->make_quad(
+					draw_pos.x, draw_pos.y, ALPHAMASKED, false,
+					layer->subtexture_id, 0, layer->mask_tex, layer->mask_id
+				);
+				this->chunk_sprites_buf.push_back({overlay, i});
+			}
+		}
+	}
+
+	chunk->tile_sprites.build(this->chunk_tiles_buf, this->chunk_sprites_buf);
+	chunk->tiles_dirty = false;
+	this->chunk_rebuild_count += 1;
+}
+
+const struct terrain_render_data &Terrain::create_draw_advice(coord::tile ab,
+                                                              coord::tile cd,
+                                                              coord::tile ef,
+                                                              coord::tile gh) {
 
 	/*
 	 * The passed parameters define the screen corners.
@@ -379,44 +481,90 @@ struct terrain_render_data Terrain::create_draw_advice(coord::tile ab,
 	 * For now, we are drawing the big rhombus.
 	 */
 
-	// procedure: find all the tiles to be drawn
-	// and store them to a tile drawing instruction structure
-	struct terrain_render_data data;
-
-	// vector of tiles to be drawn
-	std::vector<struct tile_draw_data> *tiles = &data.tiles;
-
-	// ordered set of objects on the terrain (buildings.)
-	// it's ordered by the visibility layers.
-	auto objects = &data.objects;
+	// procedure: find all the objects on the tiles to be drawn
+	// and store them to a drawing instruction structure.
+	// all buffers are reused, so this doesn't allocate once warmed up.
+	auto &entries = this->draw_order_buf;
+	entries.clear();
 
 	coord::tile gb = {gh.ne, ab.se};
 	coord::tile cf = {cd.ne, ef.se};
 
-	// hint the vector about the number of tiles it will contain
-	size_t tiles_count = std::abs(cf.ne - gb.ne) * std::abs(cf.se - gb.se);
-	tiles->reserve(tiles_count);
-
 	// sweep the whole rhombus area
 	for (coord::tile tilepos = gb; tilepos.ne <= (ssize_t) cf.ne; tilepos.ne++) {
 		for (tilepos.se = gb.se; tilepos.se <= (ssize_t) cf.se; tilepos.se++) {
 
-			// get the terrain tile drawing data
-			auto tile = this->create_tile_advice(tilepos);
-			tiles->push_back(tile);
-
 			// get the object standing on the tile
 			// TODO: make the terrain independent of objects standing on it.
 			TileContent *tile_content = this->get_data(tilepos);
 			if (tile_content != nullptr) {
 				for (TerrainObject *obj_item : tile_content->obj ) {
-					objects->insert(obj_item);
+					entries.push_back({0, obj_item});
 				}
 			}
 		}
 	}
 
-	return data;
+	// the objects are ordered by the visibility layers:
+	// back to front is descending (ne - se), then ascending ne.
+	// both are made relative to the visible range, so they
+	// usually fit one 64 bit radix sort key.
+	coord::phys_t ypos_max = std::numeric_limits<coord::phys_t>::min();
+	coord::phys_t ypos_min = std::numeric_limits<coord::phys_t>::max();
+	coord::phys_t ne_min   = std::numeric_limits<coord::phys_t>::max();
+	coord::phys_t ne_max   = std::numeric_limits<coord::phys_t>::min();
+	for (auto &entry : entries) {
+		const coord::phys3 &pos = entry.object->pos.draw;
+		ypos_max = std::max(ypos_max, pos.ne - pos.se);
+		ypos_min = std::min(ypos_min, pos.ne - pos.se);
+		ne_max   = std::max(ne_max, pos.ne);
+		ne_min   = std::min(ne_min, pos.ne);
+	}
+
+	constexpr uint64_t key_half_max = std::numeric_limits<uint32_t>::max();
+	if (entries.empty()) {
+		// nothing to sort
+	}
+	else if ((uint64_t) (ypos_max - ypos_min) <= key_half_max and
+	         (uint64_t) (ne_max - ne_min) <= key_half_max) {
+		for (auto &entry : entries) {
+			const coord::phys3 &pos = entry.object->pos.draw;
+			uint64_t ypos_key = ypos_max - (pos.ne - pos.se);
+			uint64_t ne_key   = pos.ne - ne_min;
+			entry.key = (ypos_key << 32) | ne_key;
+		}
+		util::radix_sort(&entries, &this->draw_order_tmp, [](const draw_order_entry &e) {
+			return e.key;
+		});
+	}
+	else {
+		// objects spread too far apart for the packed key
+		std::sort(entries.begin(), entries.end(), [](const draw_order_entry &a, const draw_order_entry &b) {
+			return *a.object < *b.object;
+		});
+	}
+
+	// objects covering several tiles were found once per tile.
+	// all their copies have the same position, so they are
+	// in the same run of equally placed objects.
+	auto &objects = this->render_data.objects;
+	objects.clear();
+	size_t run_start = 0;
+	for (auto &entry : entries) {
+		const coord::phys3 &pos = entry.object->pos.draw;
+		if (run_start < objects.size()) {
+			const coord::phys3 &run_pos = objects[run_start]->pos.draw;
+			if (run_pos.ne != pos.ne or run_pos.se != pos.se) {
+				run_start = objects.size();
+			}
+		}
+
+		if (std::find(objects.begin() + run_start, objects.end(), entry.object) == objects.end()) {
+			objects.push_back(entry.object);
+		}
+	}
+
+	return this->render_data;
 }
 
 
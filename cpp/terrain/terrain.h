@@ -5,10 +5,10 @@
 
 #include <functional>
 #include <stddef.h>
-#include <set>
 #include <unordered_map>
 #include <vector>
 
+#include "proximity_grid.h"
 #include "terrain_chunk.h"
 #include "terrain_object.h"
 #include "../assetmanager.h"
@@ -141,11 +141,12 @@ struct tile_draw_data {
 
 /**
  * the complete render instruction collection for the terrain.
- * this is passed to the renderer and will be drawn on screen.
+ * the tiles are drawn from the chunk sprite buffers,
+ * this collects what is drawn on top of them.
  */
 struct terrain_render_data {
-	std::vector<struct tile_draw_data> tiles;
-	std::set<TerrainObject *, util::less<TerrainObject *>> objects;
+	/** in drawing order, back to front */
+	std::vector<TerrainObject *> objects;
 };
 
 /**
@@ -163,6 +164,7 @@ public:
 	~Terrain();
 
 	bool blending_enabled; //!< is terrain blending active. increases memory accesses by factor ~8
+	float impostor_zoom; //!< chunks are drawn as impostors at this camera zoom and below, 0 disables them
 	bool infinite; //!< chunks are automagically created as soon as they are referenced
 
 	coord::tile limit_positive, limit_negative; //!< for non-infinite terrains, this is the size limit.
@@ -299,6 +301,18 @@ public:
 	 */
 	int get_blending_mode(terrain_t base_id, terrain_t neighbor_id);
 
+	/**
+	 * notify the terrain that the terrain id of a tile changed,
+	 * so the drawing data of it and its neighbors is rebuilt.
+	 */
+	void tile_changed(coord::tile position);
+
+	/**
+	 * rebuild the drawing data of all tiles,
+	 * e.g. after the blending settings changed.
+	 */
+	void all_tiles_changed();
+
 	/**
 	 * draw the currently visible terrain area on screen.
 	 * @param engine: the engine where the terrain should be drawn to.
@@ -316,9 +330,15 @@ public:
 	 * @param ef: lower right tile
 	 * @param gh: lower left tile
 	 *
-	 * @returns a drawing instruction struct that contains all information for rendering
+	 * @returns a drawing instruction struct that contains all information for rendering,
+	 *          valid until the next call.
 	 */
-	struct terrain_render_data create_draw_advice(coord::tile ab, coord::tile cd, coord::tile ef, coord::tile gh);
+	const struct terrain_render_data &create_draw_advice(coord::tile ab, coord::tile cd, coord::tile ef, coord::tile gh);
+
+	/**
+	 * rebuild the tile sprites of a chunk.
+	 */
+	void build_chunk_sprites(coord::chunk position, TerrainChunk *chunk);
 
 	/**
 	 * create rendering and blending information for a single tile on the terrain.
@@ -361,6 +381,17 @@ public:
 	size_t terrain_id_count;
 	size_t blendmode_count;
 
+	/**
+	 * index of the objects placed on this terrain by position,
+	 * for finding objects near a point.
+	 */
+	ProximityGrid proximity;
+
+	/**
+	 * number of chunk tile sprite rebuilds so far.
+	 */
+	size_t chunk_rebuild_count;
+
 private:
 	/**
 	 * maps chunk coordinates to chunks.
@@ -370,10 +401,34 @@ private:
 	std::vector<Texture*> textures;
 	std::vector<Texture*> blending_masks;
 
+	/**
+	 * sum of the revisions of all textures and masks when the chunk
+	 * sprites were last checked. the sprites store subtexture
+	 * coordinates, so they are rebuilt when a texture is (re)loaded.
+	 */
+	unsigned texture_revision;
+
 	std::vector<int> terrain_id_priority_map;
 	std::vector<int> terrain_id_blendmode_map;
 
 	std::vector<influence> influences_buf;
+
+	/**
+	 * an object to be drawn, with its sort key for the drawing order.
+	 */
+	struct draw_order_entry {
+		uint64_t key;
+		TerrainObject *object;
+	};
+
+	/** reused buffers for create_draw_advice */
+	std::vector<draw_order_entry> draw_order_buf;
+	std::vector<draw_order_entry> draw_order_tmp;
+	struct terrain_render_data render_data;
+
+	/** staging buffers for building the chunk sprites */
+	std::vector<renderer::terrain_quad> chunk_tiles_buf;
+	std::vector<renderer::sprite_command> chunk_sprites_buf;
 };
 
 } // namespace openage
@@ -21,7 +21,8 @@ namespace openage {
 
 TerrainChunk::TerrainChunk()
 	:
-	manually_created{true} {
+	manually_created{true},
+	tiles_dirty{true} {
 	this->tile_count = std::pow(chunk_size, 2);
 
 	// the data array for this chunk.
@@ -10,6 +10,8 @@
 #include "terrain_object.h"
 #include "../coord/camgame.h"
 #include "../coord/tile.h"
+#include "../renderer/impostor.h"
+#include "../renderer/static_sprites.h"
 #include "../texture.h"
 #include "../util/file.h"
 
@@ -109,6 +111,24 @@ public:
 	void set_terrain(Terrain *parent);
 
 	bool manually_created;
+
+	/**
+	 * the drawing layers of all tiles on this chunk,
+	 * positioned relative to the camgame origin.
+	 */
+	renderer::StaticSprites tile_sprites;
+
+	/**
+	 * tile_sprites no longer match the tiles and have to be rebuilt.
+	 * set this when the terrain of the chunk or a neighbor tile changes.
+	 */
+	bool tiles_dirty;
+
+	/**
+	 * tile_sprites rendered to a texture, drawn instead of
+	 * them when the camera is zoomed out far enough.
+	 */
+	renderer::Impostor impostor;
 };
 
 } // namespace openage
@@ -43,6 +43,8 @@ bool TerrainObject::place(Terrain *terrain, coord::phys3 &position) {
 	}
 
 	this->place_unchecked(terrain, position);
+	this->last_tick_pos = this->pos.draw;
+	terrain->proximity.insert(this);
 	return true;
 }
 
@@ -54,17 +56,27 @@ bool TerrainObject::move(coord::phys3 &position) {
 	// todo should do outside of this function
 	bool can_move = this->passable(position);
 	if (can_move) {
-		this->remove();
-		this->place_unchecked(terrain, position);
+		coord::phys3 old_pos = this->pos.draw;
+		this->remove_from_tiles();
+		this->place_unchecked(this->terrain, position);
+		this->terrain->proximity.move(this, old_pos);
 	}
 	return can_move;
 }
 
 void TerrainObject::remove() {
-	if (this->occupied_chunk_count == 0 or not this->placed) {
+	if (not this->placed) {
 		return;
 	}
 
+	this->terrain->proximity.erase(this);
+	if (this->occupied_chunk_count == 0) {
+		return;
+	}
+	this->remove_from_tiles();
+}
+
+void TerrainObject::remove_from_tiles() {
 	for (coord::tile temp_pos : tile_list(this->pos)) {
 		TerrainChunk *chunk = terrain->get_chunk(temp_pos);
 
@@ -100,6 +112,7 @@ void TerrainObject::set_ground(int id, int additional) {
 
 			size_t tile_pos = chunk->tile_position_neigh(temp_pos);
 			chunk->get_data(tile_pos)->terrain_id = id;
+			terrain->tile_changed(temp_pos);
 			temp_pos.se++;
 		}
 		temp_pos.se = this->pos.start.se - additional;
@@ -107,10 +120,25 @@ void TerrainObject::set_ground(int id, int additional) {
 	}
 }
 
+void TerrainObject::begin_tick() {
+	this->last_tick_pos = this->pos.draw;
+}
+
+coord::phys3 TerrainObject::interpolated_pos(float fraction) const {
+	coord::phys3_delta step = this->pos.draw - this->last_tick_pos;
+	coord::phys3 result = this->last_tick_pos;
+	result.ne += static_cast<coord::phys_t>(step.ne * fraction);
+	result.se += static_cast<coord::phys_t>(step.se * fraction);
+	result.up += static_cast<coord::phys_t>(step.up * fraction);
+	return result;
+}
+
 bool TerrainObject::draw() {
+	Engine &engine = Engine::get();
+	coord::phys3 draw_pos = this->interpolated_pos(engine.simulation_tick_fraction());
 
 	// should only draw outline when unit is selected
-	this->outline_texture->draw(this->pos.draw.to_camgame());
+	this->outline_texture->draw(draw_pos.to_camgame());
 	return this->unit->draw();
 }
 
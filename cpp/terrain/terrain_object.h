@@ -70,6 +70,12 @@ public:
 	 */
 	tile_range pos;
 
+	/**
+	 * the center position at the start of the current simulation tick,
+	 * drawing interpolates between this and pos.draw
+	 */
+	coord::phys3 last_tick_pos;
+
 	/**
 	 * unit which is inside this base
 	 * this pointer is mainly for drawing purposes
@@ -109,6 +115,20 @@ public:
 	 */
 	void set_ground(int id, int additional=0);
 
+	/**
+	 * marks the start of a simulation tick,
+	 * the current position becomes the start point of the interpolation.
+	 */
+	void begin_tick();
+
+	/**
+	 * the position to draw this object at, between the positions
+	 * of the previous and the current simulation tick.
+	 *
+	 * @param fraction: progress towards the next tick, in [0, 1]
+	 */
+	coord::phys3 interpolated_pos(float fraction) const;
+
 	/**
 	 * display the texture of this object at the placement position.
 	 */
@@ -167,6 +187,11 @@ protected:
 	 */
 	Texture *outline_texture;
 
+	/**
+	 * removes the pointers to this object from the tiles it covers
+	 */
+	void remove_from_tiles();
+
 	/**
 	 * placement function which does not check passibility
 	 * used only when passibilty is already checked
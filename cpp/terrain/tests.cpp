@@ -0,0 +1,178 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "proximity_grid.h"
+#include "terrain_object.h"
+#include "../log.h"
+#include "../unit/attribute.h"
+#include "../unit/unit.h"
+
+namespace openage {
+namespace terrain {
+namespace tests {
+
+namespace {
+
+coord::phys3 tile_pos(double ne, double se) {
+	return coord::phys3{
+		static_cast<coord::phys_t>(ne * coord::settings::phys_per_tile),
+		static_cast<coord::phys_t>(se * coord::settings::phys_per_tile),
+		0
+	};
+}
+
+/**
+ * the objects within radius of point ordered by distance, then unit id,
+ * at most k of them, found by looking at each object.
+ */
+std::vector<TerrainObject *> brute_force(const std::vector<TerrainObject *> &objects,
+                                         const coord::phys3 &point, coord::phys_t radius,
+                                         size_t k, const object_filter &filter) {
+	auto dist = [&point](TerrainObject *obj) {
+		coord::phys_t dne = obj->pos.draw.ne - point.ne;
+		coord::phys_t dse = obj->pos.draw.se - point.se;
+		return dne * dne + dse * dse;
+	};
+
+	std::vector<TerrainObject *> result;
+	for (TerrainObject *obj : objects) {
+		if (dist(obj) <= radius * radius and (!filter or filter(obj))) {
+			result.push_back(obj);
+		}
+	}
+	std::sort(result.begin(), result.end(), [&dist](TerrainObject *a, TerrainObject *b) {
+		if (dist(a) != dist(b)) {
+			return dist(a) < dist(b);
+		}
+		return a->unit->id < b->unit->id;
+	});
+	if (result.size() > k) {
+		result.resize(k);
+	}
+	return result;
+}
+
+} // anonymous namespace
+
+/**
+ * compares the queries of the proximity grid with looking at all objects,
+ * before and after objects were moved and removed.
+ */
+void proximity_grid() {
+	int stage = 0;
+
+	// small cells, so the queries span several rings of them
+	ProximityGrid grid{2};
+	auto pass = [](const coord::phys3 &) { return true; };
+
+	std::vector<std::unique_ptr<Unit>> units;
+	std::vector<std::unique_ptr<TerrainObject>> locations;
+	std::vector<TerrainObject *> objects, found, expected;
+	Attribute<attr_type::dropsite> dropsite;
+	object_filter is_dropsite = with_attribute(attr_type::dropsite);
+
+	// a lattice around the origin, many objects are equally far from
+	// the lattice points, so the unit ids break the ties.
+	// ids descend, so they don't follow the insertion order.
+	for (int ne = -6; ne < 6; ne++) {
+		for (int se = -6; se < 6; se++) {
+			units.emplace_back(new Unit(nullptr, 1000 - units.size()));
+			Unit *unit = units.back().get();
+			if (units.size() % 7 == 0) {
+				unit->add_attribute(&dropsite);
+			}
+			locations.emplace_back(new RadialObject{unit, pass, 0.5f, nullptr});
+			TerrainObject *obj = locations.back().get();
+			obj->pos.draw = tile_pos(ne * 3, se * 3);
+			grid.insert(obj);
+			objects.push_back(obj);
+		}
+	}
+
+	const coord::phys3 points[] = {
+		tile_pos(0, 0), tile_pos(3, -3), tile_pos(1.5, 1.5),
+		tile_pos(-17.25, 4.5), tile_pos(40, 40), tile_pos(0.75, -9.5)
+	};
+	const double radii[] = {0, 3, 4.25, 10, 100};
+	const size_t counts[] = {1, 4, 9, 40, 500};
+
+	// checks all queries against the brute force results
+	auto check_queries = [&]() {
+		for (auto &point : points) {
+			for (double r : radii) {
+				coord::phys_t radius = r * coord::settings::phys_per_tile;
+
+				grid.in_range(point, radius, nullptr, found);
+				if (found != brute_force(objects, point, radius, objects.size(), nullptr)) { return false; }
+
+				grid.in_range(point, radius, is_dropsite, found);
+				if (found != brute_force(objects, point, radius, objects.size(), is_dropsite)) { return false; }
+
+				for (size_t k : counts) {
+					grid.nearest(point, k, radius, nullptr, found);
+					if (found != brute_force(objects, point, radius, k, nullptr)) { return false; }
+
+					grid.nearest(point, k, radius, is_dropsite, found);
+					if (found != brute_force(objects, point, radius, k, is_dropsite)) { return false; }
+				}
+			}
+		}
+		return true;
+	};
+
+	if (grid.size() != objects.size()) { goto out; }
+	stage += 1;
+
+	// range queries, k nearest across several rings, filters and max_radius
+	if (not check_queries()) { goto out; }
+	stage += 1;
+
+	// the nearest of four equally far objects is the one with the lowest id
+	grid.nearest(tile_pos(1.5, 1.5), 1, 1000 * coord::settings::phys_per_tile, nullptr, found);
+	expected = brute_force(objects, tile_pos(1.5, 1.5), 3 * coord::settings::phys_per_tile, 4, nullptr);
+	if (found.size() != 1 or expected.size() != 4 or found[0] != expected[0]) { goto out; }
+	for (TerrainObject *obj : expected) {
+		if (obj->unit->id < found[0]->unit->id) { goto out; }
+	}
+	stage += 1;
+
+	// move objects within and across cells, like TerrainObject::move
+	for (size_t i = 0; i < objects.size(); i += 3) {
+		coord::phys3 old_pos = objects[i]->pos.draw;
+		double shift = (i % 2 == 0) ? 0.25 : -7.5;
+		objects[i]->pos.draw = old_pos + coord::phys3_delta{
+			static_cast<coord::phys_t>(shift * coord::settings::phys_per_tile),
+			static_cast<coord::phys_t>(-shift * 2 * coord::settings::phys_per_tile),
+			0
+		};
+		grid.move(objects[i], old_pos);
+	}
+	if (grid.size() != objects.size()) { goto out; }
+	if (not check_queries()) { goto out; }
+	stage += 1;
+
+	// remove objects, like TerrainObject::remove
+	for (size_t i = 0; i < objects.size(); i += 5) {
+		grid.erase(objects[i]);
+	}
+	for (size_t i = objects.size(); i-- > 0;) {
+		if (i % 5 == 0) {
+			objects.erase(objects.begin() + i);
+		}
+	}
+	if (grid.size() != objects.size()) { goto out; }
+	if (not check_queries()) { goto out; }
+
+	return;
+
+out:
+	log::err("proximity grid test failed at stage %d", stage);
+	throw "proximity grid test failed";
+}
+
+} // namespace tests
+} // namespace terrain
+} // namespace openage
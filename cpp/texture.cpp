@@ -8,7 +8,9 @@
 #include <math.h>
 #include <stdio.h>
 
+#include "engine.h"
 #include "log.h"
+#include "renderer/texture_cache.h"
 #include "util/error.h"
 #include "util/file.h"
 
@@ -33,9 +35,28 @@ shader::Program *program;
 GLint base_texture, mask_texture, base_coord, mask_coord, show_mask;
 }
 
+namespace terrain_blend_shader {
+shader::Program *program;
+GLint base_texture, mask_texture, base_coord, layer_count;
+GLint layer_coord[renderer::max_blend_layers];
+}
+
+void surface_deleter::operator ()(SDL_Surface *surface) const {
+	SDL_FreeSurface(surface);
+}
+
+size_t texture_data::image_bytes() const {
+	return (size_t) this->pitch * this->h;
+}
+
 Texture::Texture(int width, int height, void *data)
 	:
-	use_metafile{false} {
+	atlas_dimensions{1},
+	use_metafile{false},
+	atlas{nullptr},
+	in_atlas{false},
+	loaded{true},
+	revision{1} {
 	this->w = width;
 	this->h = height;
 	this->id = make_gl_texture(
@@ -49,75 +70,137 @@ Texture::Texture(int width, int height, void *data)
 	gamedata::subtexture s{0, 0, this->w, this->h, this->w/2, this->h/2};
 	this->subtexture_count = 1;
 	this->subtextures.push_back(s);
-
-	glGenBuffers(1, &this->vertbuf);
 }
 
-Texture::Texture(const std::string &filename, bool use_metafile)
+Texture::Texture(const std::string &filename, bool use_metafile, renderer::TextureAtlas *atlas)
 	:
 	use_metafile{use_metafile},
+	atlas{atlas},
+	in_atlas{false},
+	loaded{false},
+	revision{0},
 	filename{filename} {
 	// load the texture upon creation
 	this->load();
 }
 
+Texture::Texture(const std::string &filename, bool use_metafile, renderer::TextureAtlas *atlas, const Texture *placeholder)
+	:
+	atlas_dimensions{1},
+	use_metafile{use_metafile},
+	atlas{atlas},
+	in_atlas{false},
+	loaded{false},
+	revision{0},
+	filename{filename} {
+	// share the gl texture of the placeholder, see get_subtexture
+	this->id = placeholder->id;
+	this->w = placeholder->w;
+	this->h = placeholder->h;
+	this->subtextures.push_back(*placeholder->get_subtexture(0));
+	this->subtexture_count = 1;
+}
+
 void Texture::load() {
-	SDL_Surface *surface;
-	int texture_format_in;
-	int texture_format_out;
+	this->upload(Texture::decode(this->filename, this->use_metafile));
+}
+
+texture_data Texture::decode(const std::string &filename, bool use_metafile, bool use_cache) {
+	std::string meta_filename;
+	if (use_metafile) {
+		// change the suffix to .docx (lol)
+		meta_filename = filename.substr(0, filename.length() - 3) + "docx";
+	}
 
-	surface = IMG_Load(this->filename.c_str());
+	texture_data data;
+	if (use_cache and renderer::load_texture_cache(filename, meta_filename, &data)) {
+		log::dbg1("Loaded texture from cache of '%s'", filename.c_str());
+		return data;
+	}
 
-	if (!surface) {
+	data.surface.reset(IMG_Load(filename.c_str()));
+
+	if (!data.surface) {
 		throw util::Error("Could not load texture from '%s': %s", filename.c_str(), IMG_GetError());
 	}
 	else {
 		log::dbg1("Loaded texture from '%s'", filename.c_str());
 	}
 
+	SDL_Surface *surface = data.surface.get();
+	data.w = surface->w;
+	data.h = surface->h;
+	data.bytes_per_pixel = surface->format->BytesPerPixel;
+	data.pitch = surface->pitch;
+	data.pixels = surface->pixels;
+
+	if (data.bytes_per_pixel != 3 and data.bytes_per_pixel != 4) {
+		throw util::Error("Unknown texture bit depth for '%s': %d bytes per pixel)", filename.c_str(), data.bytes_per_pixel);
+	}
+
+	data.has_metafile = use_metafile;
+	if (use_metafile) {
+		log::msg("loading meta file %s", meta_filename.c_str());
+
+		// get subtexture information by meta file exported by script
+		data.subtextures = util::read_csv_file<gamedata::subtexture>(meta_filename);
+	}
+
+	if (use_cache) {
+		renderer::store_texture_cache(filename, meta_filename, data);
+	}
+
+	return data;
+}
+
+void Texture::upload(texture_data &&data) {
+	int texture_format_in;
+	int texture_format_out;
+
+	// the previous image is replaced
+	this->unload();
+
 	// glTexImage2D format determination
-	switch (surface->format->BytesPerPixel) {
-	case 3: // RGB 24 bit
+	int bpp = data.bytes_per_pixel;
+	if (bpp == 3) { // RGB 24 bit
 		texture_format_in  = GL_RGB8;
 		texture_format_out = GL_RGB;
-		break;
-	case 4: // RGBA 32 bit
+	}
+	else { // RGBA 32 bit, checked by decode
 		texture_format_in  = GL_RGBA8;
 		texture_format_out = GL_RGBA;
-		break;
-	default:
-		throw util::Error("Unknown texture bit depth for '%s': %d bytes per pixel)", filename.c_str(), surface->format->BytesPerPixel);
-		break;
 	}
 
-	this->w = surface->w;
-	this->h = surface->h;
-	this->id = make_gl_texture(
-		texture_format_in,
-		texture_format_out,
-		surface->w,
-		surface->h,
-		surface->pixels
-	);
-
-	SDL_FreeSurface(surface);
+	this->w = data.w;
+	this->h = data.h;
 
-	if (use_metafile) {
-		// change the suffix to .docx (lol)
-		size_t m_len = filename.length() + 2;
-		char *meta_filename = new char[m_len];
-		strncpy(meta_filename, filename.c_str(), m_len - 5);
-		strncpy(meta_filename + m_len - 5, "docx", 5);
+	// when reloaded with the same size, this gets the released slot again
+	if (this->atlas != nullptr and
+	         this->atlas->place(this->w, this->h, bpp, data.pitch, data.pixels, &this->atlas_slot)) {
+		this->in_atlas = true;
+	}
+	else {
+		this->in_atlas = false;
+		this->id = make_gl_texture(
+			texture_format_in,
+			texture_format_out,
+			data.w,
+			data.h,
+			data.pixels
+		);
+	}
 
-		log::msg("loading meta file %s", meta_filename);
+	// the pixels are on the gpu now
+	data.pixels = nullptr;
+	data.surface.reset();
+	data.mapping.reset();
 
-		// get subtexture information by meta file exported by script
-		this->subtextures = util::read_csv_file<gamedata::subtexture>(meta_filename);
+	if (data.has_metafile) {
+		this->subtextures = std::move(data.subtextures);
 		this->subtexture_count = this->subtextures.size();
 
 		// TODO: use information from empires.dat for that, also use x and y sizes:
 		this->atlas_dimensions = sqrt(this->subtexture_count);
-		delete[] meta_filename;
 	}
 	else {
 		// we don't have a texture description file.
@@ -125,12 +208,39 @@ void Texture::load() {
 		gamedata::subtexture s{0, 0, this->w, this->h, this->w/2, this->h/2};
 
 		this->subtexture_count = 1;
+		this->subtextures.clear();
 		this->subtextures.push_back(s);
+		this->atlas_dimensions = 1;
 	}
-	glGenBuffers(1, &this->vertbuf);
+
+	if (this->in_atlas) {
+		// the subtextures are now part of the atlas page
+		this->id = this->atlas_slot.texture;
+		this->w = this->atlas_slot.page_width;
+		this->h = this->atlas_slot.page_height;
+		for (auto &s : this->subtextures) {
+			s.x += this->atlas_slot.x;
+			s.y += this->atlas_slot.y;
+		}
+	}
+
+	this->loaded = true;
+	this->revision += 1;
+}
+
+bool Texture::is_loaded() const {
+	return this->loaded;
+}
+
+unsigned Texture::get_revision() const {
+	return this->revision;
+}
+
+const std::string &Texture::get_filename() const {
+	return this->filename;
 }
 
-GLuint Texture::make_gl_texture(int iformat, int oformat, int w, int h, void *data) {
+GLuint Texture::make_gl_texture(int iformat, int oformat, int w, int h, const void *data) {
 	// generate 1 texture handle
 	GLuint textureid;
 	glGenTextures(1, &textureid);
@@ -151,13 +261,22 @@ GLuint Texture::make_gl_texture(int iformat, int oformat, int w, int h, void *da
 }
 
 void Texture::unload() {
-	glDeleteTextures(1, &this->id);
-	glDeleteBuffers(1, &this->vertbuf);
+	// atlas pages are deleted by the atlas,
+	// the placeholder texture by its owner.
+	if (this->loaded) {
+		if (this->in_atlas) {
+			this->atlas->release(this->atlas_slot);
+			this->in_atlas = false;
+		}
+		else {
+			glDeleteTextures(1, &this->id);
+		}
+	}
+	this->loaded = false;
 }
 
 
 void Texture::reload() {
-	this->unload();
 	this->load();
 }
 
@@ -185,63 +304,44 @@ void Texture::draw(coord::camgame pos, unsigned int mode,  bool mirrored, int su
 }
 
 
-void Texture::draw(coord::tile pos, unsigned int mode, int subid, Texture *alpha_texture, int alpha_subid) const {
-	coord::camgame draw_pos = pos.to_tile3().to_phys3().to_camgame();
-	this->draw(draw_pos.x, draw_pos.y, mode, false, subid, 0, alpha_texture, alpha_subid);
-}
-
-
 void Texture::draw(coord::pixel_t x, coord::pixel_t y,
                    unsigned int mode, bool mirrored,
                    int subid, unsigned player,
                    Texture *alpha_texture, int alpha_subid) const {
-	glColor4f(1, 1, 1, 1);
-
-	//log::dbg("drawing texture at %hd, %hd", x, y);
+	renderer::sprite_quad quad = this->make_quad(x, y, mode, mirrored, subid, player, alpha_texture, alpha_subid);
+	Engine::get().get_render_commands().sprite(quad);
+}
 
-	bool use_playercolors = false;
-	bool use_alphashader = false;
-	const gamedata::subtexture *mtx;
 
-	int *pos_id, *texcoord_id, *masktexcoord_id;
+renderer::sprite_quad Texture::make_quad(coord::pixel_t x, coord::pixel_t y,
+                                         unsigned int mode, bool mirrored,
+                                         int subid, unsigned player,
+                                         Texture *alpha_texture, int alpha_subid) const {
+	renderer::sprite_quad quad;
+	quad.texture = this->id;
+	quad.mask_texture = 0;
+	quad.player = 0;
+	quad.mtxl = quad.mtxr = quad.mtxt = quad.mtxb = 0;
 
 	// is this texture drawn with an alpha mask?
 	if ((mode & ALPHAMASKED) && alpha_subid >= 0 && alpha_texture != nullptr) {
-		alphamask_shader::program->use();
-
-		// bind the alpha mask texture to slot 1
-		glActiveTexture(GL_TEXTURE1);
-		glEnable(GL_TEXTURE_2D);
-		glBindTexture(GL_TEXTURE_2D, alpha_texture->get_texture_id());
+		quad.program = renderer::sprite_program::alphamask;
+		quad.mask_texture = alpha_texture->get_texture_id();
 
 		// get the alphamask subtexture (the blend mask!)
-		mtx = alpha_texture->get_subtexture(alpha_subid);
-		pos_id = &alphamask_shader::program->pos_id;
-		texcoord_id = &alphamask_shader::base_coord;
-		masktexcoord_id = &alphamask_shader::mask_coord;
-		use_alphashader = true;
+		const gamedata::subtexture *mtx = alpha_texture->get_subtexture(alpha_subid);
+		alpha_texture->get_subtexture_coordinates(mtx, &quad.mtxl, &quad.mtxr, &quad.mtxt, &quad.mtxb);
 	}
 	// is this texure drawn with replaced pixels for team coloring?
 	else if (mode & PLAYERCOLORED) {
-		teamcolor_shader::program->use();
-
-		//set the desired player id in the shader
-		glUniform1i(teamcolor_shader::player_id_var, player);
-		pos_id = &teamcolor_shader::program->pos_id;
-		texcoord_id = &teamcolor_shader::tex_coord;
-		use_playercolors = true;
+		quad.program = renderer::sprite_program::teamcolor;
+		quad.player = player;
 	}
 	// mkay, we just draw the plain texture otherwise.
 	else {
-		texture_shader::program->use();
-		pos_id = &texture_shader::program->pos_id;
-		texcoord_id = &texture_shader::tex_coord;
+		quad.program = renderer::sprite_program::plain;
 	}
 
-	glActiveTexture(GL_TEXTURE0);
-	glEnable(GL_TEXTURE_2D);
-	glBindTexture(GL_TEXTURE_2D, this->id);
-
 	const gamedata::subtexture *tx = this->get_subtexture(subid);
 
 	int left, right, top, bottom;
@@ -258,90 +358,82 @@ void Texture::draw(coord::pixel_t x, coord::pixel_t y,
 		right = left - tx->w;
 	}
 
-	// convert the texture boundaries to float
-	// these will be the vertex coordinates.
-	float leftf, rightf, topf, bottomf;
-	leftf   = (float) left;
-	rightf  = (float) right;
-	topf    = (float) top;
-	bottomf = (float) bottom;
+	// the texture boundaries are the vertex coordinates.
+	quad.left   = (float) left;
+	quad.right  = (float) right;
+	quad.top    = (float) top;
+	quad.bottom = (float) bottom;
 
 	// subtexture coordinates
 	// left, right, top and bottom bounds as coordinates
 	// these pick the requested area out of the big texture.
-	float txl, txr, txt, txb;
-	this->get_subtexture_coordinates(tx, &txl, &txr, &txt, &txb);
+	this->get_subtexture_coordinates(tx, &quad.txl, &quad.txr, &quad.txt, &quad.txb);
 
-	float mtxl=0, mtxr=0, mtxt=0, mtxb=0;
-	if (use_alphashader) {
-		alpha_texture->get_subtexture_coordinates(mtx, &mtxl, &mtxr, &mtxt, &mtxb);
-	}
+	return quad;
+}
 
-	// this array will be uploaded to the GPU.
-	// it contains all dynamic vertex data (position, tex coordinates, mask coordinates)
-	float vdata[] {
-		leftf,  topf,
-		leftf,  bottomf,
-		rightf, bottomf,
-		rightf, topf,
-		txl,    txt,
-		txl,    txb,
-		txr,    txb,
-		txr,    txt,
-		mtxl,   mtxt,
-		mtxl,   mtxb,
-		mtxr,   mtxb,
-		mtxr,   mtxt
-	};
-
-
-	// store vertex buffer data, TODO: prepare this sometime earlier.
-	glBindBuffer(GL_ARRAY_BUFFER, this->vertbuf);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vdata), vdata, GL_STREAM_DRAW);
-
-	// enable vertex buffer and bind it to the vertex attribute
-	glEnableVertexAttribArray(*pos_id);
-	glEnableVertexAttribArray(*texcoord_id);
-	if (use_alphashader) {
-		glEnableVertexAttribArray(*masktexcoord_id);
-	}
 
-	// set data types, offsets in the vdata array
-	glVertexAttribPointer(*pos_id,      2, GL_FLOAT, GL_FALSE, 0, (void *)(0));
-	glVertexAttribPointer(*texcoord_id, 2, GL_FLOAT, GL_FALSE, 0, (void *)(sizeof(float) * 8));
-	if (use_alphashader) {
-		glVertexAttribPointer(*masktexcoord_id, 2, GL_FLOAT, GL_FALSE, 0, (void *)(sizeof(float) * 8 * 2));
-	}
+renderer::terrain_quad Texture::make_terrain_quad(coord::pixel_t x, coord::pixel_t y, int subid) const {
+	renderer::sprite_quad base = this->make_quad(x, y, 0, false, subid, 0, nullptr, -1);
+
+	renderer::terrain_quad quad;
+	quad.texture = base.texture;
+	quad.mask_texture = 0;
+	quad.left   = base.left;
+	quad.right  = base.right;
+	quad.top    = base.top;
+	quad.bottom = base.bottom;
+	quad.txl = base.txl;
+	quad.txr = base.txr;
+	quad.txt = base.txt;
+	quad.txb = base.txb;
+	quad.layer_count = 0;
+	return quad;
+}
 
-	// draw the vertex array
-	glDrawArrays(GL_QUADS, 0, 4);
 
-	// unbind the current buffer
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+bool Texture::add_blend_layer(renderer::terrain_quad *quad, coord::pixel_t x, coord::pixel_t y,
+                              int subid, Texture *alpha_texture, int alpha_subid) const {
+	if (quad->layer_count >= renderer::max_blend_layers or
+	    alpha_texture == nullptr or alpha_subid < 0 or
+	    this->id != quad->texture) {
+		return false;
+	}
 
-	glDisableVertexAttribArray(*pos_id);
-	glDisableVertexAttribArray(*texcoord_id);
-	if (use_alphashader) {
-		glDisableVertexAttribArray(*masktexcoord_id);
+	GLuint mask_texture = alpha_texture->get_texture_id();
+	if (quad->layer_count > 0 and mask_texture != quad->mask_texture) {
+		return false;
 	}
 
-	// disable the shaders.
-	if (use_playercolors) {
-		teamcolor_shader::program->stopusing();
-	} else if (use_alphashader) {
-		alphamask_shader::program->stopusing();
-		glActiveTexture(GL_TEXTURE1);
-		glDisable(GL_TEXTURE_2D);
-	} else {
-		texture_shader::program->stopusing();
+	// the layer has to cover the base tile exactly
+	renderer::sprite_quad layer = this->make_quad(x, y, ALPHAMASKED, false, subid, 0, alpha_texture, alpha_subid);
+	if (layer.left != quad->left or layer.right != quad->right or
+	    layer.top != quad->top or layer.bottom != quad->bottom) {
+		return false;
 	}
 
-	glActiveTexture(GL_TEXTURE0);
-	glDisable(GL_TEXTURE_2D);
+	auto &l = quad->layers[quad->layer_count];
+	l.txl = layer.txl;
+	l.txr = layer.txr;
+	l.txt = layer.txt;
+	l.txb = layer.txb;
+	l.mtxl = layer.mtxl;
+	l.mtxr = layer.mtxr;
+	l.mtxt = layer.mtxt;
+	l.mtxb = layer.mtxb;
+
+	quad->mask_texture = mask_texture;
+	quad->layer_count += 1;
+	return true;
 }
 
 
 const gamedata::subtexture *Texture::get_subtexture(int subid) const {
+	// every subtexture is drawn as the placeholder until loaded
+	if (not this->loaded) {
+		return &this->subtextures[0];
+	}
+
 	if (subid < (ssize_t)this->subtexture_count && subid >= 0) {
 		return &this->subtextures[subid];
 	}
@@ -4,6 +4,8 @@
 #define OPENAGE_TEXTURE_H_
 
 #include "crossplatform/opengl.h"
+#include <memory>
+#include <string>
 #include <vector>
 
 #include "gamedata/texture.gen.h"
@@ -11,9 +13,14 @@
 #include "coord/camhud.h"
 #include "coord/tile.h"
 #include "coord/tile3.h"
+#include "renderer/sprite_batch.h"
+#include "renderer/texture_atlas.h"
 #include "shader/program.h"
 #include "shader/shader.h"
 #include "util/file.h"
+#include "util/mapped_file.h"
+
+struct SDL_Surface;
 
 namespace openage {
 
@@ -33,11 +40,44 @@ extern shader::Program *program;
 extern GLint base_texture, mask_texture, base_coord, mask_coord, show_mask;
 } //namespace alphamask_shader
 
+namespace terrain_blend_shader {
+extern shader::Program *program;
+extern GLint base_texture, mask_texture, base_coord, layer_count;
+extern GLint layer_coord[renderer::max_blend_layers];
+} //namespace terrain_blend_shader
+
 // bitmasks for shader modes
 constexpr int PLAYERCOLORED = 1 << 0;
 constexpr int ALPHAMASKED   = 1 << 1;
 
 
+struct surface_deleter {
+	void operator ()(SDL_Surface *surface) const;
+};
+
+/**
+ * the decoded image and meta file of a texture.
+ * creating it doesn't need gl, so it can be done on worker threads.
+ */
+struct texture_data {
+	/** the image, rows are pitch bytes apart */
+	int w, h;
+	int bytes_per_pixel;
+	int pitch;
+	const void *pixels;
+
+	std::vector<gamedata::subtexture> subtextures;
+	bool has_metafile;
+
+	/** owner of the pixels: a decoded image or a mapped cache file */
+	std::unique_ptr<SDL_Surface, surface_deleter> surface;
+	std::unique_ptr<util::MappedFile> mapping;
+
+	/** size of the decoded image in bytes */
+	size_t image_bytes() const;
+};
+
+
 /**
  * a texture for rendering graphically.
  *
@@ -59,14 +99,81 @@ public:
 	size_t atlas_dimensions;
 
 	Texture(int width, int height, void *data); // single frame rgba8 texture
-	Texture(const std::string &filename, bool use_metafile = false);
+
+	/**
+	 * load a texture from an image file.
+	 * if an atlas is given, the image is placed in it if it fits,
+	 * and the subtexture coordinates are moved to its place.
+	 */
+	Texture(const std::string &filename, bool use_metafile = false, renderer::TextureAtlas *atlas = nullptr);
+
+	/**
+	 * create a texture for an image file that is loaded later,
+	 * by passing its decoded data to upload().
+	 * until then, all subtextures are drawn as the placeholder.
+	 */
+	Texture(const std::string &filename, bool use_metafile, renderer::TextureAtlas *atlas, const Texture *placeholder);
 	~Texture();
 
+	/**
+	 * read an image file and its meta file.
+	 * this doesn't use gl, so it may be called on any thread.
+	 *
+	 * with use_cache, the data is mapped from the texture cache file
+	 * if that is up to date, else the cache is written after decoding.
+	 */
+	static texture_data decode(const std::string &filename, bool use_metafile, bool use_cache = true);
+
+	/**
+	 * upload decoded data to gl and draw it from now on.
+	 */
+	void upload(texture_data &&data);
+
+	/**
+	 * true if the image has been uploaded,
+	 * false while the placeholder is drawn.
+	 */
+	bool is_loaded() const;
+
+	/**
+	 * incremented every time an image is uploaded.
+	 * users that keep subtexture coordinates can compare it
+	 * to notice they are outdated.
+	 */
+	unsigned get_revision() const;
+
+	const std::string &get_filename() const;
+
 	void draw(coord::camhud pos, unsigned int mode = 0, bool mirrored = false, int subid = 0, unsigned player = 0) const;
 	void draw(coord::camgame pos, unsigned int mode = 0, bool mirrored = false, int subid = 0, unsigned player = 0) const;
-	void draw(coord::tile pos, unsigned int mode, int subid, Texture *alpha_texture = nullptr, int alpha_subid = -1) const;
+
+	/**
+	 * record drawing the texture on top of everything drawn before
+	 * in the engine's render commands.
+	 */
 	void draw(coord::pixel_t x, coord::pixel_t y, unsigned int mode, bool mirrored, int subid, unsigned player, Texture *alpha_texture, int alpha_subid) const;
 
+	/**
+	 * create the sprite quad for drawing this texture.
+	 */
+	renderer::sprite_quad make_quad(coord::pixel_t x, coord::pixel_t y, unsigned int mode, bool mirrored, int subid, unsigned player, Texture *alpha_texture, int alpha_subid) const;
+
+	/**
+	 * create a terrain quad for drawing a tile of this texture,
+	 * without any blending layers yet.
+	 */
+	renderer::terrain_quad make_terrain_quad(coord::pixel_t x, coord::pixel_t y, int subid) const;
+
+	/**
+	 * add a subtexture masked by a blending mask as next layer
+	 * of a terrain quad created for the same position.
+	 *
+	 * @returns false if the layer can't be drawn in the same pass:
+	 * the quad is full, the layer is on another texture (atlas page)
+	 * than the base or the other masks, or its size differs.
+	 */
+	bool add_blend_layer(renderer::terrain_quad *quad, coord::pixel_t x, coord::pixel_t y, int subid, Texture *alpha_texture, int alpha_subid) const;
+
 	void reload();
 
 	const struct gamedata::subtexture *get_subtexture(int subid) const;
@@ -106,15 +213,30 @@ public:
 	GLuint get_texture_id() const;
 
 private:
-	GLuint id, vertbuf;
+	GLuint id;
 	std::vector<gamedata::subtexture>subtextures;
 	size_t subtexture_count;
 	bool use_metafile;
 
+	/**
+	 * the atlas to place the image in, or nullptr.
+	 */
+	renderer::TextureAtlas *atlas;
+
+	/**
+	 * true if the image is stored in atlas_slot,
+	 * then the gl texture is owned by the atlas.
+	 */
+	bool in_atlas;
+	renderer::atlas_slot atlas_slot;
+
+	bool loaded;
+	unsigned revision;
+
 	std::string filename;
 
 	void load();
-	GLuint make_gl_texture(int iformat, int oformat, int w, int h, void *);
+	GLuint make_gl_texture(int iformat, int oformat, int w, int h, const void *);
 	void unload();
 };
 
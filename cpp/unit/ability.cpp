@@ -1,7 +1,6 @@
 // Copyright 2014-2014 the openage authors. See copying.md for legal info.
 
 #include "../terrain/terrain_object.h"
-#include "../util/unique.h"
 #include "ability.h"
 #include "action.h"
 #include "unit.h"
@@ -22,16 +21,16 @@ bool MoveAbility::can_target(Unit *, Unit *) {
 	return false;
 }
 
-std::unique_ptr<UnitAction> MoveAbility::target(Unit *to_modify, coord::phys3 target) {
-	return util::make_unique<MoveAction>(to_modify, this->tex,
-	                                     this->sound, target);
+action_ptr MoveAbility::target(Unit *to_modify, coord::phys3 target) {
+	return ActionPool<MoveAction>::create(to_modify, this->tex,
+	                                      this->sound, target);
 }
 
-std::unique_ptr<UnitAction> MoveAbility::target(Unit *to_modify, Unit *target) {
+action_ptr MoveAbility::target(Unit *to_modify, Unit *target) {
 	coord::phys_t radius = (path::path_grid_size * 2) + to_modify->location->min_axis() / 2;
-	return util::make_unique<MoveAction>(to_modify, this->tex,
-	                                     nullptr, target->get_ref(),
-	                                     radius);
+	return ActionPool<MoveAction>::create(to_modify, this->tex,
+	                                      nullptr, target->get_ref(),
+	                                      radius);
 }
 
 GatherAbility::GatherAbility(Texture *t, TestSound *s)
@@ -48,13 +47,13 @@ bool GatherAbility::can_target(Unit *u1, Unit *target) {
 	return u1 != target;
 }
 
-std::unique_ptr<UnitAction> GatherAbility::target(Unit *, coord::phys3) {
+action_ptr GatherAbility::target(Unit *, coord::phys3) {
 	return nullptr;
 }
 
-std::unique_ptr<UnitAction> GatherAbility::target(Unit *to_modify, Unit *target) {
-	return util::make_unique<GatherAction>(to_modify, target->get_ref(),
-	                                                this->tex, this->sound);
+action_ptr GatherAbility::target(Unit *to_modify, Unit *target) {
+	return ActionPool<GatherAction>::create(to_modify, target->get_ref(),
+	                                        this->tex, this->sound);
 }
 
 AttackAbility::AttackAbility(Texture *t, TestSound *s)
@@ -74,13 +73,13 @@ bool AttackAbility::can_target(Unit *u1, Unit *target) {
 	       target->get_attribute<attr_type::hitpoints>().current > 0;
 }
 
-std::unique_ptr<UnitAction> AttackAbility::target(Unit *, coord::phys3) {
+action_ptr AttackAbility::target(Unit *, coord::phys3) {
 	return nullptr;
 }
 
-std::unique_ptr<UnitAction> AttackAbility::target(Unit *to_modify, Unit *target) {
-	return util::make_unique<AttackAction>(to_modify, target->get_ref(),
-	                                                 this->tex, this->sound);
+action_ptr AttackAbility::target(Unit *to_modify, Unit *target) {
+	return ActionPool<AttackAction>::create(to_modify, target->get_ref(),
+	                                        this->tex, this->sound);
 }
 
 } /* namespace openage */
@@ -7,6 +7,7 @@
 #include <memory>
 
 #include "../coord/phys3.h"
+#include "action_pool.h"
 
 namespace openage {
 
@@ -44,8 +45,8 @@ public:
 	virtual bool can_target(Unit *u1, coord::phys3 target) = 0;
 	virtual bool can_target(Unit *u1, Unit *target) = 0;
 
-	virtual std::unique_ptr<UnitAction> target(Unit *to_modify, coord::phys3 target) = 0;
-	virtual std::unique_ptr<UnitAction> target(Unit *to_modify, Unit *target) = 0;
+	virtual action_ptr target(Unit *to_modify, coord::phys3 target) = 0;
+	virtual action_ptr target(Unit *to_modify, Unit *target) = 0;
 };
 
 /*
@@ -62,8 +63,8 @@ public:
 	bool can_target(Unit *u1, coord::phys3 target);
 	bool can_target(Unit *u1, Unit *target);
 
-	std::unique_ptr<UnitAction> target(Unit *to_modify, coord::phys3 target) override;
-	std::unique_ptr<UnitAction> target(Unit *to_modify, Unit *target) override;
+	action_ptr target(Unit *to_modify, coord::phys3 target) override;
+	action_ptr target(Unit *to_modify, Unit *target) override;
 
 private:
 	Texture *tex;
@@ -84,8 +85,8 @@ public:
 	bool can_target(Unit *u1, coord::phys3 target);
 	bool can_target(Unit *u1, Unit *target);
 
-	std::unique_ptr<UnitAction> target(Unit *to_modify, coord::phys3 target) override;
-	std::unique_ptr<UnitAction> target(Unit *to_modify, Unit *target) override;
+	action_ptr target(Unit *to_modify, coord::phys3 target) override;
+	action_ptr target(Unit *to_modify, Unit *target) override;
 
 private:
 	Texture *tex;
@@ -106,8 +107,8 @@ public:
 	bool can_target(Unit *u1, coord::phys3 target);
 	bool can_target(Unit *u1, Unit *target);
 
-	std::unique_ptr<UnitAction> target(Unit *to_modify, coord::phys3 target) override;
-	std::unique_ptr<UnitAction> target(Unit *to_modify, Unit *target) override;
+	action_ptr target(Unit *to_modify, coord::phys3 target) override;
+	action_ptr target(Unit *to_modify, Unit *target) override;
 
 private:
 	Texture *tex;
@@ -2,14 +2,20 @@
 
 #include <cmath>
 
+#include "../engine.h"
 #include "../game_main.h"
 #include "../pathfinding/a_star.h"
 #include "../pathfinding/heuristics.h"
+#include "../terrain/terrain.h"
 #include "action.h"
 #include "unit.h"
 
 namespace openage {
 
+void ActionDeleter::operator()(UnitAction *action) const {
+	action->release_fn(action);
+}
+
 bool UnitAction::show_debug = false;
 
 UnitAction::UnitAction(Unit *u, Texture *t, TestSound *s, float fr)
@@ -18,15 +24,17 @@ UnitAction::UnitAction(Unit *u, Texture *t, TestSound *s, float fr)
 	tex{t},
 	on_begin{s},
 	frame{.0f},
-	frame_rate{fr} {}
+	frame_rate{fr},
+	release_fn{nullptr} {}
 
 void UnitAction::draw() {
 	// play sound if available
 	if (this->on_begin && this->frame == 0.0f) {
-		on_begin->play();
+		on_begin->play(this->entity->location->pos.draw);
 	}
 
-	coord::phys3 &draw_pos = this->entity->location->pos.draw;
+	Engine &engine = Engine::get();
+	coord::phys3 draw_pos = this->entity->location->interpolated_pos(engine.simulation_tick_fraction());
 	unsigned color = 0;
 	if (this->entity->has_attribute(attr_type::color)) {
 		auto &c_attr = this->entity->get_attribute<attr_type::color>();
@@ -60,7 +68,7 @@ void UnitAction::draw() {
 	this->frame += this->frame_rate;
 
 	// draw debug content if available
-	if(show_debug && debug_draw_action) debug_draw_action();
+	if (show_debug) this->draw_debug();
 }
 
 void DeadAction::update(unsigned int) {
@@ -80,13 +88,12 @@ MoveAction::MoveAction(Unit *e, Texture *t, TestSound *s, coord::phys3 tar, bool
 	unit_target{},
 	target(tar),
 	radius{7500},
-	allow_repath{repath} {
+	allow_repath{repath},
+	move_pending{false},
+	repath_pending{false} {
 
 	// set an initial path
 	this->set_path();
-	this->debug_draw_action = [&]() {
-		this->path.draw_path();
-	};
 }
 
 MoveAction::MoveAction(Unit *e, Texture *t, TestSound *s, UnitReference tar, coord::phys_t rad)
@@ -95,18 +102,26 @@ MoveAction::MoveAction(Unit *e, Texture *t, TestSound *s, UnitReference tar, coo
 	unit_target{tar},
 	target(tar.get()->location->pos.draw),
 	radius{rad},
-	allow_repath{false} {
+	allow_repath{false},
+	move_pending{false},
+	repath_pending{false} {
 
 	// set an initial path
 	this->set_path();
-	this->debug_draw_action = [&]() {
-		this->path.draw_path();
-	};
 }
 
 MoveAction::~MoveAction() {}
 
+void MoveAction::draw_debug() {
+	this->path.draw_path();
+}
+
 void MoveAction::update(unsigned int time) {
+	if (this->repath_pending) {
+		this->repath_pending = false;
+		this->set_path();
+	}
+
 	if (this->unit_target.is_valid()) {
 		coord::phys3 &target_pos = this->unit_target.get()->location->pos.draw;
 		coord::phys3 &unit_pos = this->entity->location->pos.draw;
@@ -131,8 +146,7 @@ void MoveAction::update(unsigned int time) {
 
 	// current position and direction
 	coord::phys3 new_position = this->entity->location->pos.draw;
-	auto &d_attr = this->entity->get_attribute<attr_type::direction>();
-	coord::phys3_delta new_direction = d_attr.unit_dir;
+	coord::phys3_delta new_direction = this->entity->get_attribute<attr_type::direction>().unit_dir;
 
 	while (distance_to_move > 0) {
 		if (this->path.waypoints.empty()) {
@@ -166,17 +180,30 @@ void MoveAction::update(unsigned int time) {
 			break;
 		}
 	}
-	
+
+	// the move itself changes the terrain, so it is done in apply
+	this->move_pending = true;
+	this->pending_position = new_position;
+	this->pending_direction = new_direction;
+}
+
+void MoveAction::apply() {
+	if (!this->move_pending) {
+		return;
+	}
+	this->move_pending = false;
+
 	// check move collisions
-	bool move_completed = this->entity->location->move(new_position);
+	bool move_completed = this->entity->location->move(this->pending_position);
 	if (move_completed) {
-		d_attr.unit_dir = new_direction;
+		auto &d_attr = this->entity->get_attribute<attr_type::direction>();
+		d_attr.unit_dir = this->pending_direction;
 	}
 	else {
 		// cases for modifying path when blocked
 		if (this->allow_repath) {
 			log::dbg("path blocked -- finding new path");
-			this->set_path();
+			this->repath_pending = true;
 		}
 		else {
 			log::dbg("path blocked -- drop action");
@@ -245,7 +272,13 @@ void GatherAction::update(unsigned int time) {
 	if (!this->target.is_valid()) return;
 	if (carrying > 10) {
 		auto move_ability = this->entity->get_ability(ability_type::move);
-		this->entity->push_action(move_ability->target(this->entity, coord::phys3{0, 0, 0}));
+		Unit *dropsite = this->nearest_dropsite();
+		if (dropsite) {
+			this->entity->push_action(move_ability->target(this->entity, dropsite));
+		}
+		else {
+			this->entity->push_action(move_ability->target(this->entity, coord::phys3{0, 0, 0}));
+		}
 		carrying = 0;
 	}
 
@@ -266,6 +299,21 @@ void GatherAction::update(unsigned int time) {
 	carrying += 0.01 * time;
 }
 
+Unit *GatherAction::nearest_dropsite() {
+	// created once, the first call is thread safe
+	static const object_filter is_dropsite = with_attribute(attr_type::dropsite);
+
+	TerrainObject *location = this->entity->location;
+	location->get_terrain()->proximity.nearest(location->pos.draw, 1,
+	                                           dropsite_search_radius,
+	                                           is_dropsite,
+	                                           this->found_dropsites);
+	if (this->found_dropsites.empty()) {
+		return nullptr;
+	}
+	return this->found_dropsites[0]->unit;
+}
+
 bool GatherAction::completed() {
 	if (!this->target.is_valid()) return true;
 	return false;
@@ -7,11 +7,18 @@
 #include <vector>
 
 #include "../pathfinding/path.h"
+#include "action_pool.h"
 #include "unit_container.h"
 
 namespace openage {
 
+/**
+ * how far gatherers look for a place to drop their resources
+ */
+constexpr coord::phys_t dropsite_search_radius = coord::settings::phys_per_tile * 64;
+
 class Texture;
+class TerrainObject;
 class TestSound;
 class Unit;
 
@@ -38,6 +45,12 @@ public:
 	 */
 	virtual void update(unsigned int) = 0;
 
+	/**
+	 * applies changes to shared state that were computed by update,
+	 * called serially in unit id order after all units have been updated
+	 */
+	virtual void apply() {}
+
 	/**
 	 *	gets called for all actions on stack each update cycle
 	 *	@return true when action is completed so it and everything above it can be popped
@@ -54,6 +67,17 @@ public:
 	 */
 	virtual bool allow_destruction() = 0;
 
+	/**
+	 * whether update has to be called for this action on every tick,
+	 * a unit whose active action is not time dependent can sleep
+	 */
+	virtual bool time_dependent() { return true; }
+
+	/**
+	 * additional drawing for debug purposes
+	 */
+	virtual void draw_debug() {}
+
 	static bool show_debug;
 
 protected:
@@ -70,10 +94,14 @@ protected:
 	float frame;
 	float frame_rate;
 
+private:
+	template<class T> friend class ActionPool;
+	friend struct ActionDeleter;
+
 	/**
-	 * additional drawing for debug purposes
+	 * returns this action to the pool it was created from
 	 */
-	std::function<void(void)> debug_draw_action;
+	void (*release_fn)(UnitAction *);
 };
 
 /**
@@ -106,6 +134,7 @@ public:
 	bool completed() { return false; }
 	bool allow_interupt() { return false; }
 	bool allow_destruction() { return true; }
+	bool time_dependent() { return false; }
 };
 
 /**
@@ -125,9 +154,11 @@ public:
 	virtual ~MoveAction();
 
 	void update(unsigned int);
+	void apply();
 	bool completed();
 	bool allow_interupt() { return true; }
 	bool allow_destruction() { return false; }
+	void draw_debug();
 	coord::phys3 next_waypoint() const;
 
 private:
@@ -139,6 +170,14 @@ private:
 	// should a new path be found if unit gets blocked
 	bool allow_repath;
 
+	// the move computed by update, performed in apply
+	bool move_pending;
+	coord::phys3 pending_position;
+	coord::phys3_delta pending_direction;
+
+	// the last move was blocked, find a new path on the next update
+	bool repath_pending;
+
 	void set_path();
 };
 
@@ -159,6 +198,18 @@ private:
 	UnitReference target;
 	coord::phys_t distance_to_target, range;
 	float carrying;
+
+	/**
+	 * the search result of nearest_dropsite, kept so searching
+	 * during the parallel update doesn't allocate
+	 */
+	std::vector<TerrainObject *> found_dropsites;
+
+	/**
+	 * the closest object to drop the carried resources at,
+	 * null if there is none nearby
+	 */
+	Unit *nearest_dropsite();
 };
 
 /**
@@ -0,0 +1,98 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#ifndef OPENAGE_UNIT_ACTION_POOL_H_
+#define OPENAGE_UNIT_ACTION_POOL_H_
+
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+
+#include "../util/block_allocator.h"
+
+namespace openage {
+
+class UnitAction;
+
+/**
+ * returns an action to the pool it was created from
+ */
+struct ActionDeleter {
+	void operator()(UnitAction *action) const;
+};
+
+/**
+ * owning pointer to an action, which was created by an ActionPool
+ */
+using action_ptr = std::unique_ptr<UnitAction, ActionDeleter>;
+
+/**
+ * storage for all actions of one type
+ *
+ * every order given to a unit creates new actions, so they are
+ * taken from a block allocator instead of the heap.
+ * units create actions while they are updated in parallel,
+ * so the allocator is guarded by a lock.
+ */
+template<class T>
+class ActionPool {
+public:
+	/**
+	 * creates an action of type T, initialized with T(...vargs)
+	 */
+	template<class... Args>
+	static action_ptr create(Args&&... vargs) {
+		ActionPool<T> &pool = ActionPool<T>::get();
+		T *memory = pool.take();
+
+		T *action;
+		try {
+			action = new(memory) T(std::forward<Args>(vargs)...);
+		}
+		catch (...) {
+			pool.give_back(memory);
+			throw;
+		}
+
+		action->release_fn = &ActionPool<T>::release;
+		return action_ptr{action};
+	}
+
+private:
+	// actions per allocator block
+	ActionPool()
+		:
+		allocator{64} {
+	}
+
+	static ActionPool<T> &get() {
+		static ActionPool<T> instance;
+		return instance;
+	}
+
+	/**
+	 * destroys the action and returns its memory to the pool
+	 */
+	static void release(UnitAction *action) {
+		T *typed = static_cast<T *>(action);
+		typed->~T();
+		ActionPool<T>::get().give_back(typed);
+	}
+
+	T *take() {
+		std::lock_guard<std::mutex> lock{this->mtx};
+		return this->allocator.get_ptr();
+	}
+
+	void give_back(T *memory) {
+		std::lock_guard<std::mutex> lock{this->mtx};
+		this->allocator.release(memory);
+	}
+
+	std::mutex mtx;
+	util::block_allocator<T> allocator;
+};
+
+} // namespace openage
+
+#endif
@@ -0,0 +1,51 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#include <algorithm>
+
+#include "action.h"
+#include "action_stack.h"
+
+namespace openage {
+
+ActionStack::ActionStack()
+	:
+	count{0} {
+}
+
+ActionStack::~ActionStack() {
+	this->clear();
+}
+
+bool ActionStack::push_back(action_ptr action) {
+	if (this->count >= capacity) {
+		iterator oldest = std::find_if(this->begin(), this->end(),
+			[](action_ptr &a) {
+				return a->allow_interupt();
+			});
+		if (oldest == this->end()) {
+			return false;
+		}
+		this->erase(oldest, oldest + 1);
+	}
+	this->actions[this->count] = std::move(action);
+	this->count += 1;
+	return true;
+}
+
+void ActionStack::erase(iterator first, iterator last) {
+	iterator new_end = std::move(last, this->end(), first);
+	for (iterator it = new_end; it != this->end(); ++it) {
+		it->reset();
+	}
+	this->count = new_end - this->begin();
+}
+
+void ActionStack::clear() {
+	// release from the top, like popping one by one
+	while (this->count > 0) {
+		this->count -= 1;
+		this->actions[this->count].reset();
+	}
+}
+
+} // namespace openage
@@ -0,0 +1,87 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#ifndef OPENAGE_UNIT_ACTION_STACK_H_
+#define OPENAGE_UNIT_ACTION_STACK_H_
+
+#include <stddef.h>
+
+#include "action_pool.h"
+
+namespace openage {
+
+/**
+ * the stack of actions of a unit, stored inside the unit itself.
+ *
+ * the deepest stacks that occur are the dead and idle actions at the
+ * bottom, a task like gathering and a move towards the task's target,
+ * so a small fixed capacity is enough and no memory is allocated
+ * for pushing or popping.
+ *
+ * pushing happens while units are updated in parallel, so a full
+ * stack does not fail: it drops the oldest interruptible action,
+ * or the new one if none can be interrupted.
+ */
+class ActionStack {
+public:
+	using iterator = action_ptr *;
+
+	/**
+	 * maximum number of actions on the stack
+	 */
+	static constexpr size_t capacity = 8;
+
+	ActionStack();
+	~ActionStack();
+
+	ActionStack(const ActionStack &) = delete;
+	ActionStack &operator=(const ActionStack &) = delete;
+
+	bool empty() const {
+		return this->count == 0;
+	}
+
+	size_t size() const {
+		return this->count;
+	}
+
+	iterator begin() {
+		return &this->actions[0];
+	}
+
+	iterator end() {
+		return &this->actions[this->count];
+	}
+
+	/**
+	 * the active action, the stack must not be empty
+	 */
+	UnitAction *back() const {
+		return this->actions[this->count - 1].get();
+	}
+
+	/**
+	 * adds an action on top. when the stack is full, the bottom-most
+	 * interruptible action is released to make room.
+	 * @return false if the stack was full without interruptible actions,
+	 * the new action is released then
+	 */
+	bool push_back(action_ptr action);
+
+	/**
+	 * releases the actions in [first, last), the actions above are moved down
+	 */
+	void erase(iterator first, iterator last);
+
+	/**
+	 * releases all actions
+	 */
+	void clear();
+
+private:
+	action_ptr actions[capacity];
+	size_t count;
+};
+
+} // namespace openage
+
+#endif
@@ -62,9 +62,9 @@ void UnitTypeTest::initialise(Unit *unit) {
 	/*
 	 * Initial action stack
 	 */
-	unit->push_action( util::make_unique<DeadAction>( unit, this->dead,
-	                                                  this->on_destroy ) );
-	unit->push_action( util::make_unique<IdleAction>( unit, this->idle ) );
+	unit->push_action( ActionPool<DeadAction>::create( unit, this->dead,
+	                                                   this->on_destroy ) );
+	unit->push_action( ActionPool<IdleAction>::create( unit, this->idle ) );
 
 	unit->give_ability( util::make_unique<MoveAbility>( this->moving, this->on_move )  );
 	unit->give_ability( util::make_unique<AttackAbility>( this->attacking, this->on_attack )  );
@@ -111,7 +111,7 @@ bool UnitTypeTest::place(Unit *unit, Terrain *terrain, coord::tile init_tile) {
 	coord::phys3 init_pos = init_tile.to_phys2().to_phys3();
 	bool obj_placed = unit->location->place(terrain, init_pos);
 	if (obj_placed) {
-		this->on_create->play();
+		this->on_create->play(init_pos);
 	}
 	return obj_placed;
 }
@@ -142,9 +142,9 @@ void BuldingProducer::initialise(Unit *unit) {
 	unit->add_attribute(new Attribute<attr_type::color>(util::random_range(1, 8 + 1)));
 	unit->add_attribute(new Attribute<attr_type::dropsite>());
 
-	unit->push_action( util::make_unique<DeadAction>(unit, this->texture,
-	                                                 this->on_destroy));
-	unit->push_action( util::make_unique<IdleAction>(unit, this->texture));
+	unit->push_action( ActionPool<DeadAction>::create(unit, this->texture,
+	                                                  this->on_destroy));
+	unit->push_action( ActionPool<IdleAction>::create(unit, this->texture));
 }
 
 bool BuldingProducer::place(Unit *unit, Terrain *terrain, coord::tile init_tile) {
@@ -172,7 +172,7 @@ bool BuldingProducer::place(Unit *unit, Terrain *terrain, coord::tile init_tile)
 	coord::phys3 init_pos = init_tile.to_phys2().to_phys3();
 	bool obj_placed = unit->location->place(terrain, init_pos);
 	if (obj_placed) {
-		this->on_create->play();
+		this->on_create->play(init_pos);
 
 		if (this->foundation_terrain > 0) {
 			// TODO: use the gamedata terrain lookup!
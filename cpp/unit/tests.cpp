@@ -0,0 +1,260 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#include <memory>
+#include <set>
+#include <vector>
+
+#include "../job/job_manager.h"
+#include "../log.h"
+#include "../terrain/terrain_object.h"
+#include "action.h"
+#include "action_pool.h"
+#include "action_stack.h"
+#include "producer.h"
+#include "unit.h"
+#include "unit_container.h"
+
+namespace openage {
+namespace unit {
+namespace tests {
+
+namespace {
+
+/**
+ * idle units which are not placed on a terrain
+ */
+class IdleProducer: public UnitProducer {
+public:
+	void initialise(Unit *unit) {
+		unit->push_action(ActionPool<IdleAction>::create(unit, nullptr));
+	}
+
+	bool place(Unit *unit, Terrain *, coord::tile) {
+		auto pass = [](const coord::phys3 &) { return true; };
+		this->locations.emplace_back(new RadialObject{unit, pass, 0.5f, nullptr});
+		unit->location = this->locations.back().get();
+		return true;
+	}
+
+	Texture *default_texture() {
+		return nullptr;
+	}
+
+	std::vector<std::unique_ptr<TerrainObject>> locations;
+};
+
+/**
+ * needs an update on the given number of ticks, counting them
+ */
+class CountdownAction: public UnitAction {
+public:
+	CountdownAction(Unit *e, unsigned int ticks, unsigned int *updates)
+		:
+		UnitAction(e, nullptr),
+		remaining{ticks},
+		updates{updates} {}
+
+	void update(unsigned int) {
+		this->remaining -= 1;
+		*this->updates += 1;
+	}
+	bool completed() { return this->remaining == 0; }
+	bool allow_interupt() { return true; }
+	bool allow_destruction() { return true; }
+
+private:
+	unsigned int remaining;
+	unsigned int *updates;
+};
+
+/**
+ * records its tag when it is released
+ */
+class TaggedAction: public UnitAction {
+public:
+	TaggedAction(int tag, bool interruptible, std::vector<int> *released)
+		:
+		UnitAction(nullptr, nullptr),
+		tag{tag},
+		interruptible{interruptible},
+		released{released} {}
+
+	virtual ~TaggedAction() {
+		this->released->push_back(this->tag);
+	}
+
+	void update(unsigned int) {}
+	bool completed() { return false; }
+	bool allow_interupt() { return this->interruptible; }
+	bool allow_destruction() { return true; }
+
+	const int tag;
+
+private:
+	bool interruptible;
+	std::vector<int> *released;
+};
+
+/**
+ * the tags of the actions on the stack, bottom first
+ */
+std::vector<int> tags(ActionStack &stack) {
+	std::vector<int> result;
+	for (action_ptr &action : stack) {
+		result.push_back(static_cast<TaggedAction *>(action.get())->tag);
+	}
+	return result;
+}
+
+} // anon namespace
+
+void action_pool() {
+	int stage = 0;
+	std::vector<int> released;
+	std::vector<action_ptr> actions;
+	std::set<UnitAction *> taken;
+
+	// blocks hold 64 actions, and the allocator appends the next block
+	// as soon as one is full, so stay below that.
+	for (int i = 0; i < 63; i++) {
+		actions.push_back(ActionPool<TaggedAction>::create(i, true, &released));
+		taken.insert(actions.back().get());
+	}
+	if (taken.size() != 63) { goto out; }
+	stage += 1;
+
+	actions.clear();
+	if (released.size() != 63) { goto out; }
+	stage += 1;
+
+	// released memory is handed out again instead of a new block
+	for (int round = 0; round < 100; round++) {
+		for (int i = 0; i < 63; i++) {
+			actions.push_back(ActionPool<TaggedAction>::create(i, true, &released));
+			if (taken.count(actions.back().get()) == 0) { goto out; }
+		}
+		actions.clear();
+	}
+	return;
+
+out:
+	log::err("action pool test failed at stage %d", stage);
+	throw "action pool test failed";
+}
+
+void action_stack() {
+	int stage = 0;
+	std::vector<int> released;
+	ActionStack stack;
+
+	auto push = [&](int tag, bool interruptible) {
+		return stack.push_back(ActionPool<TaggedAction>::create(tag, interruptible, &released));
+	};
+
+	push(0, false);
+	push(1, true);
+	push(2, true);
+	if (tags(stack) != std::vector<int>{0, 1, 2}) { goto out; }
+	if (static_cast<TaggedAction *>(stack.back())->tag != 2) { goto out; }
+	stage += 1;
+
+	// pop the top
+	stack.erase(stack.end() - 1, stack.end());
+	if (tags(stack) != std::vector<int>{0, 1}) { goto out; }
+	if (released != std::vector<int>{2}) { goto out; }
+	stage += 1;
+
+	// erasing from the middle keeps the order of the actions above
+	push(3, true);
+	push(4, true);
+	stack.erase(stack.begin() + 1, stack.begin() + 2);
+	if (tags(stack) != std::vector<int>{0, 3, 4}) { goto out; }
+	if (released != std::vector<int>{2, 1}) { goto out; }
+	stage += 1;
+
+	// a full stack drops its bottom-most interruptible action
+	for (int i = 5; i < 10; i++) {
+		push(i, false);
+	}
+	if (stack.size() != ActionStack::capacity) { goto out; }
+	if (not push(10, false)) { goto out; }
+	if (tags(stack) != std::vector<int>{0, 4, 5, 6, 7, 8, 9, 10}) { goto out; }
+	if (released != std::vector<int>{2, 1, 3}) { goto out; }
+	if (not push(11, false)) { goto out; }
+	if (tags(stack) != std::vector<int>{0, 5, 6, 7, 8, 9, 10, 11}) { goto out; }
+	stage += 1;
+
+	// without interruptible actions, the new one is dropped
+	if (push(12, true)) { goto out; }
+	if (tags(stack) != std::vector<int>{0, 5, 6, 7, 8, 9, 10, 11}) { goto out; }
+	if (released != std::vector<int>{2, 1, 3, 4, 12}) { goto out; }
+	stage += 1;
+
+	// clearing releases from the top
+	released.clear();
+	stack.clear();
+	if (not stack.empty()) { goto out; }
+	if (released != std::vector<int>{11, 10, 9, 8, 7, 6, 5, 0}) { goto out; }
+	return;
+
+out:
+	log::err("action stack test failed at stage %d", stage);
+	throw "action stack test failed";
+}
+
+void sleep_wake() {
+	int stage = 0;
+	IdleProducer producer;
+	UnitContainer container;
+	job::JobManager jobs{2};
+	unsigned int updates = 0;
+	jobs.start();
+
+	for (int i = 0; i < 3; i++) {
+		container.new_unit(producer, nullptr, coord::tile{0, 0});
+	}
+	if (container.active_count() != 3) { goto out; }
+	stage += 1;
+
+	// idle units are no longer updated after their first tick
+	container.update_units(50, &jobs);
+	if (container.active_count() != 0) { goto out; }
+	container.update_units(50, &jobs);
+	if (container.active_count() != 0) { goto out; }
+	stage += 1;
+
+	// a new action wakes the unit until only the idle action is left
+	container.get_unit(1).get()->push_action(
+		ActionPool<CountdownAction>::create(container.get_unit(1).get(), 3, &updates));
+	container.update_units(50, &jobs);
+	if (container.active_count() != 1 or updates != 1) { goto out; }
+	container.update_units(50, &jobs);
+	container.update_units(50, &jobs);
+	if (container.active_count() != 0 or updates != 3) { goto out; }
+	container.update_units(50, &jobs);
+	if (updates != 3) { goto out; }
+	stage += 1;
+
+	// deleting wakes the unit so it can be removed
+	container.get_unit(2).get()->delete_unit();
+	container.update_units(50, &jobs);
+	if (container.valid_id(2) or container.active_count() != 0) { goto out; }
+	if (not container.valid_id(0) or not container.valid_id(1)) { goto out; }
+	stage += 1;
+
+	// the remaining units still sleep
+	container.update_units(50, &jobs);
+	if (container.active_count() != 0) { goto out; }
+
+	jobs.stop();
+	return;
+
+out:
+	jobs.stop();
+	log::err("unit sleep test failed at stage %d", stage);
+	throw "unit sleep test failed";
+}
+
+} // namespace tests
+} // namespace unit
+} // namespace openage
@@ -4,7 +4,6 @@
 #include <cmath>
 
 #include "../terrain/terrain.h"
-#include "../engine.h"
 #include "ability.h"
 #include "action.h"
 #include "producer.h"
@@ -17,6 +16,8 @@ Unit::Unit(UnitContainer *c, id_t id)
 	id{id},
 	location{nullptr},
 	pop_destructables{false},
+	updated_action{nullptr},
+	sleeping{false},
 	container{c} {
 
 }
@@ -27,7 +28,9 @@ bool Unit::has_action() {
 	return !this->action_stack.empty();
 }
 
-bool Unit::update() {
+bool Unit::update(unsigned int time) {
+	this->updated_action = nullptr;
+
 	// if unit is not on the map then do nothing
 	if (!this->location) {
 		return true;
@@ -37,7 +40,7 @@ bool Unit::update() {
 		auto position_it = std::find_if(
 			std::begin(this->action_stack),
 			std::end(this->action_stack),
-			[](std::unique_ptr<UnitAction> &e) {
+			[](action_ptr &e) {
 				return e->allow_destruction();
 			});
 		this->action_stack.erase(position_it, std::end(this->action_stack));
@@ -47,8 +50,20 @@ bool Unit::update() {
 	 * the active action is on top
 	 */
 	if (this->has_action()) {
-		Engine &engine = Engine::get();
-		this->action_stack.back()->update(engine.lastframe_msec());
+		this->updated_action = this->action_stack.back();
+		this->updated_action->update(time);
+	}
+	return true;
+}
+
+bool Unit::apply() {
+	if (this->location) {
+		this->location->begin_tick();
+	}
+
+	if (this->updated_action) {
+		this->updated_action->apply();
+		this->updated_action = nullptr;
 
 		/*
 		 * check completion of all actions,
@@ -57,7 +72,7 @@ bool Unit::update() {
 		auto position_it = std::find_if(
 			std::begin(this->action_stack),
 			std::end(this->action_stack),
-			[](std::unique_ptr<UnitAction> &e) {
+			[](action_ptr &e) {
 				return e->completed();
 			});
 		this->action_stack.erase(position_it, std::end(this->action_stack));
@@ -65,6 +80,21 @@ bool Unit::update() {
 	return true;
 }
 
+bool Unit::can_sleep() {
+	if (this->pop_destructables || !this->has_action()) {
+		return false;
+	}
+	if (this->action_stack.back()->time_dependent()) {
+		return false;
+	}
+
+	// the drawing position is still interpolated towards the last move
+	if (this->location && !(this->location->last_tick_pos == this->location->pos.draw)) {
+		return false;
+	}
+	return true;
+}
+
 bool Unit::draw() {
 	// dont draw if theres no actions, or unit is not on the map
 	if (this->action_stack.empty() || !this->location) return true;
@@ -88,8 +118,11 @@ UnitAbility *Unit::get_ability(ability_type type) {
 	return nullptr;
 }
 
-void Unit::push_action(std::unique_ptr<UnitAction> action) {
+void Unit::push_action(action_ptr action) {
 	this->action_stack.push_back(std::move(action));
+	if (this->container) {
+		this->container->wake(this);
+	}
 }
 
 void Unit::add_attribute(AttributeContainer *attr) {
@@ -126,6 +159,9 @@ bool Unit::target(Unit *target, ability_set type) {
 
 void Unit::delete_unit() {
 	pop_destructables = true;
+	if (this->container) {
+		this->container->wake(this);
+	}
 }
 
 void Unit::erase_interuptables() {
@@ -135,7 +171,7 @@ void Unit::erase_interuptables() {
 	auto position_it = std::find_if(
 		std::begin(this->action_stack),
 		std::end(this->action_stack),
-		[](std::unique_ptr<UnitAction> &e) {
+		[](action_ptr &e) {
 			return e->allow_interupt();
 		});
 	this->action_stack.erase(position_it, std::end(this->action_stack));
@@ -10,6 +10,7 @@
 #include "../coord/phys3.h"
 #include "../handlers.h"
 #include "ability.h"
+#include "action_stack.h"
 #include "attribute.h"
 #include "unit_container.h"
 
@@ -25,6 +26,7 @@ class UnitAction;
  * name as GameObject
  */
 class Unit {
+	friend class UnitContainer;
 public:
 	Unit(UnitContainer *c, id_t id);
 	virtual ~Unit();
@@ -48,8 +50,28 @@ public:
 
 	/**
 	 * update this object using the action currently on top of the stack
+	 *
+	 * this is the parallel phase of a tick: it may run concurrently with
+	 * the update of other units, so it must only modify this unit,
+	 * changes to shared state are deferred to apply()
+	 *
+	 * @param time the simulated time in ms
+	 */
+	bool update(unsigned int time);
+
+	/**
+	 * the serial phase of a tick: applies the changes computed by update()
+	 * to the shared world state and pops completed actions.
+	 * called for all units in ascending id order.
+	 */
+	bool apply();
+
+	/**
+	 * checks whether updating this unit would change nothing,
+	 * because its active action does not depend on time and it is not moving.
+	 * such units are not updated until they are woken again.
 	 */
-	bool update();
+	bool can_sleep();
 
 	/**
 	 * draw this object using the action currently on top of the stack
@@ -70,9 +92,10 @@ public:
 
 	/**
 	 * adds a new action on top of the action stack
-	 * will be performed immediately
+	 * will be performed immediately, wakes the unit if it is sleeping.
+	 * a full stack drops its oldest interruptible action first
 	 */
-	void push_action(std::unique_ptr<UnitAction>);
+	void push_action(action_ptr action);
 
 	/**
 	 * give a new attribute this this unit
@@ -125,7 +148,7 @@ private:
 	/**
 	 * action stack -- top action determines graphic to be drawn
 	 */
-	std::vector<std::unique_ptr<UnitAction>> action_stack;
+	ActionStack action_stack;
 
 	/**
 	 * Unit attributes include color, hitpoints, speed, objects garrisoned etc
@@ -138,10 +161,22 @@ private:
 	 */
 	bool pop_destructables;
 
+	/**
+	 * the action that was updated in the parallel phase of this tick,
+	 * its changes are applied in the serial phase
+	 */
+	UnitAction *updated_action;
+
+	/**
+	 * the unit is not updated on ticks until it is woken,
+	 * managed by the container
+	 */
+	bool sleeping;
+
 	/**
 	 * the container that updates this unit
 	 */
-	const UnitContainer *container;
+	UnitContainer *container;
 
 	/**
 	 * removes all actions above and including the first interuptable action
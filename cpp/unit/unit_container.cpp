@@ -1,5 +1,10 @@
 // Copyright 2014-2014 the openage authors. See copying.md for legal info.
 
+#include <algorithm>
+#include <iterator>
+
+#include "../engine.h"
+#include "../job/job_manager.h"
 #include "../terrain/terrain_object.h"
 #include "unit_container.h"
 #include "../util/unique.h"
@@ -63,6 +68,7 @@ bool UnitContainer::new_unit(UnitProducer& producer, Terrain *terrain,
 	if (placed) {
 		producer.initialise(newobj.get());
 		auto id = newobj->id;
+		this->active_units.push_back(newobj.get());
 		this->live_units.emplace(id, std::move(newobj));
 	}
 	return placed;
@@ -72,22 +78,90 @@ bool dispatch_command(id_t, const Command &) {
 	return true;
 }
 
+void UnitContainer::wake(Unit *unit) {
+	std::lock_guard<std::mutex> lock{this->wake_mutex};
+	if (unit->sleeping) {
+		unit->sleeping = false;
+		this->woken_units.push_back(unit);
+	}
+}
+
+size_t UnitContainer::active_count() const {
+	return this->active_units.size();
+}
+
+void UnitContainer::activate_woken() {
+	if (this->woken_units.empty()) {
+		return;
+	}
+
+	auto by_id = [](Unit *a, Unit *b) {
+		return a->id < b->id;
+	};
+	std::sort(std::begin(this->woken_units), std::end(this->woken_units), by_id);
+
+	this->merge_buffer.clear();
+	std::merge(std::begin(this->active_units), std::end(this->active_units),
+	           std::begin(this->woken_units), std::end(this->woken_units),
+	           std::back_inserter(this->merge_buffer), by_id);
+	std::swap(this->active_units, this->merge_buffer);
+	this->woken_units.clear();
+}
+
 bool UnitContainer::on_tick() {
-	// update everything and find objects with no actions
+	Engine &engine = Engine::get();
+	this->update_units(engine.simulation_tick_msec(), engine.get_job_manager());
+	return true;
+}
+
+void UnitContainer::update_units(unsigned int time, job::JobManager *jobs) {
+	this->activate_woken();
+
+	// units spawned while this tick is applied get updated on the next one
+	size_t count = this->active_units.size();
+
+	// parallel phase, each unit only modifies itself
+	jobs->parallel_for(count, [this, time](size_t i) {
+		this->active_units[i]->update(time);
+	});
+
+	// serial phase, apply all changes in id order and find objects with no actions
 	std::vector<id_t> to_remove;
-	for (auto &obj : this->live_units) {
-		obj.second->update();
-		if ( !obj.second->has_action() ) {
-			to_remove.push_back(obj.first);
+	for (size_t i = 0; i < count; i++) {
+		Unit *unit = this->active_units[i];
+		unit->apply();
+		if (!unit->has_action()) {
+			to_remove.push_back(unit->id);
 		}
 	}
 
+	// drop removed units from the active set, and let idle ones sleep.
+	// both lists are sorted by id
+	auto next_removal = std::begin(to_remove);
+	auto position_it = std::remove_if(
+		std::begin(this->active_units),
+		std::end(this->active_units),
+		[&](Unit *u) {
+			if (next_removal != std::end(to_remove) && *next_removal == u->id) {
+				++next_removal;
+				return true;
+			}
+			if (u->can_sleep()) {
+				u->sleeping = true;
+				return true;
+			}
+			return false;
+		});
+	this->active_units.erase(position_it, std::end(this->active_units));
+
 	// cleanup and removal of objects
 	for (auto &obj : to_remove) {
-		this->live_units[obj]->location->remove();
+		TerrainObject *location = this->live_units[obj]->location;
+		if (location) {
+			location->remove();
+		}
 		this->live_units.erase(obj);
 	}
-	return true;
 }
 
 } // namespace openage
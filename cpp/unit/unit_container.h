@@ -4,13 +4,19 @@
 #define OPENAGE_UNIT_UNIT_CONTAINER_H_
 
 #include <memory>
+#include <mutex>
 #include <unordered_map>
+#include <vector>
 
 #include "../coord/tile.h"
 #include "../handlers.h"
 
 namespace openage {
 
+namespace job {
+class JobManager;
+}
+
 class Command;
 class Terrain;
 class Unit;
@@ -62,12 +68,43 @@ public:
 	bool dispatch_command(id_t to_id, const Command &cmd);
 
 	/**
-	 * update dispatched by the game engine
-	 * this will update all game objects
+	 * puts a sleeping unit back into the set of units updated each tick,
+	 * starting with the next tick. does nothing if the unit is awake.
+	 * may be called while units are updated in parallel.
+	 */
+	void wake(Unit *unit);
+
+	/**
+	 * number of units that are updated each tick
+	 */
+	size_t active_count() const;
+
+	/**
+	 * update dispatched by the game engine on each simulation tick
+	 * this will update all game objects by the fixed tick length
+	 *
+	 * units compute their next step in parallel on the job manager,
+	 * afterwards moves, deaths and spawns are applied serially
+	 * in ascending unit id order, so the result does not depend
+	 * on thread scheduling
+	 *
+	 * only awake units are updated, units that can sleep
+	 * are put to sleep at the end of the tick
 	 */
 	bool on_tick();
 
+	/**
+	 * advances all awake units by the given time,
+	 * distributing their updates over the given job manager
+	 */
+	void update_units(unsigned int time, job::JobManager *jobs);
+
 private:
+	/**
+	 * moves the woken units into the active set
+	 */
+	void activate_woken();
+
 	uint next_new_id;
 
 	/**
@@ -75,6 +112,23 @@ private:
 	 */
 	std::unordered_map<id_t, std::unique_ptr<Unit>> live_units;
 
+	/**
+	 * all awake units in ascending id order, these are updated each tick.
+	 * ids are never reused so new units are appended
+	 */
+	std::vector<Unit *> active_units;
+
+	/**
+	 * units woken since the last tick, guarded by wake_mutex
+	 */
+	std::vector<Unit *> woken_units;
+	std::mutex wake_mutex;
+
+	/**
+	 * buffer for merging the woken units into the active ones
+	 */
+	std::vector<Unit *> merge_buffer;
+
 };
 
 } // namespace openage
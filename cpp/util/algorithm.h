@@ -2,6 +2,9 @@
 #ifndef OPENAGE_UTIL_ALGORITHM_H_
 #define OPENAGE_UTIL_ALGORITHM_H_
 #include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
 //TODO: make general transformation from
 //iterator algorithm to container algorithm
 //so much metaprogramming...
@@ -26,6 +29,52 @@ inline void remove_from(Container& container, Function&& func){
 	                               std::forward<Function>(func)));
 }
 
+/**
+ * stable lsd radix sort of items by an unsigned 64 bit key.
+ *
+ * tmp is scratch space, keep it around between calls to avoid
+ * allocations. the byte positions where all keys are equal are skipped,
+ * so small key ranges need few passes.
+ */
+template<class T, class KeyFunction>
+void radix_sort(std::vector<T> *items, std::vector<T> *tmp, KeyFunction &&key) {
+	size_t count = items->size();
+	if (count < 2) {
+		return;
+	}
+
+	// histograms of all 8 key bytes in one pass
+	size_t histogram[8][256] = {};
+	for (auto &item : *items) {
+		uint64_t k = key(item);
+		for (int b = 0; b < 8; b++) {
+			histogram[b][(k >> (b * 8)) & 0xff] += 1;
+		}
+	}
+
+	tmp->resize(count);
+	for (int b = 0; b < 8; b++) {
+		size_t *hist = histogram[b];
+
+		// all keys have the same byte here
+		uint64_t first_byte = (key((*items)[0]) >> (b * 8)) & 0xff;
+		if (hist[first_byte] == count) {
+			continue;
+		}
+
+		size_t offset = 0;
+		for (int i = 0; i < 256; i++) {
+			size_t c = hist[i];
+			hist[i] = offset;
+			offset += c;
+		}
+
+		for (auto &item : *items) {
+			(*tmp)[hist[(key(item) >> (b * 8)) & 0xff]++] = item;
+		}
+		items->swap(*tmp);
+	}
+}
 
 } //namespace util
 } //namespace openage
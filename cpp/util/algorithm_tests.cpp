@@ -0,0 +1,75 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "algorithm.h"
+#include "../log.h"
+
+namespace openage {
+namespace util {
+namespace tests {
+
+/**
+ * compares the radix sort with std::stable_sort.
+ */
+void radix_sort() {
+	int stage = 0;
+
+	struct item {
+		uint64_t key;
+		size_t seq;
+	};
+	auto key = [](const item &i) { return i.key; };
+	auto less = [](const item &a, const item &b) { return a.key < b.key; };
+
+	std::vector<item> items, expected, tmp;
+
+	// few distinct keys, so stability matters,
+	// spread over several bytes, so passes are skipped and used.
+	uint32_t state = 42;
+	for (size_t i = 0; i < 5000; i++) {
+		state = state * 1103515245 + 12345;
+		uint64_t k = (state >> 16) % 37;
+		items.push_back({(k << 40) | (k * 3 % 5), i});
+	}
+	expected = items;
+	std::stable_sort(expected.begin(), expected.end(), less);
+
+	util::radix_sort(&items, &tmp, key);
+	for (size_t i = 0; i < items.size(); i++) {
+		if (items[i].key != expected[i].key or items[i].seq != expected[i].seq) { goto out; }
+	}
+	stage += 1;
+
+	// all equal keys keep their order
+	for (auto &i : items) {
+		i.key = 7;
+	}
+	expected = items;
+	util::radix_sort(&items, &tmp, key);
+	for (size_t i = 0; i < items.size(); i++) {
+		if (items[i].seq != expected[i].seq) { goto out; }
+	}
+	stage += 1;
+
+	// full range keys
+	items.clear();
+	items.push_back({UINT64_MAX, 0});
+	items.push_back({0, 1});
+	items.push_back({UINT64_MAX - 1, 2});
+	items.push_back({1ull << 63, 3});
+	util::radix_sort(&items, &tmp, key);
+	if (items[0].seq != 1 or items[1].seq != 3 or items[2].seq != 2 or items[3].seq != 0) { goto out; }
+
+	return;
+
+out:
+	log::err("radix sort test failed at stage %d", stage);
+	throw "radix sort test failed";
+}
+
+} //namespace tests
+} //namespace util
+} //namespace openage
@@ -0,0 +1,44 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#include "fixed_timestep.h"
+
+namespace openage {
+namespace util {
+
+FixedTimestep::FixedTimestep(unsigned int tick_msec, unsigned int max_ticks)
+	:
+	tick_msec{tick_msec},
+	max_ticks{max_ticks},
+	tick_count{0},
+	dropped_msec{0},
+	accumulated_msec{0},
+	previous_msec{0} {
+}
+
+unsigned int FixedTimestep::advance(unsigned int msec) {
+	this->previous_msec = this->accumulated_msec;
+	this->accumulated_msec += msec;
+
+	unsigned int ticks = this->accumulated_msec / this->tick_msec;
+	this->accumulated_msec -= ticks * this->tick_msec;
+
+	if (ticks > this->max_ticks) {
+		// we can't keep up, slow down the simulation instead
+		this->dropped_msec += (ticks - this->max_ticks) * this->tick_msec;
+		ticks = this->max_ticks;
+	}
+
+	this->tick_count += ticks;
+	return ticks;
+}
+
+float FixedTimestep::fraction() const {
+	return static_cast<float>(this->accumulated_msec) / this->tick_msec;
+}
+
+float FixedTimestep::previous_fraction() const {
+	return static_cast<float>(this->previous_msec) / this->tick_msec;
+}
+
+} //namespace util
+} //namespace openage
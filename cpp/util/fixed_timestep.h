@@ -0,0 +1,72 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#ifndef OPENAGE_UTIL_FIXED_TIMESTEP_H_
+#define OPENAGE_UTIL_FIXED_TIMESTEP_H_
+
+#include <stdint.h>
+
+namespace openage {
+namespace util {
+
+/**
+ * clock for a simulation that advances in steps of constant length,
+ * independent of how long the rendered frames take.
+ *
+ * the real time that passed is accumulated, and each frame runs as many
+ * fixed ticks as fit into it. the remainder is carried over to the next
+ * frame and can be used to interpolate between the last two ticks.
+ */
+class FixedTimestep {
+public:
+	/**
+	 * @param tick_msec simulated milliseconds per tick
+	 * @param max_ticks maximum number of ticks to catch up in one frame,
+	 *        time beyond that is dropped so a slow frame can't
+	 *        cause an ever growing backlog.
+	 */
+	FixedTimestep(unsigned int tick_msec, unsigned int max_ticks);
+
+	/**
+	 * add the real time that passed since the last call.
+	 * @returns the number of ticks to simulate now
+	 */
+	unsigned int advance(unsigned int msec);
+
+	/**
+	 * progress from the last tick towards the next one, in [0, 1).
+	 */
+	float fraction() const;
+
+	/**
+	 * the fraction before the time of the last advance() was added.
+	 *
+	 * a state that lags one advance() behind, like a simulation that
+	 * runs its ticks while the previous frame is drawn, has to be
+	 * interpolated with this instead of fraction().
+	 */
+	float previous_fraction() const;
+
+	/** simulated milliseconds per tick */
+	const unsigned int tick_msec;
+
+	/** catch-up limit per frame */
+	const unsigned int max_ticks;
+
+	/** number of ticks simulated so far */
+	uint64_t tick_count;
+
+	/** real milliseconds that were dropped by the catch-up limit */
+	uint64_t dropped_msec;
+
+private:
+	/** real time not yet consumed by a tick */
+	unsigned int accumulated_msec;
+
+	/** accumulated_msec before the last advance() */
+	unsigned int previous_msec;
+};
+
+} //namespace util
+} //namespace openage
+
+#endif
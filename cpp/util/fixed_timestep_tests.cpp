@@ -0,0 +1,100 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#include "fixed_timestep.h"
+#include "../log.h"
+
+namespace openage {
+namespace util {
+namespace tests {
+
+/**
+ * checks the ticks run per frame, the catch-up limit and the fraction
+ * of the fixed timestep clock.
+ */
+void fixed_timestep() {
+	int stage = 0;
+
+	FixedTimestep clock{50, 5};
+	uint32_t state = 7;
+
+	// the remainder of a frame is carried over to the next one
+	if (clock.advance(120) != 2) { goto out; }
+	if (clock.fraction() != 0.4f) { goto out; }
+	if (clock.advance(30) != 1) { goto out; }
+	if (clock.fraction() != 0.0f) { goto out; }
+	if (clock.advance(49) != 0) { goto out; }
+	if (clock.tick_count != 3 or clock.dropped_msec != 0) { goto out; }
+	stage += 1;
+
+	// a long frame runs max_ticks, the rest of its whole ticks is dropped
+	if (clock.advance(1011) != 5) { goto out; }
+	if (clock.tick_count != 8) { goto out; }
+	if (clock.dropped_msec != 16 * 50) { goto out; }
+	if (clock.fraction() != 10 / 50.0f) { goto out; }
+	stage += 1;
+
+	// the fraction stays in [0, 1) for any frame time
+	for (int i = 0; i < 10000; i++) {
+		state = state * 1103515245 + 12345;
+		clock.advance((state >> 16) % 400);
+		float fraction = clock.fraction();
+		if (fraction < 0 or fraction >= 1) { goto out; }
+	}
+
+	return;
+
+out:
+	log::err("fixed timestep test failed at stage %d", stage);
+	throw "fixed timestep test failed";
+}
+
+/**
+ * draws a unit moving on every tick like the engine loop, with the ticks
+ * run before recording the frame, and pipelined after it. the interpolated
+ * position must never move backwards.
+ */
+void fixed_timestep_interpolation() {
+	int stage = 0;
+
+	for (int pipelined = 0; pipelined < 2; pipelined++) {
+		FixedTimestep clock{50, 5};
+		uint32_t state = 3;
+		int64_t pos = 0, last_tick_pos = 0;
+		float drawn = 0;
+
+		auto simulate = [&](unsigned int ticks) {
+			for (unsigned int i = 0; i < ticks; i++) {
+				last_tick_pos = pos;
+				pos += 1000;
+			}
+		};
+
+		for (int frame = 0; frame < 10000; frame++) {
+			state = state * 1103515245 + 12345;
+			unsigned int ticks = clock.advance((state >> 16) % 300);
+			if (not pipelined) {
+				simulate(ticks);
+			}
+
+			float fraction = pipelined ? clock.previous_fraction() : clock.fraction();
+			float pos_drawn = last_tick_pos + (pos - last_tick_pos) * fraction;
+			if (pos_drawn < drawn) { goto out; }
+			drawn = pos_drawn;
+
+			if (pipelined) {
+				simulate(ticks);
+			}
+		}
+		stage += 1;
+	}
+
+	return;
+
+out:
+	log::err("fixed timestep interpolation test failed at stage %d", stage);
+	throw "fixed timestep interpolation test failed";
+}
+
+} //namespace tests
+} //namespace util
+} //namespace openage
@@ -0,0 +1,61 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#include "mapped_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "error.h"
+
+namespace openage {
+namespace util {
+
+MappedFile::MappedFile(const std::string &filename)
+	:
+	mapping{nullptr},
+	length{0} {
+
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0) {
+		throw Error{"failed opening file %s", filename.c_str()};
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) < 0) {
+		close(fd);
+		throw Error{"failed reading the size of %s", filename.c_str()};
+	}
+	this->length = st.st_size;
+
+	// mapping 0 bytes is invalid, an empty file just has no data
+	if (this->length > 0) {
+		this->mapping = mmap(nullptr, this->length, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (this->mapping == MAP_FAILED) {
+			this->mapping = nullptr;
+			close(fd);
+			throw Error{"failed mapping file %s", filename.c_str()};
+		}
+	}
+
+	// the mapping stays valid without the descriptor
+	close(fd);
+}
+
+MappedFile::~MappedFile() {
+	if (this->mapping != nullptr) {
+		munmap(this->mapping, this->length);
+	}
+}
+
+const void *MappedFile::data() const {
+	return this->mapping;
+}
+
+size_t MappedFile::size() const {
+	return this->length;
+}
+
+} //namespace util
+} //namespace openage
@@ -0,0 +1,39 @@
+// Copyright 2014-2014 the openage authors. See copying.md for legal info.
+
+#ifndef OPENAGE_UTIL_MAPPED_FILE_H_
+#define OPENAGE_UTIL_MAPPED_FILE_H_
+
+#include <cstddef>
+#include <string>
+
+namespace openage {
+namespace util {
+
+/**
+ * a file mapped read-only into memory.
+ * the pages are only read from disk when they are accessed,
+ * and are shared with the kernel's file cache.
+ */
+class MappedFile {
+public:
+	/**
+	 * map the whole file, throws util::Error if that fails.
+	 */
+	MappedFile(const std::string &filename);
+	~MappedFile();
+
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator =(const MappedFile &) = delete;
+
+	const void *data() const;
+	size_t size() const;
+
+private:
+	void *mapping;
+	size_t length;
+};
+
+} //namespace util
+} //namespace openage
+
+#endif